@@ -1,15 +1,22 @@
 // avatar.vert
 
-attribute vec4 vPosition;
-attribute vec4 vColor;
+#version 140
 
-varying vec3 vfColor;
+in vec4 vPosition;
+in vec4 vColor;
 
-uniform mat4 mvmtx;
-uniform mat4 prmtx;
+out vec3 vfColor;
+
+layout(std140) uniform Camera
+{
+    mat4 mvmtx;
+    mat4 prmtx;
+};
+
+uniform mat4 mdlmtx;
 
 void main()
 {
     vfColor = vColor.xyz;
-    gl_Position = prmtx * mvmtx * vPosition;
-}
\ No newline at end of file
+    gl_Position = prmtx * mvmtx * mdlmtx * vPosition;
+}
@@ -1,8 +1,11 @@
 // basic.frag
 
-varying vec3 vfColor;
+#version 140
+
+in vec3 vfColor;
+out vec4 FragColor;
 
 void main()
 {
-    gl_FragColor = vec4(vfColor, 1.0);
-} 
\ No newline at end of file
+    FragColor = vec4(vfColor, 1.0);
+}
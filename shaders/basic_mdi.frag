@@ -0,0 +1,11 @@
+// basic_mdi.frag
+
+#version 430
+
+in vec3 vfColor;
+out vec4 FragColor;
+
+void main()
+{
+    FragColor = vec4(vfColor, 1.0);
+}
@@ -0,0 +1,30 @@
+// basic_mdi.vert
+// basic.vert for multi-draw indirect: the model matrix comes from the
+// transform buffer, indexed by the draw's id. Each indirect command sets its
+// base instance to its own index, which the instanced vDrawId attribute
+// passes through.
+
+#version 430
+
+layout(location = 0) in vec4 vPosition;
+layout(location = 1) in vec4 vColor;
+layout(location = 2) in uint vDrawId;
+
+layout(std430, binding = 0) readonly buffer DrawTransforms
+{
+    mat4 mdlmtx[];
+};
+
+out vec3 vfColor;
+
+layout(std140) uniform Camera
+{
+    mat4 mvmtx;
+    mat4 prmtx;
+};
+
+void main()
+{
+    vfColor = vColor.xyz;
+    gl_Position = prmtx * mvmtx * mdlmtx[vDrawId] * vPosition;
+}
@@ -2,7 +2,7 @@
 // Apply a simple black and white checkerboard pattern to a quad
 // with texture coordinates in the unit interval.
 
-#version 130
+#version 140
 
 in vec2 vfTexCoord;
 out vec4 FragColor;
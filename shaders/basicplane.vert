@@ -1,17 +1,22 @@
 // basicplane.vert
 
-#version 130
+#version 140
 
 in vec3 vPosition;
 in vec2 vTexCoord;
 
 out vec2 vfTexCoord;
 
-uniform mat4 mvmtx;
-uniform mat4 prmtx;
+layout(std140) uniform Camera
+{
+    mat4 mvmtx;
+    mat4 prmtx;
+};
+
+uniform mat4 mdlmtx;
 
 void main()
 {
     vfTexCoord = vTexCoord;
-    gl_Position = prmtx * mvmtx * vec4(vPosition, 1.0);
+    gl_Position = prmtx * mvmtx * mdlmtx * vec4(vPosition, 1.0);
 }
@@ -0,0 +1,27 @@
+// basicplane_mdi.vert
+// basicplane.vert for multi-draw indirect; see basic_mdi.vert.
+
+#version 430
+
+layout(location = 0) in vec3 vPosition;
+layout(location = 1) in vec2 vTexCoord;
+layout(location = 2) in uint vDrawId;
+
+layout(std430, binding = 0) readonly buffer DrawTransforms
+{
+    mat4 mdlmtx[];
+};
+
+out vec2 vfTexCoord;
+
+layout(std140) uniform Camera
+{
+    mat4 mvmtx;
+    mat4 prmtx;
+};
+
+void main()
+{
+    vfTexCoord = vTexCoord;
+    gl_Position = prmtx * mvmtx * mdlmtx[vDrawId] * vec4(vPosition, 1.0);
+}
@@ -3,12 +3,22 @@
 #include "Draw_Helpers.h"
 #include "VectorMath.h"
 
-#include <GL/glew.h>
+static void WriteLines(LineVertex* pVerts, const float3* pPos, const float3* pCol, const unsigned int* pLines, int lineVerts)
+{
+    for (int i=0; i<lineVerts; ++i)
+    {
+        const float3& p = pPos[pLines[i]];
+        const float3& c = pCol[pLines[i]];
+        LineVertex& v = pVerts[i];
+        v.pos[0] = p.x; v.pos[1] = p.y; v.pos[2] = p.z;
+        v.col[0] = c.x; v.col[1] = c.y; v.col[2] = c.z;
+    }
+}
 
-void DrawOriginLines()
+/// Colored line segments along unit x,y,z axes.
+///@return The number of vertices written, OriginLineVertices
+int WriteOriginLines(LineVertex* pVerts)
 {
-    const float3 minPt = {0,0,0};
-    const float3 maxPt = {1,1,1};
     const float3 verts[] = {
         {0,0,0},
         {1,0,0},
@@ -21,26 +31,18 @@ void DrawOriginLines()
         0,3,
     };
 
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, verts);
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 0, verts);
-    glEnableVertexAttribArray(0);
-    glEnableVertexAttribArray(1);
-
-    glDrawElements(GL_LINES,
-                   3*2,
-                   GL_UNSIGNED_INT,
-                   &lines[0]);
+    WriteLines(pVerts, verts, verts, lines, OriginLineVertices);
+    return OriginLineVertices;
 }
 
 
-/// Draw a frustum oriented facing along negative z.
-void DrawViewFrustum(float aspect)
+/// A frustum oriented facing along negative z.
+///@return The number of vertices written, ViewFrustumLineVertices
+int WriteViewFrustum(LineVertex* pVerts, float aspect)
 {
     const float3 forward = {0,0,-1};
     const float3 up = {0,1,0};
     const float3 right = {1,0,0};
-    const float forwardLength = 1.0f;
 
     const float3 origin = {0,0,0};
     const float xoff = 0.8f;
@@ -71,15 +73,6 @@ void DrawViewFrustum(float aspect)
         4,1,
     };
 
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, verts);
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 0, cols);
-    glEnableVertexAttribArray(0);
-    glEnableVertexAttribArray(1);
-
-    glDrawElements(GL_LINES,
-                   sizeof(lines)/sizeof(lines[0]),
-                   GL_UNSIGNED_INT,
-                   &lines[0]);
+    WriteLines(pVerts, verts, cols, lines, ViewFrustumLineVertices);
+    return ViewFrustumLineVertices;
 }
-
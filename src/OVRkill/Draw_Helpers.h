@@ -2,5 +2,18 @@
 
 #pragma once
 
-void DrawOriginLines();
-void DrawViewFrustum(float aspect);
+/// Interleaved for GL_LINES: attribute 0 is the position, 1 the color.
+struct LineVertex
+{
+    float pos[3];
+    float col[3];
+};
+
+enum
+{
+    OriginLineVertices = 3*2,
+    ViewFrustumLineVertices = 8*2
+};
+
+int WriteOriginLines(LineVertex* pVerts);
+int WriteViewFrustum(LineVertex* pVerts, float aspect);
@@ -0,0 +1,27 @@
+// HmdBackend.h
+
+#pragma once
+
+#include "OVR.h"
+
+///@brief Source of HMD display parameters and head orientation for OVRkill.
+/// The OVR SDK device is one implementation; SimulatedHmd stands in when no
+/// headset is attached so the sensor path can run without hardware.
+class HmdBackend
+{
+public:
+    virtual ~HmdBackend() {}
+
+    /// Returns false if no device is available.
+    virtual bool Init() = 0;
+    virtual void Shutdown() = 0;
+    virtual const char* GetName() const = 0;
+
+    /// Returns false if the backend has no display parameters to offer.
+    virtual bool GetHMDInfo(OVR::HMDInfo& info) const = 0;
+
+    virtual bool SensorActive() const = 0;
+
+    ///@param pSampleNs If non-NULL, receives the HighResClock time the orientation was sampled.
+    virtual OVR::Quatf GetOrientation(unsigned long long* pSampleNs) const = 0;
+};
@@ -2,6 +2,8 @@
 
 #include <GL/glew.h>
 #include "OVRkill.h"
+#include "OvrHmdBackend.h"
+#include "SimulatedHmd.h"
 #include "OVR_Shaders.h"
 #include "GL/ShaderFunctions.h"
 
@@ -53,65 +55,70 @@ GLuint BuildShader(const char* pVertSrc, const char* pFragSrc)
 ///@note Remember that initialization here depends on GL context state.
 /// Shaders and buffers are created later.
 OVRkill::OVRkill()
-: m_pManager(NULL)
-, m_pHMD(NULL)
-, m_pSensor(NULL)
-, m_pSFusion(NULL)
+: m_pBackend(NULL)
 , m_HMDInfo()
 , m_SConfig()
 , m_fboWidth(0)
 , m_fboHeight(0)
-, m_progRiftDistortion(0)
-, m_progPresFbo(0)
 , m_windowWidth(0)
 , m_windowHeight(0)
 {
+    for (int i=0; i<MaxContexts; ++i)
+    {
+        m_renderBuffers[i].id = 0;
+        m_renderBuffers[i].tex = 0;
+        m_renderBuffers[i].depth = 0;
+        m_renderBuffers[i].w = 0;
+        m_renderBuffers[i].h = 0;
+        m_progRiftDistortion[i] = 0;
+        m_progPresFbo[i] = 0;
+    }
 }
 
 OVRkill::~OVRkill()
 {
-    //if (m_pSFusion)
-    //    delete m_pSFusion;
     DestroyOVR();
 }
 
-OVR::Quatf OVRkill::GetOrientation() const
+OVR::Quatf OVRkill::GetOrientation(unsigned long long* pSampleNs) const
 {
-    if (m_pSFusion == NULL)
+    if (m_pBackend == NULL)
         return OVR::Quatf();
-    return m_pSFusion->GetOrientation();
+    return m_pBackend->GetOrientation(pSampleNs);
 }
 
 void OVRkill::DestroyOVR()
 {
-    // Clear these before calling Destroy.
-    m_pSensor.Clear();
-    m_pManager.Clear();
-    m_pHMD.Clear();
-    // No OVR functions involving memory are allowed after this.
-    OVR::System::Destroy();
+    delete m_pBackend;
+    m_pBackend = NULL;
 }
 
-/// We need an active GL context for this
-void OVRkill::CreateShaders()
+/// We need an active GL context for this: the one that will present with them.
+void OVRkill::CreateShaders(int context)
 {
-    m_progPresFbo        = BuildShader(PresentFboVertSrc         , PresentFboFragSrc);
-    m_progRiftDistortion = BuildShader(PostProcessVertexShaderSrc, PostProcessFragShaderSrc);
+    m_progPresFbo[context]        = BuildShader(PresentFboVertSrc         , PresentFboFragSrc);
+    m_progRiftDistortion[context] = BuildShader(PostProcessVertexShaderSrc, PostProcessFragShaderSrc);
 }
 
-/// We need an active GL context for this
-void OVRkill::CreateRenderBuffer(float bufferScaleUp)
+/// We need an active GL context for this. Framebuffer objects are not shared
+/// between contexts, so each context allocates and binds its own.
+///@param resolutionScale Further reduction for this context only; the size
+/// reported by GetRenderBufferWidth/Height leaves it out.
+void OVRkill::CreateRenderBuffer(float bufferScaleUp, int context, float resolutionScale)
 {
-    deallocateFBO(m_renderBuffer);
+    FBO& fbo = m_renderBuffers[context];
+    deallocateFBO(fbo);
 
     m_fboWidth = (int)((bufferScaleUp) * (float)m_windowWidth );
     m_fboHeight = (int)((bufferScaleUp) * (float)m_windowHeight );
-    allocateFBO(m_renderBuffer, m_fboWidth, m_fboHeight);
+    allocateFBO(fbo,
+        (int)(resolutionScale * (float)m_fboWidth),
+        (int)(resolutionScale * (float)m_fboHeight));
 }
 
-void OVRkill::BindRenderBuffer() const
+void OVRkill::BindRenderBuffer(int context) const
 {
-    bindFBO(m_renderBuffer);
+    bindFBO(m_renderBuffers[context]);
 }
 
 void OVRkill::UnBindRenderBuffer() const
@@ -119,18 +126,21 @@ void OVRkill::UnBindRenderBuffer() const
     unbindFBO();
 }
 
-void OVRkill::PresentFbo_NoDistortion() const
+void OVRkill::PresentFbo_NoDistortion(int context) const
 {
-    glUseProgram(m_progPresFbo);
+    const FBO& fbo = m_renderBuffers[context];
+    const float fboWidth = (float)fbo.w;
+    const float fboHeight = (float)fbo.h;
+    glUseProgram(m_progPresFbo[context]);
     {
-        OVR::Matrix4f ortho = OVR::Matrix4f::Ortho2D((float)m_fboWidth, (float)m_fboHeight);
-        glUniformMatrix4fv(getUniLoc(m_progPresFbo, "prmtx"), 1, false, &ortho.Transposed().M[0][0]);
+        OVR::Matrix4f ortho = OVR::Matrix4f::Ortho2D(fboWidth, fboHeight);
+        glUniformMatrix4fv(getUniLoc(m_progPresFbo[context], "prmtx"), 1, false, &ortho.Transposed().M[0][0]);
 
         const float verts[] = {
-            0                ,  0,
-            (float)m_fboWidth,  0,
-            (float)m_fboWidth, (float)m_fboHeight,
-            0                , (float)m_fboHeight,
+            0       ,  0,
+            fboWidth,  0,
+            fboWidth, fboHeight,
+            0       , fboHeight,
         };
         const float texs[] = {
             0,1,
@@ -144,8 +154,8 @@ void OVRkill::PresentFbo_NoDistortion() const
 
         glBindBuffer(GL_ARRAY_BUFFER, 0);
         
-        int posAttrib =  glGetAttribLocation(m_progPresFbo, "vPosition");
-        int texAttrib =  glGetAttribLocation(m_progPresFbo, "vTex");
+        int posAttrib =  glGetAttribLocation(m_progPresFbo[context], "vPosition");
+        int texAttrib =  glGetAttribLocation(m_progPresFbo[context], "vTex");
         
         glVertexAttribPointer(posAttrib, 2, GL_FLOAT, GL_FALSE, 0, verts);
         glVertexAttribPointer(texAttrib, 2, GL_FLOAT, GL_FALSE, 0, texs);
@@ -153,8 +163,8 @@ void OVRkill::PresentFbo_NoDistortion() const
         glEnableVertexAttribArray(texAttrib);
 
         glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, m_renderBuffer.tex);
-        glUniform1i(getUniLoc(m_progPresFbo, "fboTex"), 0);
+        glBindTexture(GL_TEXTURE_2D, m_renderBuffers[context].tex);
+        glUniform1i(getUniLoc(m_progPresFbo[context], "fboTex"), 0);
 
         glDrawElements(GL_TRIANGLES,
                        6,
@@ -169,18 +179,19 @@ void OVRkill::PresentFbo_NoDistortion() const
 
 void OVRkill::PresentFbo_PostProcessDistortion(
     const OVR::Util::Render::StereoEyeParams& eyeParams,
-    const RiftDistortionParams& distParams) const
+    const RiftDistortionParams& distParams,
+    int context) const
 {
     const OVR::Util::Render::DistortionConfig*  pDistortion = eyeParams.pDistortion;
     if (pDistortion == NULL)
         return;
 
-    glUseProgram(m_progRiftDistortion);
+    glUseProgram(m_progRiftDistortion[context]);
     {
         // Set uniforms for distortion shader
         OVR::Matrix4f ident;
-        glUniformMatrix4fv(getUniLoc(m_progRiftDistortion, "View"), 1, false, &ident.Transposed().M[0][0]);
-        glUniformMatrix4fv(getUniLoc(m_progRiftDistortion, "Texm"), 1, false, &ident.Transposed().M[0][0]);
+        glUniformMatrix4fv(getUniLoc(m_progRiftDistortion[context], "View"), 1, false, &ident.Transposed().M[0][0]);
+        glUniformMatrix4fv(getUniLoc(m_progRiftDistortion[context], "Texm"), 1, false, &ident.Transposed().M[0][0]);
 
         //"uniform vec2 LensCenter;\n"
         //"uniform vec2 ScreenCenter;\n"
@@ -189,29 +200,29 @@ void OVRkill::PresentFbo_PostProcessDistortion(
         //"uniform vec4 HmdWarpParam;\n"
 
         // The left screen is centered at (0.25, 0.5)
-        glUniform2f(getUniLoc(m_progRiftDistortion, "LensCenter"),
+        glUniform2f(getUniLoc(m_progRiftDistortion[context], "LensCenter"),
             distParams.LensCenterX + distParams.lensOff, distParams.LensCenterY);
 
-        glUniform2f(getUniLoc(m_progRiftDistortion, "ScreenCenter"),
+        glUniform2f(getUniLoc(m_progRiftDistortion[context], "ScreenCenter"),
             distParams.ScreenCenterX, distParams.ScreenCenterY);
 
         // The right screen is centered at (0.75, 0.5)
         if (eyeParams.Eye == OVR::Util::Render::StereoEye_Right)
         {
-            glUniform2f(getUniLoc(m_progRiftDistortion, "LensCenter"),
+            glUniform2f(getUniLoc(m_progRiftDistortion[context], "LensCenter"),
                 1.0f - (distParams.LensCenterX + distParams.lensOff), distParams.LensCenterY);
 
-            glUniform2f(getUniLoc(m_progRiftDistortion, "ScreenCenter"),
+            glUniform2f(getUniLoc(m_progRiftDistortion[context], "ScreenCenter"),
                 1.0f - distParams.ScreenCenterX, distParams.ScreenCenterY);
         }
         
-        glUniform2f(getUniLoc(m_progRiftDistortion, "Scale"),
+        glUniform2f(getUniLoc(m_progRiftDistortion[context], "Scale"),
             distParams.ScaleX,  distParams.ScaleY);
 
-        glUniform2f(getUniLoc(m_progRiftDistortion, "ScaleIn"),
+        glUniform2f(getUniLoc(m_progRiftDistortion[context], "ScaleIn"),
             distParams.ScaleInX, distParams.ScaleInY);
 
-        glUniform4f(getUniLoc(m_progRiftDistortion, "HmdWarpParam"),
+        glUniform4f(getUniLoc(m_progRiftDistortion[context], "HmdWarpParam"),
             distParams.DistScale * pDistortion->K[0],
             distParams.DistScale * pDistortion->K[1],
             distParams.DistScale * pDistortion->K[2],
@@ -219,8 +230,8 @@ void OVRkill::PresentFbo_PostProcessDistortion(
         );
 
         glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, m_renderBuffer.tex);
-        glUniform1i(getUniLoc(m_progRiftDistortion, "Texture0"), 0);
+        glBindTexture(GL_TEXTURE_2D, m_renderBuffers[context].tex);
+        glUniform1i(getUniLoc(m_progRiftDistortion[context], "Texture0"), 0);
 
         float verts[] = { // Left eye coords
             -1.0f, -1.0f,
@@ -255,8 +266,8 @@ void OVRkill::PresentFbo_PostProcessDistortion(
 
         glBindBuffer(GL_ARRAY_BUFFER, 0);
         
-        int posAttrib =  glGetAttribLocation(m_progPresFbo, "vPosition");
-        int texAttrib =  glGetAttribLocation(m_progPresFbo, "vTex");
+        int posAttrib =  glGetAttribLocation(m_progPresFbo[context], "vPosition");
+        int texAttrib =  glGetAttribLocation(m_progPresFbo[context], "vTex");
         
         glVertexAttribPointer(posAttrib, 2, GL_FLOAT, GL_FALSE, 0, verts);
         glVertexAttribPointer(texAttrib, 2, GL_FLOAT, GL_FALSE, 0, texs);
@@ -274,16 +285,16 @@ void OVRkill::PresentFbo_PostProcessDistortion(
     glUseProgram(0);
 }
 
-void OVRkill::PresentFbo(PostProcessType post, const RiftDistortionParams& distParams) const
+void OVRkill::PresentFbo(PostProcessType post, const RiftDistortionParams& distParams, int context) const
 {
     if (post == PostProcess_Distortion)
     {
-        PresentFbo_PostProcessDistortion(m_LeyeParams, distParams);
-        PresentFbo_PostProcessDistortion(m_ReyeParams, distParams);
+        PresentFbo_PostProcessDistortion(m_LeyeParams, distParams, context);
+        PresentFbo_PostProcessDistortion(m_ReyeParams, distParams, context);
     }
     else
     {
-        PresentFbo_NoDistortion();
+        PresentFbo_NoDistortion(context);
     }
 }
 
@@ -293,57 +304,39 @@ void OVRkill::UpdateEyeParams()
     m_ReyeParams = m_SConfig.GetEyeRenderParams(OVR::Util::Render::StereoEye_Right);
 }
 
-/// Call OVR setup routines to get HMD info from the first available HMD.
-void OVRkill::InitOVR()
+/// Set up the HMD backend and get HMD info from it.
+///@param pBackend Device to use, owned by OVRkill from here on. If NULL, the
+/// first available Rift is used, falling back to a display-only simulated DK1.
+void OVRkill::InitOVR(HmdBackend* pBackend)
 {
-    OVR::System::Init(OVR::Log::ConfigureDefaultLog(OVR::LogMask_All));
-    m_pSFusion = new OVR::SensorFusion;
-    m_pManager = *OVR::DeviceManager::Create();
-    m_pHMD  = *m_pManager->EnumerateDevices<OVR::HMDDevice>().CreateDevice();
-    if (m_pHMD == NULL)
+    DestroyOVR();
+
+    bool useDeviceInfo = true;
+    if (pBackend == NULL)
     {
-        // These default values were copied from the Rift DK1 and will be
-        // used when no Rift is present so output looks sane.
-        OVR::HMDInfo& hmd = m_HMDInfo;
-        hmd.DesktopX = 0;
-        hmd.DesktopY = 0;
-        hmd.HResolution = 1280;
-        hmd.VResolution = 800;
-
-        hmd.HScreenSize = 0.14975999f;
-        hmd.VScreenSize = 0.093599997f;
-        hmd.VScreenCenter = 0.046799999f;
-
-        hmd.DistortionK[0] = 1.0f;
-        hmd.DistortionK[1] = 0.5f;
-        hmd.DistortionK[2] = 0.25f;
-        hmd.DistortionK[3] = 0.0f;
-
-        hmd.EyeToScreenDistance = 0.041000001f;
-        hmd.InterpupillaryDistance = 0.064f;
-        hmd.LensSeparationDistance = 0.063500002f;
+        pBackend = new OvrHmdBackend;
+        if (!pBackend->Init())
+        {
+            // No Rift present; keep the stereo config's own defaults as before.
+            delete pBackend;
+            pBackend = new SimulatedHmd(SimulatedHmdParams::DisplayOnly());
+            pBackend->Init();
+            useDeviceInfo = false;
+        }
     }
     else
     {
-        m_pSensor = *m_pHMD->GetSensor();
+        pBackend->Init();
+    }
+    m_pBackend = pBackend;
 
-        // This will initialize HMDInfo with information about configured IPD,
-        // screen size and other variables needed for correct projection.
-        // We pass HMD DisplayDeviceName into the renderer to select the
-        // correct monitor in full-screen mode.
-        if (m_pHMD->GetDeviceInfo(&m_HMDInfo))
-        {
-            m_SConfig.SetHMDInfo(m_HMDInfo);
-        }
-        if (m_pSensor)
-        {
-            // We need to attach sensor to SensorFusion object for it to receive 
-            // body frame messages and update orientation. SFusion.GetOrientation() 
-            // is used in OnIdle() to orient the view.
-            m_pSFusion->AttachToSensor(m_pSensor);
-            //SFusion.SetDelegateMessageHandler(this);
-            //SFusion.SetPredictionEnabled(true);
-        }
+    // This will initialize HMDInfo with information about configured IPD,
+    // screen size and other variables needed for correct projection.
+    // We pass HMD DisplayDeviceName into the renderer to select the
+    // correct monitor in full-screen mode.
+    if (m_pBackend->GetHMDInfo(m_HMDInfo) && useDeviceInfo)
+    {
+        m_SConfig.SetHMDInfo(m_HMDInfo);
     }
 
     if (m_HMDInfo.HResolution > 0)
@@ -4,6 +4,7 @@
 
 #include "OVR.h"
 #include "FBO.h"
+#include "HmdBackend.h"
 
 struct RiftDistortionParams
 {
@@ -34,9 +35,13 @@ struct RiftDistortionParams
 
 ///@brief The OVRkill class is instantiated once globally and exists to push as much
 /// code as possible out of the app skeleton main source file.
+///@note Each window context that presents gets its own render buffer and
+/// programs, selected by a context index; see CreateShaders.
 class OVRkill
 {
 public:
+    enum { MaxContexts = 2 };
+
     // Stereo viewing parameters
     enum PostProcessType
     {
@@ -47,32 +52,36 @@ public:
     OVRkill();
     virtual ~OVRkill();
 
-    bool       SensorActive() const { return m_pSensor != NULL; }
+    bool       SensorActive() const { return (m_pBackend != NULL) && m_pBackend->SensorActive(); }
     bool       GetStereoMode() const { return m_SConfig.GetStereoMode() == OVR::Util::Render::Stereo_LeftRight_Multipass; }
     const OVR::HMDInfo& GetHMD() const { return m_HMDInfo; }
-    OVR::Quatf GetOrientation() const;
+    OVR::Quatf GetOrientation(unsigned long long* pSampleNs=NULL) const;
+    const HmdBackend* GetBackend() const { return m_pBackend; }
 
     int GetOculusWidth() const { return m_windowWidth; }
     int GetOculusHeight() const { return m_windowHeight; }
     int GetRenderBufferWidth() const { return m_fboWidth; }
     int GetRenderBufferHeight() const { return m_fboHeight; }
+    const FBO& GetRenderBuffer(int context) const { return m_renderBuffers[context]; }
     float GetRenderBufferScaleIncrease() { return m_SConfig.GetDistortionScale(); }
 
-    void InitOVR();
+    void InitOVR(HmdBackend* pBackend=NULL);
     void DestroyOVR();
-    void CreateShaders();
-    void CreateRenderBuffer(float bufferScaleUp);
+    void CreateShaders(int context=0);
+    void CreateRenderBuffer(float bufferScaleUp, int context=0, float resolutionScale=1.0f);
     void UpdateEyeParams();
-    void BindRenderBuffer() const;
+    void BindRenderBuffer(int context=0) const;
     void UnBindRenderBuffer() const;
 
     void PresentFbo(
         PostProcessType post,
-        const RiftDistortionParams& distParams) const;
-    void PresentFbo_NoDistortion() const;
+        const RiftDistortionParams& distParams,
+        int context=0) const;
+    void PresentFbo_NoDistortion(int context=0) const;
     void PresentFbo_PostProcessDistortion(
         const OVR::Util::Render::StereoEyeParams& eyeParams,
-        const RiftDistortionParams& distParams) const;
+        const RiftDistortionParams& distParams,
+        int context=0) const;
 
     enum DisplayMode
     {
@@ -84,24 +93,21 @@ public:
     void SetDisplayMode(DisplayMode);
 
 protected:
-    // OVR hardware
-    OVR::Ptr<OVR::DeviceManager>  m_pManager;
-    OVR::Ptr<OVR::HMDDevice>      m_pHMD;
-    OVR::Ptr<OVR::SensorDevice>   m_pSensor;
-    OVR::SensorFusion*            m_pSFusion;
+    // HMD hardware, or a stand-in for it
+    HmdBackend*                   m_pBackend;
     OVR::HMDInfo                  m_HMDInfo;
 
     OVR::Util::Render::StereoEyeParams m_LeyeParams;
     OVR::Util::Render::StereoEyeParams m_ReyeParams;
     OVR::Util::Render::StereoConfig    m_SConfig;
 
-    // Render buffer for OVR distortion correction shader
-    FBO m_renderBuffer;
-    int m_fboWidth;
+    // Render buffers for OVR distortion correction shader, one per context
+    FBO m_renderBuffers[MaxContexts];
+    int m_fboWidth;  ///< Size of the most recently allocated buffer
     int m_fboHeight;
 
-    GLuint m_progRiftDistortion;
-    GLuint m_progPresFbo;
+    GLuint m_progRiftDistortion[MaxContexts];
+    GLuint m_progPresFbo[MaxContexts];
 
     int m_windowWidth;
     int m_windowHeight;
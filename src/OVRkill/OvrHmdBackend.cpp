@@ -0,0 +1,79 @@
+// OvrHmdBackend.cpp
+
+#include "OvrHmdBackend.h"
+#include "Timer.h"
+
+OvrHmdBackend::OvrHmdBackend()
+: m_systemInit(false)
+, m_pManager(NULL)
+, m_pHMD(NULL)
+, m_pSensor(NULL)
+, m_pSFusion(NULL)
+{
+}
+
+OvrHmdBackend::~OvrHmdBackend()
+{
+    Shutdown();
+}
+
+/// Open the first available HMD and attach its sensor to sensor fusion.
+bool OvrHmdBackend::Init()
+{
+    OVR::System::Init(OVR::Log::ConfigureDefaultLog(OVR::LogMask_All));
+    m_systemInit = true;
+
+    m_pManager = *OVR::DeviceManager::Create();
+    m_pHMD  = *m_pManager->EnumerateDevices<OVR::HMDDevice>().CreateDevice();
+    if (m_pHMD == NULL)
+        return false;
+
+    m_pSensor = *m_pHMD->GetSensor();
+    if (m_pSensor)
+    {
+        // We need to attach sensor to SensorFusion object for it to receive
+        // body frame messages and update orientation. SFusion.GetOrientation()
+        // is used in OnIdle() to orient the view.
+        m_pSFusion = new OVR::SensorFusion;
+        m_pSFusion->AttachToSensor(m_pSensor);
+        //SFusion.SetDelegateMessageHandler(this);
+        //SFusion.SetPredictionEnabled(true);
+    }
+    return true;
+}
+
+void OvrHmdBackend::Shutdown()
+{
+    if (!m_systemInit)
+        return;
+
+    delete m_pSFusion;
+    m_pSFusion = NULL;
+
+    // Clear these before calling Destroy.
+    m_pSensor.Clear();
+    m_pManager.Clear();
+    m_pHMD.Clear();
+    // No OVR functions involving memory are allowed after this.
+    OVR::System::Destroy();
+    m_systemInit = false;
+}
+
+/// This will initialize HMDInfo with information about configured IPD,
+/// screen size and other variables needed for correct projection.
+bool OvrHmdBackend::GetHMDInfo(OVR::HMDInfo& info) const
+{
+    if (m_pHMD == NULL)
+        return false;
+    return m_pHMD->GetDeviceInfo(&info);
+}
+
+OVR::Quatf OvrHmdBackend::GetOrientation(unsigned long long* pSampleNs) const
+{
+    // Sensor fusion integrates on its own thread; the latest state is what we read now.
+    if (pSampleNs != NULL)
+        *pSampleNs = HighResClock::NowNanoseconds();
+    if (m_pSFusion == NULL)
+        return OVR::Quatf();
+    return m_pSFusion->GetOrientation();
+}
@@ -0,0 +1,31 @@
+// OvrHmdBackend.h
+
+#pragma once
+
+#include "HmdBackend.h"
+
+///@brief HmdBackend for a Rift attached through the OVR SDK.
+class OvrHmdBackend : public HmdBackend
+{
+public:
+    OvrHmdBackend();
+    virtual ~OvrHmdBackend();
+
+    virtual bool Init();
+    virtual void Shutdown();
+    virtual const char* GetName() const { return "Oculus Rift"; }
+    virtual bool GetHMDInfo(OVR::HMDInfo& info) const;
+    virtual bool SensorActive() const { return m_pSensor != NULL; }
+    virtual OVR::Quatf GetOrientation(unsigned long long* pSampleNs) const;
+
+protected:
+    bool                          m_systemInit;
+    OVR::Ptr<OVR::DeviceManager>  m_pManager;
+    OVR::Ptr<OVR::HMDDevice>      m_pHMD;
+    OVR::Ptr<OVR::SensorDevice>   m_pSensor;
+    OVR::SensorFusion*            m_pSFusion;
+
+private: // Disallow copy ctor and assignment operator
+    OvrHmdBackend(const OvrHmdBackend&);
+    OvrHmdBackend& operator=(const OvrHmdBackend&);
+};
@@ -0,0 +1,130 @@
+// SimulatedHmd.cpp
+
+#include "SimulatedHmd.h"
+#include "Timer.h"
+
+#include <math.h>
+#include <chrono>
+
+SimulatedHmdParams::SimulatedHmdParams()
+: sensorRateHz(1000.0f)
+, yawAmplitude(0.6f)
+, yawFrequency(0.1f)
+, pitchAmplitude(0.2f)
+, pitchFrequency(0.17f)
+, rollAmplitude(0.05f)
+, rollFrequency(0.23f)
+, display()
+{
+    // These default values were copied from the Rift DK1 and will be
+    // used when no Rift is present so output looks sane.
+    OVR::HMDInfo& hmd = display;
+    hmd.DesktopX = 0;
+    hmd.DesktopY = 0;
+    hmd.HResolution = 1280;
+    hmd.VResolution = 800;
+
+    hmd.HScreenSize = 0.14975999f;
+    hmd.VScreenSize = 0.093599997f;
+    hmd.VScreenCenter = 0.046799999f;
+
+    hmd.DistortionK[0] = 1.0f;
+    hmd.DistortionK[1] = 0.5f;
+    hmd.DistortionK[2] = 0.25f;
+    hmd.DistortionK[3] = 0.0f;
+
+    hmd.EyeToScreenDistance = 0.041000001f;
+    hmd.InterpupillaryDistance = 0.064f;
+    hmd.LensSeparationDistance = 0.063500002f;
+}
+
+
+SimulatedHmd::SimulatedHmd(const SimulatedHmdParams& params)
+: m_params(params)
+, m_startNs(0)
+, m_mutex()
+, m_orientation()
+, m_sampleNs(0)
+, m_sampleCount(0)
+, m_quit(false)
+, m_sensorThread()
+{
+}
+
+SimulatedHmd::~SimulatedHmd()
+{
+    Shutdown();
+}
+
+bool SimulatedHmd::Init()
+{
+    m_startNs = HighResClock::NowNanoseconds();
+    m_sampleNs = m_startNs;
+    m_quit.store(false);
+    if (SensorActive())
+    {
+        m_sensorThread = std::thread(&SimulatedHmd::_SensorLoop, this);
+    }
+    return true;
+}
+
+void SimulatedHmd::Shutdown()
+{
+    m_quit.store(true);
+    if (m_sensorThread.joinable())
+        m_sensorThread.join();
+}
+
+bool SimulatedHmd::GetHMDInfo(OVR::HMDInfo& info) const
+{
+    info = m_params.display;
+    return true;
+}
+
+/// Returns the most recent sample, as a real sensor would, rather than the
+/// pose at the time of the call.
+OVR::Quatf SimulatedHmd::GetOrientation(unsigned long long* pSampleNs) const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (pSampleNs != NULL)
+        *pSampleNs = m_sampleNs;
+    return m_orientation;
+}
+
+OVR::Quatf SimulatedHmd::OrientationAt(double seconds) const
+{
+    const double twoPi = 2.0 * 3.14159265358979;
+    const float yaw   = m_params.yawAmplitude   * (float)sin(twoPi * m_params.yawFrequency   * seconds);
+    const float pitch = m_params.pitchAmplitude * (float)sin(twoPi * m_params.pitchFrequency * seconds);
+    const float roll  = m_params.rollAmplitude  * (float)sin(twoPi * m_params.rollFrequency  * seconds);
+
+    // Yaw-pitch-roll order, as OculusAppSkeleton decomposes it.
+    return OVR::Quatf(OVR::Vector3f(0.0f, 1.0f, 0.0f), yaw) *
+           OVR::Quatf(OVR::Vector3f(1.0f, 0.0f, 0.0f), pitch) *
+           OVR::Quatf(OVR::Vector3f(0.0f, 0.0f, 1.0f), roll);
+}
+
+/// Background thread: publish a new sample every sensor period. Ticks are
+/// scheduled against absolute times so the rate does not drift with
+/// oversleeping.
+void SimulatedHmd::_SensorLoop()
+{
+    const std::chrono::nanoseconds period(
+        (long long)(1.0e9 / (double)m_params.sensorRateHz));
+    std::chrono::steady_clock::time_point next = std::chrono::steady_clock::now();
+
+    while (!m_quit.load(std::memory_order_relaxed))
+    {
+        const unsigned long long nowNs = HighResClock::NowNanoseconds();
+        const OVR::Quatf q = OrientationAt(1.0e-9 * (double)(nowNs - m_startNs));
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_orientation = q;
+            m_sampleNs = nowNs;
+        }
+        m_sampleCount.fetch_add(1, std::memory_order_relaxed);
+
+        next += period;
+        std::this_thread::sleep_until(next);
+    }
+}
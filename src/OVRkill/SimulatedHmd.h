@@ -0,0 +1,74 @@
+// SimulatedHmd.h
+
+#pragma once
+
+#include "HmdBackend.h"
+
+#include <atomic>
+#include <mutex>
+#include <thread>
+
+///@brief Display and motion parameters for SimulatedHmd.
+/// Defaults match a Rift DK1 with its 1kHz sensor.
+struct SimulatedHmdParams
+{
+    float sensorRateHz;    ///< 0 disables the sensor: display parameters only
+    float yawAmplitude;    ///< radians
+    float yawFrequency;    ///< Hz
+    float pitchAmplitude;
+    float pitchFrequency;
+    float rollAmplitude;
+    float rollFrequency;
+    OVR::HMDInfo display;
+
+    SimulatedHmdParams();
+
+    /// The no-headset case: DK1 display, no sensor.
+    static SimulatedHmdParams DisplayOnly()
+    {
+        SimulatedHmdParams p;
+        p.sensorRateHz = 0.0f;
+        return p;
+    }
+};
+
+///@brief HmdBackend with no hardware behind it. A thread produces synthetic
+/// head motion - slow sinusoids on yaw, pitch and roll - at the configured
+/// sensor rate, so sensor sampling, prediction and latency measurement all run
+/// on machines without a headset.
+class SimulatedHmd : public HmdBackend
+{
+public:
+    SimulatedHmd(const SimulatedHmdParams& params);
+    virtual ~SimulatedHmd();
+
+    virtual bool Init();
+    virtual void Shutdown();
+    virtual const char* GetName() const { return "Simulated HMD"; }
+    virtual bool GetHMDInfo(OVR::HMDInfo& info) const;
+    virtual bool SensorActive() const { return m_params.sensorRateHz > 0.0f; }
+    virtual OVR::Quatf GetOrientation(unsigned long long* pSampleNs) const;
+
+    unsigned int GetSampleCount() const { return m_sampleCount.load(std::memory_order_relaxed); }
+
+    /// The synthetic pose at a given time since Init; deterministic.
+    OVR::Quatf OrientationAt(double seconds) const;
+
+protected:
+    void _SensorLoop();
+
+    SimulatedHmdParams m_params;
+    unsigned long long m_startNs;
+
+    mutable std::mutex        m_mutex;    ///< Guards the latest sample
+    OVR::Quatf                m_orientation;
+    unsigned long long        m_sampleNs;
+    std::atomic<unsigned int> m_sampleCount;
+
+    std::atomic<bool> m_quit;
+    std::thread       m_sensorThread;
+
+private: // Disallow copy ctor and assignment operator
+    SimulatedHmd(const SimulatedHmd&);
+    SimulatedHmd& operator=(const SimulatedHmd&);
+};
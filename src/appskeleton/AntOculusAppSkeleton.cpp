@@ -1,18 +1,30 @@
 // AntOculusAppSkeleton.cpp
 
 #include "AntOculusAppSkeleton.h"
+#include "Profiler.h"
+#include "EventLog.h"
 
 AntOculusAppSkeleton::AntOculusAppSkeleton()
 : m_timer()
 , m_fps(0.0f)
+, m_frameSummary()
+, m_swapLatencySummary()
+, m_gpuLatencySummary()
+, m_fenceWaitSummary()
+, m_drawStatsSummary()
+, m_framesSinceSummary(0)
+, m_resetStatsPending(false)
+, m_printStatsPending(false)
 #ifdef USE_ANTTWEAKBAR
 , m_pBar(NULL)
+, m_tweakbarMutex()
 #endif
 {
 }
 
 AntOculusAppSkeleton::~AntOculusAppSkeleton()
 {
+    PrintFrameStats(stdout);
     ///@todo Delete this before glfw
     //delete m_pBar;
 }
@@ -56,6 +68,18 @@ static void TW_CALL SetBufferScaleCallback(const void *value, void *clientData)
     }
 }
 
+static void TW_CALL SetControlScaleCallback(const void *value, void *clientData)
+{
+    static_cast<AntOculusAppSkeleton *>(clientData)->SetWindowResolutionScale(
+        AntOculusAppSkeleton::Window_Control, *(const float *)value);
+}
+
+static void TW_CALL GetControlScaleCallback(void *value, void *clientData)
+{
+    *(float *)value = static_cast<const AntOculusAppSkeleton *>(clientData)->GetWindowResolutionScale(
+        AntOculusAppSkeleton::Window_Control);
+}
+
 static void TW_CALL GetBufferScaleCallback(void *value, void *clientData)
 {
     if (clientData)
@@ -74,6 +98,115 @@ static void TW_CALL GetMegaPxPerSecond(void *value, void *clientData)
     *static_cast<float *>(value) = static_cast<const AntOculusAppSkeleton *>(clientData)->GetMegaPixelsPerSecond();
 }
 
+static void TW_CALL GetGpuTimerAverageMs(void *value, void *clientData)
+{
+    *static_cast<float *>(value) = static_cast<const GpuTimer *>(clientData)->GetAverageMs();
+}
+
+static void TW_CALL GetGpuTimerMaxMs(void *value, void *clientData)
+{
+    *static_cast<float *>(value) = static_cast<const GpuTimer *>(clientData)->GetMaxMs();
+}
+
+static void TW_CALL SetFramePacingCallback(const void *value, void *clientData)
+{
+    static_cast<FrameScheduler *>(clientData)->SetEnabled( *(const bool *)value);
+}
+
+static void TW_CALL GetFramePacingCallback(void *value, void *clientData)
+{
+    *(bool *)value = static_cast<const FrameScheduler *>(clientData)->IsEnabled();
+}
+
+static void TW_CALL GetVblankPeriodMs(void *value, void *clientData)
+{
+    *static_cast<float *>(value) = static_cast<const FrameScheduler *>(clientData)->GetVblankPeriodMs();
+}
+
+static void TW_CALL GetRenderEstimateMs(void *value, void *clientData)
+{
+    *static_cast<float *>(value) = static_cast<const FrameScheduler *>(clientData)->GetRenderEstimateMs();
+}
+
+static void TW_CALL GetVblankMarginMs(void *value, void *clientData)
+{
+    *static_cast<float *>(value) = static_cast<const FrameScheduler *>(clientData)->GetMarginMs();
+}
+
+static void TW_CALL GetMissedVblanks(void *value, void *clientData)
+{
+    *static_cast<unsigned int *>(value) = static_cast<const FrameScheduler *>(clientData)->GetMissedVblanks();
+}
+
+static void TW_CALL SetFramesInFlightCallback(const void *value, void *clientData)
+{
+    static_cast<AntOculusAppSkeleton *>(clientData)->SetMaxFramesInFlight( *(const int *)value);
+}
+
+static void TW_CALL GetFramesInFlightCallback(void *value, void *clientData)
+{
+    *(int *)value = static_cast<const AntOculusAppSkeleton *>(clientData)->GetMaxFramesInFlight();
+}
+
+static void TW_CALL SetEventLogCallback(const void *value, void *clientData)
+{
+    EventLog& events = EventLog::Instance();
+    if (*(const bool *)value)
+        events.Open("events.bin");
+    else
+        events.Close();
+}
+
+static void TW_CALL GetEventLogCallback(void *value, void *clientData)
+{
+    *(bool *)value = EventLog::Instance().IsOpen();
+}
+
+static void TW_CALL SetGpuTraceCallback(const void *value, void *clientData)
+{
+    static_cast<AntOculusAppSkeleton *>(clientData)->SetGpuTraceEnabled( *(const bool *)value);
+}
+
+static void TW_CALL GetGpuTraceCallback(void *value, void *clientData)
+{
+    *(bool *)value = static_cast<const AntOculusAppSkeleton *>(clientData)->GetGpuTraceEnabled();
+}
+
+#ifdef USE_PROFILER
+static void TW_CALL SetProfilerTraceCallback(const void *value, void *clientData)
+{
+    if (*(const bool *)value)
+        Profiler::Instance().Start("trace.json");
+    else
+        Profiler::Instance().Stop();
+}
+
+static void TW_CALL GetProfilerTraceCallback(void *value, void *clientData)
+{
+    *(bool *)value = Profiler::Instance().IsRecording();
+}
+#endif
+
+static void TW_CALL ResetFrameStatsCB(void *clientData)
+{
+    static_cast<AntOculusAppSkeleton *>(clientData)->RequestFrameStatsReset();
+}
+
+static void TW_CALL PrintFrameStatsCB(void *clientData)
+{
+    static_cast<AntOculusAppSkeleton *>(clientData)->RequestFrameStatsPrint();
+}
+
+static void TW_CALL SetLatencyTestCallback(const void *value, void *clientData)
+{
+    static_cast<AntOculusAppSkeleton *>(clientData)->SetLatencyTestEnabled( *(const bool *)value);
+}
+
+static void TW_CALL GetLatencyTestCallback(void *value, void *clientData)
+{
+    *(bool *)value = static_cast<const AntOculusAppSkeleton *>(clientData)->GetLatencyTestEnabled();
+}
+
 static void TW_CALL ResetEyePositionCB(void *clientData)
 {
     static_cast<AntOculusAppSkeleton *>(clientData)->ResetEyePosition();
@@ -116,6 +249,61 @@ void AntOculusAppSkeleton::_InitializeBar()
     TwAddVarRO(m_pBar, "fps", TW_TYPE_FLOAT, &m_fps, 
                " label='fps' precision=0 group='Performance' ");
 
+    // Frame time distribution over the last 1024 frames
+    TwAddVarRO(m_pBar, "frame p50", TW_TYPE_FLOAT, &m_frameSummary.p50,
+               " label='frame p50 ms' precision=2 group='Performance' ");
+    TwAddVarRO(m_pBar, "frame p95", TW_TYPE_FLOAT, &m_frameSummary.p95,
+               " label='frame p95 ms' precision=2 group='Performance' ");
+    TwAddVarRO(m_pBar, "frame p99", TW_TYPE_FLOAT, &m_frameSummary.p99,
+               " label='frame p99 ms' precision=2 group='Performance' ");
+    TwAddVarRO(m_pBar, "frame max", TW_TYPE_FLOAT, &m_frameSummary.max,
+               " label='frame max ms' precision=2 group='Performance' ");
+    TwAddVarRO(m_pBar, "over budget", TW_TYPE_UINT32, &m_frameSummary.overBudget,
+               " label='frames over budget' group='Performance' ");
+    TwAddButton(m_pBar, "Reset frame stats", ResetFrameStatsCB, this,
+               " label='Reset frame stats' group='Performance' ");
+    TwAddButton(m_pBar, "Print frame stats", PrintFrameStatsCB, this,
+               " label='Print frame stats' group='Performance' ");
+
+    // Motion-to-photon: sensor sample time to swap return and to GPU completion
+    TwAddVarCB(m_pBar, "Latency test", TW_TYPE_BOOLCPP,
+        SetLatencyTestCallback, GetLatencyTestCallback, this,
+        " label='Latency test' help='Measure sensor sample to swap and GPU finish times. Waits for the GPU every frame.' group='Latency' ");
+    TwAddVarRO(m_pBar, "swap latency p50", TW_TYPE_FLOAT, &m_swapLatencySummary.p50,
+               " label='to swap p50 ms' precision=2 group='Latency' ");
+    TwAddVarRO(m_pBar, "swap latency p99", TW_TYPE_FLOAT, &m_swapLatencySummary.p99,
+               " label='to swap p99 ms' precision=2 group='Latency' ");
+    TwAddVarRO(m_pBar, "gpu latency p50", TW_TYPE_FLOAT, &m_gpuLatencySummary.p50,
+               " label='to GPU done p50 ms' precision=2 group='Latency' ");
+    TwAddVarRO(m_pBar, "gpu latency p99", TW_TYPE_FLOAT, &m_gpuLatencySummary.p99,
+               " label='to GPU done p99 ms' precision=2 group='Latency' ");
+    TwDefine(" TweakBar/Latency group='Performance' ");
+
+    // Vsync and late frame starts for the HMD window
+    TwAddVarRW(m_pBar, "HMD swap interval", TW_TYPE_INT32, &m_windowSwapInterval[Window_Oculus],
+               " label='HMD swap interval' min=0 max=4 help='Vblanks per frame; 0 for no vsync' group='Frame Pacing' ");
+    TwAddVarRW(m_pBar, "Control swap interval", TW_TYPE_INT32, &m_windowSwapInterval[Window_Control],
+               " label='Control swap interval' min=0 max=4 help='Vblanks per frame; 0 for no vsync' group='Frame Pacing' ");
+    TwAddVarCB(m_pBar, "Late frame start", TW_TYPE_BOOLCPP,
+        SetFramePacingCallback, GetFramePacingCallback, &m_frameScheduler,
+        " label='Late frame start' help='Start HMD frames and sample input just in time for the next vblank' group='Frame Pacing' ");
+    TwAddVarCB(m_pBar, "vblank period", TW_TYPE_FLOAT, NULL, GetVblankPeriodMs, &m_frameScheduler,
+        " label='vblank period ms' precision=3 group='Frame Pacing' ");
+    TwAddVarCB(m_pBar, "render estimate", TW_TYPE_FLOAT, NULL, GetRenderEstimateMs, &m_frameScheduler,
+        " label='render estimate ms' precision=2 group='Frame Pacing' ");
+    TwAddVarCB(m_pBar, "vblank margin", TW_TYPE_FLOAT, NULL, GetVblankMarginMs, &m_frameScheduler,
+        " label='safety margin ms' precision=2 group='Frame Pacing' ");
+    TwAddVarCB(m_pBar, "missed vblanks", TW_TYPE_UINT32, NULL, GetMissedVblanks, &m_frameScheduler,
+        " label='missed vblanks' group='Frame Pacing' ");
+    TwAddVarCB(m_pBar, "Frames in flight", TW_TYPE_INT32,
+        SetFramesInFlightCallback, GetFramesInFlightCallback, this,
+        " label='Frames in flight' min=1 max=3 help='Frames the CPU may queue ahead of the GPU. Fewer is lower latency, more is higher throughput.' group='Frame Pacing' ");
+    TwAddVarRO(m_pBar, "fence wait p50", TW_TYPE_FLOAT, &m_fenceWaitSummary.p50,
+               " label='HMD fence wait p50 ms' precision=2 group='Frame Pacing' ");
+    TwAddVarRO(m_pBar, "fence wait p99", TW_TYPE_FLOAT, &m_fenceWaitSummary.p99,
+               " label='HMD fence wait p99 ms' precision=2 group='Frame Pacing' ");
+    TwDefine(" TweakBar/'Frame Pacing' group='Performance' ");
+
     TwAddVarCB(m_pBar, "FBO width", TW_TYPE_INT32, NULL, GetDistortionFboWidth, &m_ok,
         "precision=0 group='Performance' ");
     TwAddVarCB(m_pBar, "FBO height", TW_TYPE_INT32, NULL, GetDistortionFboHeight, &m_ok,
@@ -132,6 +320,56 @@ void AntOculusAppSkeleton::_InitializeBar()
     TwAddVarRW(m_pBar, "FBO gutter size", TW_TYPE_INT32, &m_bufferGutterPx,
         " min=0 precision=0 group='Performance' ");
 
+    // Draw packets and the state changes their order costs, for one eye
+    TwAddVarRW(m_pBar, "Sort draws", TW_TYPE_BOOLCPP, &m_sortDraws,
+        " label='Sort draws' help='Sort draw packets by program, material and mesh before replay' group='Draws' ");
+    TwAddVarRW(m_pBar, "Multi-draw", TW_TYPE_BOOLCPP, &m_multiDraw,
+        " label='Multi-draw indirect' help='One indirect draw per program where the context has GL 4.3' group='Draws' ");
+    TwAddVarRO(m_pBar, "draw packets", TW_TYPE_INT32, &m_drawStatsSummary.packets,
+        " label='packets' group='Draws' ");
+    TwAddVarRO(m_pBar, "changes unsorted", TW_TYPE_INT32, &m_drawStatsSummary.unsortedChanges,
+        " label='state changes unsorted' group='Draws' ");
+    TwAddVarRO(m_pBar, "changes sorted", TW_TYPE_INT32, &m_drawStatsSummary.sortedChanges,
+        " label='state changes sorted' group='Draws' ");
+    TwAddVarRO(m_pBar, "GL binds per frame", TW_TYPE_INT32, &m_drawStatsSummary.frameStateChanges,
+        " label='GL binds/frame' group='Draws' ");
+    TwAddVarRO(m_pBar, "draw calls per frame", TW_TYPE_INT32, &m_drawStatsSummary.frameDraws,
+        " label='draw calls/frame' group='Draws' ");
+    TwDefine(" TweakBar/Draws group='Performance' ");
+
+    // Rolling averages and maxima of GL_TIME_ELAPSED queries over the last 60 frames
+    GpuTimer* hmd  = m_gpuTimers[Window_Oculus];
+    GpuTimer* ctrl = m_gpuTimers[Window_Control];
+    TwAddVarCB(m_pBar, "gpu scene L", TW_TYPE_FLOAT, NULL, GetGpuTimerAverageMs, &hmd[Pass_SceneLeft],
+        " label='HMD scene L ms' precision=2 group='Performance' ");
+    TwAddVarCB(m_pBar, "gpu scene L max", TW_TYPE_FLOAT, NULL, GetGpuTimerMaxMs, &hmd[Pass_SceneLeft],
+        " label='HMD scene L max' precision=2 group='Performance' ");
+    TwAddVarCB(m_pBar, "gpu scene R", TW_TYPE_FLOAT, NULL, GetGpuTimerAverageMs, &hmd[Pass_SceneRight],
+        " label='HMD scene R ms' precision=2 group='Performance' ");
+    TwAddVarCB(m_pBar, "gpu scene R max", TW_TYPE_FLOAT, NULL, GetGpuTimerMaxMs, &hmd[Pass_SceneRight],
+        " label='HMD scene R max' precision=2 group='Performance' ");
+    TwAddVarCB(m_pBar, "gpu present", TW_TYPE_FLOAT, NULL, GetGpuTimerAverageMs, &hmd[Pass_Present],
+        " label='HMD present ms' precision=2 group='Performance' ");
+    TwAddVarCB(m_pBar, "gpu present max", TW_TYPE_FLOAT, NULL, GetGpuTimerMaxMs, &hmd[Pass_Present],
+        " label='HMD present max' precision=2 group='Performance' ");
+    TwAddVarCB(m_pBar, "gpu ctrl scene", TW_TYPE_FLOAT, NULL, GetGpuTimerAverageMs, &ctrl[Pass_SceneMono],
+        " label='Ctrl scene ms' precision=2 group='Performance' ");
+    TwAddVarCB(m_pBar, "gpu ctrl present", TW_TYPE_FLOAT, NULL, GetGpuTimerAverageMs, &ctrl[Pass_Present],
+        " label='Ctrl present ms' precision=2 group='Performance' ");
+    TwAddVarCB(m_pBar, "gpu tweakbar", TW_TYPE_FLOAT, NULL, GetGpuTimerAverageMs, &ctrl[Pass_TweakBar],
+        " label='TwDraw ms' precision=2 group='Performance' ");
+    TwAddVarCB(m_pBar, "GPU trace", TW_TYPE_BOOLCPP,
+        SetGpuTraceCallback, GetGpuTraceCallback, this,
+        " label='GPU trace CSV' help='Write per-pass GPU times to gputimes.csv' group='Performance' ");
+    TwAddVarCB(m_pBar, "Event log", TW_TYPE_BOOLCPP,
+        SetEventLogCallback, GetEventLogCallback, NULL,
+        " label='Event log' help='Record frame, pose, input and timing events to events.bin' group='Performance' ");
+#ifdef USE_PROFILER
+    TwAddVarCB(m_pBar, "CPU trace", TW_TYPE_BOOLCPP,
+        SetProfilerTraceCallback, GetProfilerTraceCallback, NULL,
+        " label='CPU trace JSON' help='Record profiler zones to trace.json for chrome://tracing' group='Performance' ");
+#endif
+
 
 
     //
@@ -178,6 +416,22 @@ void AntOculusAppSkeleton::_InitializeBar()
     TwAddVarRW(m_pBar, "viewAngle", TW_TYPE_FLOAT, &m_viewAngleDeg,
                " label='viewAngle' min=30 max=90 step=0.1 help='viewAngle' group='Third Person Camera' ");
 
+    TwEnumVal controlViews[] = {
+        { ControlView_ThirdPerson, "Third person" },
+        { ControlView_Mirror,      "Mirror HMD"   },
+        { ControlView_None,        "None"         },
+    };
+    TwType controlViewType = TwDefineEnum("ControlViewType", controlViews, ControlView_Count);
+    TwAddVarRW(m_pBar, "Control view", controlViewType, &m_controlViewMode,
+               " label='Control view' help='What the control window shows' group='Control Window' ");
+    TwAddVarRW(m_pBar, "Redraw interval", TW_TYPE_INT32, &m_thirdPersonInterval,
+               " label='Redraw every N frames' min=1 max=60 help='Third person view update rate' group='Control Window' ");
+    TwAddVarRW(m_pBar, "Control fps", TW_TYPE_FLOAT, &m_windowTargetFps[Window_Control],
+               " label='Target fps' min=0 max=240 step=1 help='0 for no limit. Only applies when the Rift has its own window.' group='Control Window' ");
+    TwAddVarCB(m_pBar, "Control scale", TW_TYPE_FLOAT,
+        SetControlScaleCallback, GetControlScaleCallback, this,
+        " label='Resolution scale' min=0.1 max=1.0 step=0.05 group='Control Window' ");
+
 
     //
     // Scene parameters
@@ -201,6 +455,91 @@ void AntOculusAppSkeleton::_InitializeBar()
 }
 #endif
 
+/// GPU time of one HMD window frame: the sum of its passes' recent averages.
+float AntOculusAppSkeleton::GetHmdGpuMs() const
+{
+    float ms = 0.0f;
+    for (int p=0; p<Pass_Count; ++p)
+    {
+        ms += m_gpuTimers[Window_Oculus][p].GetAverageMs();
+    }
+    return ms;
+}
+
+void AntOculusAppSkeleton::PrintFrameStats(FILE* pFile) const
+{
+    if (pFile == NULL)
+        return;
+    const TimingStats& frames = m_timer.GetFrameStats();
+    frames.Print(pFile, "Frame time");
+    const float gpuMs = GetHmdGpuMs();
+    if (gpuMs > 0.0f)
+    {
+        fprintf(pFile, "HMD GPU time: %.3f ms/frame, headroom %.3f ms of %.2f ms budget\n",
+            gpuMs, frames.GetBudgetMs() - gpuMs, frames.GetBudgetMs());
+    }
+    const TimingStats& fenceWaits = m_frameFences[Window_Oculus].GetWaitStats();
+    if (fenceWaits.Summarize().total > 0)
+    {
+        fprintf(pFile, "HMD frames in flight: %d\n", GetMaxFramesInFlight());
+        fenceWaits.Print(pFile, "HMD fence wait");
+    }
+    const Scene::DrawStats& draws = GetHmdDrawStats();
+    if (draws.packets > 0)
+    {
+        fprintf(pFile, "HMD draws: %d packets, %d state changes per eye unsorted, %d sorted%s; %d GL binds and %d draws%s last frame\n",
+            draws.packets, draws.unsortedChanges, draws.sortedChanges,
+            (draws.sorted != 0) ? "" : " (sorting off)",
+            draws.frameStateChanges, draws.frameDraws,
+            (draws.multiDraw != 0) ? " (multi-draw indirect)" : "");
+    }
+    m_latency.Print(pFile);
+}
+
+void AntOculusAppSkeleton::frameStart()
+{
+    OculusAppSkeleton::frameStart();
+    if (m_printStatsPending.exchange(false))
+        PrintFrameStats(stdout);
+    if (m_resetStatsPending.exchange(false))
+        ResetFrameStats();
+    m_timer.OnFrame();
+
+    EventLog& events = EventLog::Instance();
+    if (events.IsOpen())
+    {
+        // GPU results lag a frame or two behind; these are the latest available.
+        float gpuMs[Window_Count * Pass_Count];
+        for (int w=0; w<Window_Count; ++w)
+            for (int p=0; p<Pass_Count; ++p)
+                gpuMs[w*Pass_Count + p] = m_gpuTimers[w][p].GetLastMs();
+        events.LogPassTimings(GetFrameState(Window_Oculus).eventFrame,
+            m_timer.GetLastFrameMs(), gpuMs, Window_Count * Pass_Count);
+    }
+
+    // Sorting the window for percentiles is not free; a few times a second is plenty.
+    if (++m_framesSinceSummary >= 30)
+    {
+#ifdef USE_ANTTWEAKBAR
+        // TwDraw reads these on the control window's render thread. Rather
+        // than wait out a draw there, try again next frame.
+        std::unique_lock<std::mutex> lock(m_tweakbarMutex, std::try_to_lock);
+        if (!lock.owns_lock())
+            return;
+#endif
+        m_fps = m_timer.GetFPS();
+        m_frameSummary = m_timer.GetFrameStats().Summarize();
+        m_fenceWaitSummary = m_frameFences[Window_Oculus].GetWaitStats().Summarize();
+        m_drawStatsSummary = GetHmdDrawStats();
+        if (m_latency.IsEnabled())
+        {
+            m_swapLatencySummary = m_latency.GetStats(LatencyTester::Stage_Swap).Summarize();
+            m_gpuLatencySummary = m_latency.GetStats(LatencyTester::Stage_GpuDone).Summarize();
+        }
+        m_framesSinceSummary = 0;
+    }
+}
+
 bool AntOculusAppSkeleton::initGL(int argc, char **argv)
 {
 #ifdef USE_ANTTWEAKBAR
@@ -219,8 +558,12 @@ void AntOculusAppSkeleton::display(bool isControl, OVRkill::DisplayMode mode)
     // on a mirrored 1920x1080. It can also be minimized.
     if (isControl)
     {
+        std::lock_guard<std::mutex> lock(m_tweakbarMutex);
         TwRefreshBar(m_pBar);
+        GpuTimer& twTimer = m_gpuTimers[Window_Control][Pass_TweakBar];
+        twTimer.Begin();
         TwDraw(); ///@todo Should this go first? Will it write to a depth buffer?
+        twTimer.End();
     }
 #endif
 }
@@ -228,7 +571,9 @@ void AntOculusAppSkeleton::display(bool isControl, OVRkill::DisplayMode mode)
 void AntOculusAppSkeleton::mouseDown(int button, int state, int x, int y)
 {
 #ifdef USE_ANTTWEAKBAR
+    std::unique_lock<std::mutex> lock(m_tweakbarMutex);
     int ant = TwEventMouseButtonGLFW(button, state);
+    lock.unlock();
     if (ant != 0)
         return;
 #endif
@@ -238,7 +583,10 @@ void AntOculusAppSkeleton::mouseDown(int button, int state, int x, int y)
 void AntOculusAppSkeleton::mouseMove(int x, int y)
 {
 #ifdef USE_ANTTWEAKBAR
-    TwEventMousePosGLFW(x, y);
+    {
+        std::lock_guard<std::mutex> lock(m_tweakbarMutex);
+        TwEventMousePosGLFW(x, y);
+    }
 #endif
     OculusAppSkeleton::mouseMove(x, y);
 }
@@ -246,7 +594,10 @@ void AntOculusAppSkeleton::mouseMove(int x, int y)
 void AntOculusAppSkeleton::mouseWheel(int x, int y)
 {
 #ifdef USE_ANTTWEAKBAR
-    TwEventMouseWheelGLFW(x);
+    {
+        std::lock_guard<std::mutex> lock(m_tweakbarMutex);
+        TwEventMouseWheelGLFW(x);
+    }
 #endif
     OculusAppSkeleton::mouseWheel(x, y);
 }
@@ -255,7 +606,9 @@ void AntOculusAppSkeleton::mouseWheel(int x, int y)
 void AntOculusAppSkeleton::keyboard(int key, int action, int x, int y)
 {
 #ifdef USE_ANTTWEAKBAR
+    std::unique_lock<std::mutex> lock(m_tweakbarMutex);
     int ant = TwEventKeyGLFW(key, action);
+    lock.unlock();
     if (ant != 0)
         return;
 #endif
@@ -266,7 +619,9 @@ void AntOculusAppSkeleton::keyboard(int key, int action, int x, int y)
 void AntOculusAppSkeleton::charkey(unsigned int key)
 {
 #ifdef USE_ANTTWEAKBAR
+    std::unique_lock<std::mutex> lock(m_tweakbarMutex);
     int ant = TwEventCharGLFW(key, 0);
+    lock.unlock();
     if (ant != 0)
         return;
 #endif
@@ -276,7 +631,10 @@ void AntOculusAppSkeleton::charkey(unsigned int key)
 void AntOculusAppSkeleton::resize(int w, int h)
 {
 #ifdef USE_ANTTWEAKBAR
-    TwWindowSize(m_windowWidth, m_windowHeight);
+    {
+        std::lock_guard<std::mutex> lock(m_tweakbarMutex);
+        TwWindowSize(m_windowWidth, m_windowHeight);
+    }
 #endif
     OculusAppSkeleton::resize(w,h);
 }
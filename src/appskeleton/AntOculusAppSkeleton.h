@@ -19,7 +19,9 @@
 
 #ifdef USE_ANTTWEAKBAR
 #  include <AntTweakBar.h>
+#  include <mutex>
 #endif
+#include <atomic>
 
 #include "FPSTimer.h"
 #include "OVRkill.h"
@@ -28,6 +30,13 @@ class ParamListGL;
 
 ///@brief Extends OculusAppSkeleton adding an AntTweakBar, which is
 /// only displayed to the Control window.
+///@note AntTweakBar is not thread safe: its events arrive on the GLFW thread
+/// and it draws on the render thread, so both hold m_tweakbarMutex. Frame
+/// statistics are only written on the render thread; the buttons that reset or
+/// print them leave a request for frameStart to carry out. The displayed
+/// summaries are copied under the mutex too, since the HMD window's render
+/// thread writes them while the control window's draws the bar. Settings the
+/// bar edits in place are only read by the render side from FrameState.
 class AntOculusAppSkeleton : public OculusAppSkeleton
 {
 public:
@@ -42,16 +51,44 @@ public:
     virtual void charkey(unsigned int key);
     virtual void resize(int w, int h);
     virtual bool initGL(int argc, char **argv);
-    virtual void frameStart() { m_timer.OnFrame(); m_fps = m_timer.GetFPS(); }
+    virtual void frameStart();
 
     float GetMegaPixelsPerSecond() const { return (float)GetMegaPixelCount() * m_fps; }
+    void SetFrameBudgetMs(float ms) { m_timer.SetFrameBudgetMs(ms); }
+    void RequestFrameStatsReset() { m_resetStatsPending.store(true); }
+    void RequestFrameStatsPrint() { m_printStatsPending.store(true); }
+    void ResetFrameStats()
+    {
+        m_timer.ResetFrameStats();
+        m_latency.Reset();
+        for (int i=0; i<Window_Count; ++i)
+            m_frameFences[i].ResetWaitStats();
+    }
+    void PrintFrameStats(FILE* pFile) const;
+    float GetHmdGpuMs() const;
+    /// With no separate HMD window, the control window shows the HMD view.
+    const Scene::DrawStats& GetHmdDrawStats() const
+    {
+        const Scene::DrawStats& hmd = m_scene.GetDrawStats(Window_Oculus);
+        return (hmd.packets > 0) ? hmd : m_scene.GetDrawStats(Window_Control);
+    }
+
 protected:
     FPSTimer  m_timer;
-    float     m_fps;
+    float     m_fps;                     ///< Refreshed with the summaries
+    TimingStats::Summary m_frameSummary; ///< Refreshed periodically for display
+    TimingStats::Summary m_swapLatencySummary;
+    TimingStats::Summary m_gpuLatencySummary;
+    TimingStats::Summary m_fenceWaitSummary; ///< HMD window
+    Scene::DrawStats     m_drawStatsSummary; ///< HMD window
+    unsigned int m_framesSinceSummary;
+    std::atomic<bool> m_resetStatsPending;
+    std::atomic<bool> m_printStatsPending;
 
 #ifdef USE_ANTTWEAKBAR
     void _InitializeBar();
     TwBar* m_pBar;
+    std::mutex m_tweakbarMutex;
     double speed;
 #endif
 
@@ -39,12 +39,6 @@ bool AppSkeleton::initGL(int argc, char **argv)
     LOG_INFO("Status: Using GLEW %s\n", glewGetString(GLEW_VERSION));
 #endif
 
-#if   defined(WIN32)
-    //wglSwapIntervalEXT(0);
-#elif defined(LINUX)
-    glxSwapIntervalSGI(0);
-#endif
-
     _InitShaders();
 
     return true;
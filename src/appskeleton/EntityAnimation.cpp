@@ -0,0 +1,138 @@
+// EntityAnimation.cpp
+
+#include "EntityAnimation.h"
+
+#include <math.h>
+
+#ifdef ENTITY_ANIMATION_SSE
+#  include <emmintrin.h>
+#endif
+
+namespace
+{
+    // 2pi split so k*TwoPiHi is exact for the k that come up
+    const float InvTwoPi = 0.159154943f;
+    const float TwoPiHi  = 6.28125f;
+    const float TwoPiLo  = 0.00193530717958647692f;
+    const float Pi       = 3.14159265f;
+
+    // Taylor terms of sin up to x^9; under 4e-6 error on [0, pi/2]
+    const float S3 = -1.0f / 6.0f;
+    const float S5 =  1.0f / 120.0f;
+    const float S7 = -1.0f / 5040.0f;
+    const float S9 =  1.0f / 362880.0f;
+}
+
+///@brief Reduce to [-pi, pi], fold |x| into [0, pi/2] where sin is
+/// symmetric about pi/2, evaluate the odd polynomial and restore the sign.
+float EntityAnimation::FastSin(float x)
+{
+    const float k = floorf(x * InvTwoPi + 0.5f);
+    x = (x - k * TwoPiHi) - k * TwoPiLo;
+
+    float ax = fabsf(x);
+    const float folded = Pi - ax;
+    if (folded < ax)
+        ax = folded;
+
+    const float x2 = ax * ax;
+    const float p = ax + ax * x2 * (S3 + x2 * (S5 + x2 * (S7 + x2 * S9)));
+    return (x < 0.0f) ? -p : p;
+}
+
+#ifdef ENTITY_ANIMATION_SSE
+/// FastSin on four lanes.
+static inline __m128 FastSin4(__m128 x)
+{
+    const __m128 k = _mm_cvtepi32_ps(_mm_cvtps_epi32(_mm_mul_ps(x, _mm_set1_ps(InvTwoPi))));
+    x = _mm_sub_ps(_mm_sub_ps(x, _mm_mul_ps(k, _mm_set1_ps(TwoPiHi))), _mm_mul_ps(k, _mm_set1_ps(TwoPiLo)));
+
+    const __m128 signMask = _mm_set1_ps(-0.0f);
+    const __m128 sign = _mm_and_ps(x, signMask);
+    __m128 ax = _mm_andnot_ps(signMask, x);
+    ax = _mm_min_ps(ax, _mm_sub_ps(_mm_set1_ps(Pi), ax));
+
+    const __m128 x2 = _mm_mul_ps(ax, ax);
+    __m128 p = _mm_add_ps(_mm_set1_ps(S7), _mm_mul_ps(x2, _mm_set1_ps(S9)));
+    p = _mm_add_ps(_mm_set1_ps(S5), _mm_mul_ps(x2, p));
+    p = _mm_add_ps(_mm_set1_ps(S3), _mm_mul_ps(x2, p));
+    p = _mm_add_ps(ax, _mm_mul_ps(_mm_mul_ps(ax, x2), p));
+    return _mm_or_ps(p, sign);
+}
+#endif
+
+///@brief Bounce every entity about its rest height: y = base + amplitude * sin(frequency * (time + phase)),
+/// and give them all the same scale.
+void EntityAnimation::AnimateBounce(EntityStore& store, float time, float amplitude, float frequency, float scale)
+{
+    const Bounce bounce = { &store, time, amplitude, frequency, scale };
+    _AnimateBounceRange(bounce, 0, store.GetPaddedCount());
+}
+
+///@brief The same update split into jobs of EntitiesPerJob; stores smaller
+/// than that run inline. Wait on done before reading the results.
+void EntityAnimation::AnimateBounce(JobSystem& jobs, const Bounce& bounce, JobCounter& done)
+{
+    const int groups = bounce.pStore->GetPaddedCount() / EntityStore::Lanes;
+    const int groupsPerJob = EntitiesPerJob / EntityStore::Lanes;
+    jobs.ParallelFor(0, groups, groupsPerJob, _BounceJob, (void*)&bounce, done);
+}
+
+void EntityAnimation::_BounceJob(void* pBounce, int beginGroup, int endGroup)
+{
+    _AnimateBounceRange(*(const Bounce*)pBounce,
+        beginGroup * EntityStore::Lanes,
+        endGroup * EntityStore::Lanes);
+}
+
+///@param begin,end Entity range; multiples of EntityStore::Lanes
+void EntityAnimation::_AnimateBounceRange(const Bounce& bounce, int begin, int end)
+{
+    EntityStore& store = *bounce.pStore;
+    if (end <= begin)
+        return;
+
+    const float* pPhase = store.Phase();
+    const float* pBaseY = store.BaseY();
+    float* pPosY = store.PosY();
+    float* pScale = store.Scale();
+
+#ifdef ENTITY_ANIMATION_SSE
+    const __m128 t = _mm_set1_ps(bounce.time);
+    const __m128 amp = _mm_set1_ps(bounce.amplitude);
+    const __m128 freq = _mm_set1_ps(bounce.frequency);
+    const __m128 sc = _mm_set1_ps(bounce.scale);
+    for (int i=begin; i<end; i+=EntityStore::Lanes)
+    {
+        const __m128 arg = _mm_mul_ps(freq, _mm_add_ps(t, _mm_loadu_ps(pPhase + i)));
+        const __m128 y = _mm_add_ps(_mm_loadu_ps(pBaseY + i), _mm_mul_ps(amp, FastSin4(arg)));
+        _mm_storeu_ps(pPosY + i, y);
+        _mm_storeu_ps(pScale + i, sc);
+    }
+#else
+    for (int i=begin; i<end; ++i)
+    {
+        pPosY[i] = pBaseY[i] + bounce.amplitude * FastSin(bounce.frequency * (bounce.time + pPhase[i]));
+        pScale[i] = bounce.scale;
+    }
+#endif
+}
+
+/// The same as AnimateBounce one entity at a time, for CPUs without SSE2 and
+/// for comparison.
+void EntityAnimation::AnimateBounceScalar(EntityStore& store, float time, float amplitude, float frequency, float scale)
+{
+    const int count = store.GetCount();
+    if (count == 0)
+        return;
+
+    const float* pPhase = store.Phase();
+    const float* pBaseY = store.BaseY();
+    float* pPosY = store.PosY();
+    float* pScale = store.Scale();
+    for (int i=0; i<count; ++i)
+    {
+        pPosY[i] = pBaseY[i] + amplitude * FastSin(frequency * (time + pPhase[i]));
+        pScale[i] = scale;
+    }
+}
@@ -0,0 +1,45 @@
+// EntityAnimation.h
+
+#pragma once
+
+#include "EntityStore.h"
+#include "JobSystem.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#  define ENTITY_ANIMATION_SSE
+#endif
+
+///@brief Animation systems that update every entity in an EntityStore at once.
+///
+/// They run once per timestep on the simulation side; the renderer only reads
+/// the results. Sine is a polynomial approximation, good to a few parts per
+/// million, so it vectorizes. The SSE path evaluates four entities per
+/// instruction. The scalar path evaluates the same polynomial for CPUs
+/// without SSE2.
+///
+/// Large stores can be split across a JobSystem; each job takes a range of
+/// whole lane groups.
+class EntityAnimation
+{
+public:
+    /// Parameters of one bounce update; must outlive its jobs.
+    struct Bounce
+    {
+        EntityStore* pStore;
+        float time;
+        float amplitude;
+        float frequency;
+        float scale;
+    };
+    enum { EntitiesPerJob = 4096 };
+
+    static void AnimateBounce(EntityStore& store, float time, float amplitude, float frequency, float scale);
+    static void AnimateBounceScalar(EntityStore& store, float time, float amplitude, float frequency, float scale);
+    static void AnimateBounce(JobSystem& jobs, const Bounce& bounce, JobCounter& done);
+
+    static float FastSin(float x);
+
+protected:
+    static void _BounceJob(void* pBounce, int beginGroup, int endGroup);
+    static void _AnimateBounceRange(const Bounce& bounce, int begin, int end);
+};
@@ -0,0 +1,62 @@
+// EntityStore.cpp
+
+#include "EntityStore.h"
+
+#include <stdlib.h>
+
+EntityStore::EntityStore()
+: m_count(0)
+{
+}
+
+EntityStore::~EntityStore()
+{
+}
+
+void EntityStore::Clear()
+{
+    m_count = 0;
+    m_posX.clear();
+    m_posY.clear();
+    m_posZ.clear();
+    m_baseY.clear();
+    m_phase.clear();
+    m_scale.clear();
+}
+
+void EntityStore::Reserve(int count)
+{
+    const size_t padded = (size_t)((count + Lanes - 1) / Lanes * Lanes);
+    m_posX.reserve(padded);
+    m_posY.reserve(padded);
+    m_posZ.reserve(padded);
+    m_baseY.reserve(padded);
+    m_phase.reserve(padded);
+    m_scale.reserve(padded);
+}
+
+///@return The new entity's index
+int EntityStore::Add(float x, float y, float z, float phase, float scale)
+{
+    const int index = m_count;
+    if (index == GetPaddedCount())
+    {
+        // Grow by a whole group of lanes; the spares stay zeroed until used.
+        const size_t padded = (size_t)(index + Lanes);
+        m_posX.resize(padded, 0.0f);
+        m_posY.resize(padded, 0.0f);
+        m_posZ.resize(padded, 0.0f);
+        m_baseY.resize(padded, 0.0f);
+        m_phase.resize(padded, 0.0f);
+        m_scale.resize(padded, 0.0f);
+    }
+
+    m_posX[index] = x;
+    m_posY[index] = y;
+    m_posZ[index] = z;
+    m_baseY[index] = y;
+    m_phase[index] = phase;
+    m_scale[index] = scale;
+    ++m_count;
+    return index;
+}
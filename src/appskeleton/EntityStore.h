@@ -0,0 +1,54 @@
+// EntityStore.h
+
+#pragma once
+
+#include <vector>
+
+///@brief Animated objects stored as one array per attribute (SoA).
+///
+/// Systems that update one attribute for every entity run over contiguous
+/// floats, four at a time with SIMD. Every array is padded with zeroed
+/// entities to a multiple of Lanes, so such a loop needs no scalar tail.
+class EntityStore
+{
+public:
+    enum { Lanes = 4 };
+
+    EntityStore();
+    virtual ~EntityStore();
+
+    void Clear();
+    void Reserve(int count);
+    int  Add(float x, float y, float z, float phase, float scale);
+
+    int GetCount() const { return m_count; }
+    /// Count rounded up to a multiple of Lanes; the arrays are at least this long.
+    int GetPaddedCount() const { return (int)m_posX.size(); }
+
+    /// Current position, written by the animation systems
+    float*       PosX()        { return &m_posX[0]; }
+    float*       PosY()        { return &m_posY[0]; }
+    float*       PosZ()        { return &m_posZ[0]; }
+    const float* PosX()  const { return &m_posX[0]; }
+    const float* PosY()  const { return &m_posY[0]; }
+    const float* PosZ()  const { return &m_posZ[0]; }
+    /// Rest height that bouncing is relative to
+    const float* BaseY() const { return &m_baseY[0]; }
+    /// Per-entity offset into the animation cycle, in seconds
+    const float* Phase() const { return &m_phase[0]; }
+    float*       Scale()       { return &m_scale[0]; }
+    const float* Scale() const { return &m_scale[0]; }
+
+protected:
+    int m_count;
+    std::vector<float> m_posX;
+    std::vector<float> m_posY;
+    std::vector<float> m_posZ;
+    std::vector<float> m_baseY;
+    std::vector<float> m_phase;
+    std::vector<float> m_scale;
+
+private: // Disallow copy ctor and assignment operator
+    EntityStore(const EntityStore&);
+    EntityStore& operator=(const EntityStore&);
+};
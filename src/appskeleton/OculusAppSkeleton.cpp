@@ -7,10 +7,57 @@
 
 #define _USE_MATH_DEFINES
 #include <math.h>
+#include <string.h>
 
 #include "Draw_Helpers.h"
 #include "GL/ShaderFunctions.h"
 #include "Logger.h"
+#include "Profiler.h"
+#include "EventLog.h"
+
+OculusAppSkeleton::FrameState::FrameState()
+: oculusView()
+, controlView()
+, headRotation()
+, eyePos()
+, phase(0.0f)
+, cubeCount(0)
+, windowWidth(1)
+, windowHeight(1)
+, controlViewMode(ControlView_ThirdPerson)
+, thirdPersonInterval(1)
+, bufferGutterPx(0)
+, flattenStereo(false)
+, viewAngleDeg(45.0f)
+, sortDraws(true)
+, multiDraw(true)
+, riftDist()
+, sampleNs(0)
+, inputsNs(0)
+, viewNs(0)
+, eventFrame(0)
+, simTime(0.0)
+{
+    memset(headOrientation, 0, sizeof(headOrientation));
+    headOrientation[3] = 1.0f;
+    memset(inputs, 0, sizeof(inputs));
+    for (int w=0; w<Window_Count; ++w)
+    {
+        windowTargetFps[w] = 0.0f;
+        windowSwapInterval[w] = 1;
+    }
+    for (int i=0; i<MaxStreams; ++i)
+    {
+        streams[i].width = 0;
+        streams[i].height = 0;
+        streams[i].mode = OVRkill::SingleEye;
+    }
+    for (int i=0; i<Scene::NumCubes; ++i)
+    {
+        cubeX[i] = cubeY[i] = cubeZ[i] = 0.0f;
+        cubeScale[i] = 1.0f;
+    }
+}
 
 OculusAppSkeleton::OculusAppSkeleton()
 : AppSkeleton()
@@ -31,36 +78,89 @@ OculusAppSkeleton::OculusAppSkeleton()
 , EyePitch(0)
 , EyeRoll(0)
 , LastSensorYaw(0)
+, m_motion()
+, m_poseSampleNs(0)
+, m_sensorActive(false)
+, m_hmdOrient()
 , FollowCamDisplacement(0, 1.0f, 3.0f)
 , FollowCamPos(EyePos + FollowCamDisplacement)
+, m_pendingEyeHeight(-1.0f)
 , m_viewAngleDeg(45.0) ///< For the no HMD case
-, preferredGamepadID(0)
-, swapGamepadRAxes(false)
+, m_phase(0.0f)
+, m_simTime(0.0)
+, m_eventLogSimTime(0.0)
+, m_entities()
+, m_jobs()
+, m_inputsNs(0)
+, m_viewNs(0)
+, m_frameStates()
+, m_fboResizeRequests(0)
+, m_joystickPoller()
+, m_joystickIntegratedNs(0)
+, preferredGamepadID(-1)
+, m_gamepadMapping()
+, m_gamepadRemap()
 , which_button(-1)
 , modifier_mode(0)
 , m_ok()
+, m_useSimulatedHmd(false)
+, m_simulatedHmdParams()
+, m_inputRecorder()
+, m_latency()
+, m_frameScheduler()
 , m_riftDist()
 , m_bufferScaleUp(1.0f)
 , m_bufferGutterPx(0)
 , m_flattenStereo(false)
+, m_sortDraws(true)
+, m_multiDraw(true)
 , m_scene()
-, m_avatarProg(0)
-, m_displaySceneInControl(true)
+, m_controlViewMode(ControlView_ThirdPerson)
+, m_thirdPersonInterval(1)
+, m_controlFramesSinceDraw(0)
+, m_mirror()
+, m_pGpuTrace(NULL)
+, m_gpuTraceRequested(false)
+, m_traceFrame(0)
 {
     memset(m_keyStates, 0, GLFW_KEY_LAST*sizeof(int));
+    for (int i=0; i<FrameState::MaxStreams; ++i)
+    {
+        m_streamViews[i].width = 0;
+        m_streamViews[i].height = 0;
+        m_streamViews[i].mode = OVRkill::SingleEye;
+    }
+    for (int i=0; i<Window_Count; ++i)
+    {
+        m_fboGeneration[i] = 0;
+        m_avatarProg[i] = 0;
+        m_windowTargetFps[i] = 0.0f;
+        m_windowResolutionScale[i] = 1.0f;
+        m_windowSwapInterval[i] = 1;
+    }
+    m_scene.InitEntities(m_entities);
+    ResetEyePosition();
 }
 
 OculusAppSkeleton::~OculusAppSkeleton()
 {
-    glDeleteProgram(m_avatarProg);
+    SetGpuTraceEnabled(false);
+    UpdateGpuTrace();
+    for (int i=0; i<Window_Count; ++i)
+    {
+        glDeleteProgram(m_avatarProg[i]);
+    }
+    m_joystickPoller.Stop();
     m_ok.DestroyOVR();
     glfwTerminate();
 }
 
 bool OculusAppSkeleton::initVR(bool fullScreen)
 {
-    m_ok.InitOVR();
+    m_ok.InitOVR(m_useSimulatedHmd ? new SimulatedHmd(m_simulatedHmdParams) : NULL);
+    LOG_INFO("HMD: %s, sensor %s", m_ok.GetBackend()->GetName(), m_ok.SensorActive() ? "active" : "inactive");
     m_ok.SetDisplayMode(OVRkill::StereoWithDistortion);
+    m_ok.UpdateEyeParams();
     m_bufferScaleUp = m_ok.GetRenderBufferScaleIncrease();
 
     return true;
@@ -73,164 +173,183 @@ float OculusAppSkeleton::GetMegaPixelCount() const
     const int fboWidth = m_ok.GetRenderBufferWidth();
     const int fboHeight = m_ok.GetRenderBufferHeight();
     const int halfWidth = fboWidth/2;
-    const int widthGutter  = halfWidth - 2*m_bufferGutterPx;
-    const int heightGutter = fboHeight - 2*m_bufferGutterPx;
+    const int gutter = GetFrameState(Window_Control).bufferGutterPx;
+    const int widthGutter  = halfWidth - 2*gutter;
+    const int heightGutter = fboHeight - 2*gutter;
     const float px = 2.0f * (float)widthGutter * (float)heightGutter;
     return px / (float)(1024*1024);
 }
 
-void OculusAppSkeleton::ResizeFbo()
-{
-    m_ok.CreateRenderBuffer(m_bufferScaleUp);
-}
-
+/// Call with the control window's context current.
 bool OculusAppSkeleton::initGL(int argc, char **argv)
 {
     bool ret = AppSkeleton::initGL(argc, argv); /// calls _InitShaders
+    initWindowGL(Window_Control);
+    return ret;
+}
 
-    LOG_INFO("Initializing shaders.");
+///@brief Create the GL objects one window renders with, in that window's context,
+/// which must be current. Framebuffers are not shared between contexts, and
+/// programs are given a copy per window so concurrent renderers never set
+/// each other's uniforms.
+void OculusAppSkeleton::initWindowGL(GpuWindow w)
+{
+    LOG_INFO("Initializing shaders for window %d.", (int)w);
     {
-        m_scene.initGL();
-        m_avatarProg = makeShaderByName("avatar");
+        m_scene.initGL(w);
+        m_avatarProg[w] = makeShaderByName("avatar");
+        bindUniformBlock(m_avatarProg[w], "Camera", Scene::CameraBinding);
     }
-    m_ok.CreateShaders();
-    m_ok.CreateRenderBuffer(m_bufferScaleUp);
-
-    return ret;
+    if (!m_cameraUniforms[w].Init(sizeof(Scene::Camera), CameraBlock_Count))
+    {
+        LOG_ERROR("Window %d: no uniform buffers or fences; GL 3.2 is required to draw the scene.", (int)w);
+    }
+    const int dynamicVertexBytes = 64 * 1024;
+    m_dynamicVertices[w].Init(dynamicVertexBytes);
+    m_ok.CreateShaders(w);
+    m_ok.CreateRenderBuffer(m_bufferScaleUp, w, m_windowResolutionScale[w]);
+    m_fboGeneration[w] = m_fboResizeRequests.load();
 }
 
-///@brief Check out what joysticks we have and select a preferred one
-bool OculusAppSkeleton::initJoysticks()
+///@brief Release the per-context objects that would otherwise outlive their
+/// context: query objects are not shared, so the window's context must be
+/// current. Call once rendering has stopped.
+void OculusAppSkeleton::destroyWindowGL(GpuWindow w)
 {
-    for (int i=GLFW_JOYSTICK_1; i<GLFW_JOYSTICK_16; ++i)
+    for (int p=0; p<Pass_Count; ++p)
     {
-        const int present = glfwJoystickPresent(i);
-        if (present == GL_TRUE)
-        {
-            /// Nostromo:                   6 axes, 24 buttons
-            /// Gravis Gamepad Pro:         2 axes, 10 buttons
-            /// Generic wireless dualshock: 4 axes, 12 buttons
-            /// Eliminator Aftershock:      6 axes, 10 buttons
-            int numAxes = 0;
-            int numButs = 0;
-            glfwGetJoystickAxes(i, &numAxes);
-            glfwGetJoystickButtons(i, &numButs);
-            printf("Joystick %d:  %d axes, %d buttons\n", i, numAxes, numButs);
-
-            /// This just finds the first available joystick.
-            if ( (numAxes == 2) && (numButs == 10))
-            {
-                preferredGamepadID = i;
-                swapGamepadRAxes = false;
-            }
-            else if ( (numAxes == 6) && (numButs == 10))
-            {
-                preferredGamepadID = i;
-                swapGamepadRAxes = false;
-            }
-            else if ( (numAxes == 4) && (numButs == 12))
-            {
-                preferredGamepadID = i;
-                swapGamepadRAxes = true;
-            }
-        }
+        m_gpuTimers[w][p].DestroyGL();
     }
+}
+
+///@brief Start polling joysticks on their own thread. Call after glfwInit.
+bool OculusAppSkeleton::initJoysticks()
+{
+    m_joystickPoller.Start();
     return true;
 }
 
-/// HandleGlfwJoystick - translates joystick states into movement vectors.
-void OculusAppSkeleton::HandleGlfwJoystick()
+///@brief Read controller layouts, falling back to the built-in one alone
+/// if the file cannot be read. Call before initJoysticks.
+void OculusAppSkeleton::LoadGamepadMappings(const char* filename)
 {
-    const int joyID = preferredGamepadID;
-    int joyStick1Present = GL_FALSE;
-    joyStick1Present = glfwJoystickPresent(joyID);
-    if (joyStick1Present == GL_TRUE)
+    if ((filename != NULL) && !m_gamepadMapping.LoadFile(filename))
     {
-        int numAxes = 0;
-        int numButs = 0;
-        glfwGetJoystickAxes(joyID, &numAxes);
-        glfwGetJoystickButtons(joyID, &numButs);
-
-        int retAxes = 0;
-        const float* joy1pos = glfwGetJoystickAxes(joyID, &retAxes);
+        LOG_WARNING("Could not read gamepad mappings %s; using the built-in layout.", filename);
+    }
+    m_gamepadMapping.LoadDefaults();
+}
 
-        int retButs = 0;
-        const unsigned char* joy1but = glfwGetJoystickButtons(joyID, &retButs);
+///@brief Pick the gamepad to drive the viewer from those connected: the one
+/// matching the earliest layout in the mapping file, so a pad with a layout
+/// of its own wins over one that only fits the catch-all.
+void OculusAppSkeleton::SelectGamepad()
+{
+    if (m_gamepadMapping.GetSectionCount() == 0)
+        m_gamepadMapping.LoadDefaults();
 
-        GamepadMove = OVR::Vector3f(0,0,0);
-        if (retAxes > 0)
+    preferredGamepadID = -1;
+    int bestSection = -1;
+    for (int i=0; i<JoystickPoller::MaxJoysticks; ++i)
+    {
+        const JoystickState& pad = m_joysticks[i];
+        if (!pad.present)
+            continue;
+        const int section = m_gamepadMapping.FindSection(
+            glfwGetJoystickName(GLFW_JOYSTICK_1 + i), pad.numAxes, pad.numButtons);
+        if (section < 0)
+            continue;
+        if ((bestSection < 0) || (section < bestSection))
         {
-            float padLx = joy1pos[0];
-            float padLy = joy1pos[1];
-            float padRx = joy1pos[2];
-            float padRy = joy1pos[3];
-
-            if (swapGamepadRAxes)
-            {
-                float temp = padRx;
-                padRx = padRy;
-                padRy = temp;
-            }
-
-            const float threshold = 0.2f;
-            if (fabs(padLx) < threshold)
-                padLx = 0.0f;
-            if (fabs(padLy) < threshold)
-                padLy = 0.0f;
-            if (fabs(padRx) < threshold)
-                padRx = 0.0f;
-            if (fabs(padRy) < threshold)
-                padRy = 0.0f;
-
-            GamepadRotate = OVR::Vector3f(2 * padLx, -2 * padLy,  0);
-            GamepadMove  += OVR::Vector3f(2 * padRy, 0         , 2 * padRx);
+            preferredGamepadID = i;
+            bestSection = section;
         }
+    }
+    m_gamepadMapping.Compile(bestSection, m_gamepadRemap);
+}
 
-        if (retButs > 0)
+///@brief Bring the joystick states up to date from the poll thread's events
+/// and set GamepadMove and GamepadRotate for this timestep. Those are the
+/// average of the pad's motion over the time since the last call, with each
+/// state weighted by how long it was held. A quick tap between two frames
+/// then still moves the viewer by the right amount.
+void OculusAppSkeleton::ConsumeJoystickEvents()
+{
+    PROFILE_ZONE("ConsumeJoystickEvents");
+    const unsigned long long nowNs = HighResClock::NowNanoseconds();
+    const unsigned long long startNs = (m_joystickIntegratedNs != 0) ? m_joystickIntegratedNs : nowNs;
+    unsigned long long t = startNs;
+
+    OVR::Vector3f move(0,0,0);
+    OVR::Vector3f rotate(0,0,0);
+    if (preferredGamepadID >= 0)
+        GetGamepadVectors(m_joysticks[preferredGamepadID], move, rotate);
+    OVR::Vector3f moveSum(0,0,0);
+    OVR::Vector3f rotateSum(0,0,0);
+
+    JoystickEvent e;
+    while (m_joystickPoller.PopEvent(e))
+    {
+        // Events polled since nowNs was read count from the next timestep.
+        const unsigned long long eventNs = (e.ns < nowNs) ? e.ns : nowNs;
+        if (eventNs > t)
         {
-            float joy1buts[4] = {
-                joy1but[0] == GLFW_PRESS ? -1.0f : 0.0f,
-                joy1but[1] == GLFW_PRESS ? -1.0f : 0.0f,
-                joy1but[2] == GLFW_PRESS ? 1.0f : 0.0f,
-                joy1but[3] == GLFW_PRESS ? 1.0f : 0.0f,
-            };
-            if (swapGamepadRAxes)
-            {
-                float temp = -joy1buts[0];
-                joy1buts[0] = -joy1buts[3];
-                joy1buts[3] = temp;
+            const float heldNs = (float)(eventNs - t);
+            moveSum += move * heldNs;
+            rotateSum += rotate * heldNs;
+            t = eventNs;
+        }
 
-                temp = -joy1buts[2];
-                joy1buts[2] = -joy1buts[1];
-                joy1buts[1] = temp;
-            }
-            float padLx = joy1buts[0] + joy1buts[2];
-            float padLy = joy1buts[1] + joy1buts[3];
+        if (e.joystick >= JoystickPoller::MaxJoysticks)
+            continue;
+        m_joysticks[e.joystick].Apply(e);
+        if (e.type == JoystickEvent::Connected)
+        {
+            printf("Joystick %d connected: %s, %d axes, %d buttons\n", e.joystick,
+                glfwGetJoystickName(GLFW_JOYSTICK_1 + e.joystick), e.numAxes, e.numButtons);
+            SelectGamepad();
+        }
+        else if (e.type == JoystickEvent::Disconnected)
+        {
+            printf("Joystick %d disconnected\n", e.joystick);
+            SelectGamepad();
+        }
 
-            GamepadMove += OVR::Vector3f(padLx * padLx * (padLx > 0 ? 1 : -1),
-                                         0,
-                                         padLy * padLy * (padLy > 0 ? -1 : 1));
+        move = OVR::Vector3f(0,0,0);
+        rotate = OVR::Vector3f(0,0,0);
+        if (preferredGamepadID >= 0)
+            GetGamepadVectors(m_joysticks[preferredGamepadID], move, rotate);
+    }
+    if (nowNs > t)
+    {
+        const float heldNs = (float)(nowNs - t);
+        moveSum += move * heldNs;
+        rotateSum += rotate * heldNs;
+    }
 
-            /// Two right shoulder buttons are [5] and [7] on gravis Gamepad pro
-            if (retButs > 7)
-            {
-                /// Top shoulder button rises, bottom lowers
-                float joy1shoulderbuts[4] = {
-                    joy1but[4] == GLFW_PRESS ? 1.0f : 0.0f,
-                    joy1but[5] == GLFW_PRESS ? 1.0f : 0.0f,
-                    joy1but[6] == GLFW_PRESS ? -1.0f : 0.0f,
-                    joy1but[7] == GLFW_PRESS ? -1.0f : 0.0f,
-                };
-                float padLup   = joy1shoulderbuts[0] + joy1shoulderbuts[1];
-                float padLdown = joy1shoulderbuts[2] + joy1shoulderbuts[3];
-                padLup += padLdown;
-
-                GamepadMove += OVR::Vector3f(0,
-                                             padLup * padLup * (padLup > 0 ? 1 : -1),
-                                             0);
-            }
-        }
+    if (nowNs > startNs)
+    {
+        const float invSpan = 1.0f / (float)(nowNs - startNs);
+        GamepadMove = moveSum * invSpan;
+        GamepadRotate = rotateSum * invSpan;
     }
+    else
+    {
+        GamepadMove = move;
+        GamepadRotate = rotate;
+    }
+    m_joystickIntegratedNs = nowNs;
+}
+
+/// Translate one joystick's state into movement vectors through its layout.
+void OculusAppSkeleton::GetGamepadVectors(const JoystickState& pad, OVR::Vector3f& move, OVR::Vector3f& rotate) const
+{
+    float controls[GamepadMapping::Control_Count];
+    GamepadMapping::Apply(m_gamepadRemap, pad, controls);
+    rotate = OVR::Vector3f(controls[GamepadMapping::Look_X], controls[GamepadMapping::Look_Y], 0);
+    move = OVR::Vector3f(controls[GamepadMapping::Move_X],
+                         controls[GamepadMapping::Move_Y],
+                         controls[GamepadMapping::Move_Z]);
 }
 
 
@@ -266,69 +385,124 @@ void OculusAppSkeleton::HandleKeyboardMovement()
 }
 
 
-/// Handle input's influence on orientation variables.
-void OculusAppSkeleton::AccumulateInputs(float dt)
+/// Read the HMD's orientation once per frame for AccumulateInputs.
+void OculusAppSkeleton::SampleHeadOrientation()
 {
-    // Handle Sensor motion.
-    // We extract Yaw, Pitch, Roll instead of directly using the orientation
-    // to allow "additional" yaw manipulation with mouse/controller.
-    if (m_ok.SensorActive())
+    m_sensorActive = m_ok.SensorActive();
+    if (m_sensorActive)
     {
-        OVR::Quatf    hmdOrient = m_ok.GetOrientation();
-        float    yaw = 0.0f;
-
-        hmdOrient.GetEulerAngles<OVR::Axis_Y, OVR::Axis_X, OVR::Axis_Z>(&yaw, &EyePitch, &EyeRoll);
-
-        EyeYaw += (yaw - LastSensorYaw);
-        LastSensorYaw = yaw;
+        m_hmdOrient = m_ok.GetOrientation(&m_poseSampleNs);
+    }
+    else
+    {
+        // Without a sensor the joystick, mouse and keyboard were just read.
+        m_poseSampleNs = HighResClock::NowNanoseconds();
     }
+}
 
+static void StoreVector(float* pDst, const OVR::Vector3f& v)
+{
+    pDst[0] = v.x;
+    pDst[1] = v.y;
+    pDst[2] = v.z;
+}
 
-    // Gamepad rotation.
-    EyeYaw -= GamepadRotate.x * dt;
+static OVR::Vector3f LoadVector(const float* pSrc)
+{
+    return OVR::Vector3f(pSrc[0], pSrc[1], pSrc[2]);
+}
 
-    if (!m_ok.SensorActive())
-    {
-        // Allow gamepad to look up/down, but only if there is no Rift sensor.
-        EyePitch -= GamepadRotate.y * dt;
-        EyePitch -= MouseRotate.y * dt;
-        EyeYaw   -= MouseRotate.x * dt;
+/// Gather everything from the live devices that feeds AccumulateInputs.
+void OculusAppSkeleton::CaptureInput(InputRecorder::Frame& frame, float dt) const
+{
+    frame.dt = dt;
+    frame.orientation[0] = m_hmdOrient.x;
+    frame.orientation[1] = m_hmdOrient.y;
+    frame.orientation[2] = m_hmdOrient.z;
+    frame.orientation[3] = m_hmdOrient.w;
+    frame.sensorActive = m_sensorActive ? 1 : 0;
+    StoreVector(frame.vectors[InputRecorder::Vec_GamepadMove],    GamepadMove);
+    StoreVector(frame.vectors[InputRecorder::Vec_GamepadRotate],  GamepadRotate);
+    StoreVector(frame.vectors[InputRecorder::Vec_MouseMove],      MouseMove);
+    StoreVector(frame.vectors[InputRecorder::Vec_MouseRotate],    MouseRotate);
+    StoreVector(frame.vectors[InputRecorder::Vec_KeyboardMove],   KeyboardMove);
+    StoreVector(frame.vectors[InputRecorder::Vec_KeyboardRotate], KeyboardRotate);
+    frame.eyeHeight = m_pendingEyeHeight;
+    StoreVector(frame.followCam, FollowCamDisplacement);
+}
 
-        const float maxPitch = ((3.1415f/2)*0.98f);
-        if (EyePitch > maxPitch)
-            EyePitch = maxPitch;
-        if (EyePitch < -maxPitch)
-            EyePitch = -maxPitch;
-    }
+/// Overwrite the device-driven state with a recorded frame.
+void OculusAppSkeleton::ApplyRecordedInput(const InputRecorder::Frame& frame)
+{
+    m_hmdOrient = OVR::Quatf(frame.orientation[0], frame.orientation[1],
+                             frame.orientation[2], frame.orientation[3]);
+    m_sensorActive = (frame.sensorActive != 0);
+    m_poseSampleNs = HighResClock::NowNanoseconds();
+    GamepadMove    = LoadVector(frame.vectors[InputRecorder::Vec_GamepadMove]);
+    GamepadRotate  = LoadVector(frame.vectors[InputRecorder::Vec_GamepadRotate]);
+    MouseMove      = LoadVector(frame.vectors[InputRecorder::Vec_MouseMove]);
+    MouseRotate    = LoadVector(frame.vectors[InputRecorder::Vec_MouseRotate]);
+    KeyboardMove   = LoadVector(frame.vectors[InputRecorder::Vec_KeyboardMove]);
+    KeyboardRotate = LoadVector(frame.vectors[InputRecorder::Vec_KeyboardRotate]);
+    m_pendingEyeHeight = frame.eyeHeight;
+    FollowCamDisplacement = LoadVector(frame.followCam);
+}
 
-    if (GamepadMove.LengthSq() > 0)
-    {
-        OVR::Matrix4f yawRotate = OVR::Matrix4f::RotationY(EyeYaw);
-        OVR::Vector3f orientationVector = yawRotate.Transform(GamepadMove);
-        orientationVector *= MoveSpeed * dt;
-        EyePos += orientationVector;
-    }
+/// Start feeding a recording in place of the live devices. The viewer is put
+/// back in its initial state so every replay follows the same path.
+bool OculusAppSkeleton::StartInputReplay(const char* filename, float fixedDt)
+{
+    if (!m_inputRecorder.StartReplay(filename, fixedDt))
+        return false;
+    ResetEyePosition();
+    m_pendingEyeHeight = -1.0f;
+    LastSensorYaw = 0;
+    m_phase = 0.0f;
+    return true;
+}
 
-    if (MouseMove.LengthSq() > 0)
+///@brief Handle input's influence on orientation variables.
+/// The sensor's orientation is applied as read. Everything else is a rate,
+/// integrated by m_motion in fixed steps; the view uses its interpolated pose.
+void OculusAppSkeleton::AccumulateInputs(float dt)
+{
+    PROFILE_ZONE("AccumulateInputs");
+    // Handle Sensor motion.
+    // We extract Yaw, Pitch, Roll instead of directly using the orientation
+    // to allow "additional" yaw manipulation with mouse/controller.
+    if (m_sensorActive)
     {
-        OVR::Matrix4f yawRotate = OVR::Matrix4f::RotationY(EyeYaw);
-        OVR::Vector3f orientationVector = yawRotate.Transform(MouseMove);
-        orientationVector *= MoveSpeed * dt;
-        EyePos += orientationVector;
+        float yaw = 0.0f;
+        float pitch = 0.0f;
+        m_hmdOrient.GetEulerAngles<OVR::Axis_Y, OVR::Axis_X, OVR::Axis_Z>(&yaw, &pitch, &EyeRoll);
+        m_motion.ApplySensor(yaw - LastSensorYaw, pitch);
+        LastSensorYaw = yaw;
     }
 
-    if (KeyboardMove.LengthSq() > 0)
+    // Gamepad rotation. Mouse look and gamepad pitch only without a Rift sensor.
+    ViewerMotion::Rates rates;
+    rates.yaw = GamepadRotate.x;
+    rates.pitch = 0.0f;
+    rates.freePitch = !m_sensorActive;
+    if (rates.freePitch)
     {
-        OVR::Matrix4f yawRotate = OVR::Matrix4f::RotationY(EyeYaw);
-        OVR::Vector3f orientationVector = yawRotate.Transform(KeyboardMove);
-        orientationVector *= MoveSpeed * dt;
-        EyePos += orientationVector;
+        rates.yaw += MouseRotate.x;
+        rates.pitch = GamepadRotate.y + MouseRotate.y;
     }
+    rates.move = (GamepadMove + MouseMove + KeyboardMove) * MoveSpeed;
+
+    m_motion.Advance(rates, dt);
+
+    const ViewerMotion::Pose pose = m_motion.GetInterpolatedPose();
+    EyePos = pose.pos;
+    EyeYaw = pose.yaw;
+    EyePitch = pose.pitch;
 }
 
 /// From the OVR SDK.
 void OculusAppSkeleton::AssembleViewMatrix()
 {
+    PROFILE_ZONE("AssembleViewMatrix");
     // Rotate and position m_oculusView Camera, using YawPitchRoll in BodyFrame coordinates.
     // 
     OVR::Matrix4f rollPitchYaw = GetRollPitchYaw();
@@ -409,18 +583,18 @@ void OculusAppSkeleton::keyboard(int key, int action, int x, int y)
     if ((key > -1) && (key <= GLFW_KEY_LAST))
     {
         m_keyStates[key] = action;
-        printf("key ac  %d %d\n", key, action);
+        LOG_DEBUG("key ac  %d %d", key, action);
     }
 
     if (key == GLFW_KEY_LEFT_SHIFT)
     {
         if (action == GLFW_PRESS)
         {
-            EyePos.y = m_crouchingHeight;
+            m_pendingEyeHeight = m_crouchingHeight;
         }
         else if (action == GLFW_RELEASE)
         {
-            EyePos.y = m_standingHeight;
+            m_pendingEyeHeight = m_standingHeight;
         }
     }
 
@@ -432,15 +606,13 @@ void OculusAppSkeleton::keyboard(int key, int action, int x, int y)
     switch (key)
     {
     case 'Z':
-        m_displaySceneInControl = !m_displaySceneInControl;
+        m_controlViewMode = (ControlViewMode)((m_controlViewMode + 1) % ControlView_Count);
         break;
 
     default:
-        printf("%d: %c\n", key, (char)key);
+        LOG_DEBUG("%d: %c", key, (char)key);
         break;
     }
-
-    fflush(stdout);
 }
 
 void OculusAppSkeleton::resize(int w, int h)
@@ -455,53 +627,351 @@ void OculusAppSkeleton::resize(int w, int h)
 /// Handle animations, joystick states and viewing matrix
 void OculusAppSkeleton::timestep(float dt)
 {
-    m_scene.m_phaseVal += dt;
+    // During replay the recording stands in for every live device, and the
+    // timestep is fixed so the run does not depend on how fast frames come out.
+    // Drained even in replay so the queue cannot fill up.
+    ConsumeJoystickEvents();
+
+    InputRecorder::Frame input;
+    if (m_inputRecorder.IsReplaying())
+    {
+        dt = m_inputRecorder.GetReplayDt();
+        if (m_inputRecorder.NextFrame(input))
+        {
+            ApplyRecordedInput(input);
+        }
+        else
+        {
+            // Recording exhausted: hold the last head pose and stop moving.
+            GamepadMove = GamepadRotate = OVR::Vector3f(0,0,0);
+            MouseMove = MouseRotate = OVR::Vector3f(0,0,0);
+            KeyboardMove = KeyboardRotate = OVR::Vector3f(0,0,0);
+            m_pendingEyeHeight = -1.0f;
+        }
+    }
+    else
+    {
+        HandleKeyboardMovement();
+        SampleHeadOrientation();
+        if (m_inputRecorder.IsRecording())
+        {
+            CaptureInput(input, dt);
+            m_inputRecorder.RecordFrame(input);
+        }
+    }
+
+    // Held back from the input handlers to here so a recording carries it.
+    if (m_pendingEyeHeight >= 0.0f)
+    {
+        m_motion.SetHeight(m_pendingEyeHeight);
+        m_pendingEyeHeight = -1.0f;
+    }
+
+    m_phase += dt;
+    m_simTime += dt;
+
+    // Scene animation does not depend on input, so it runs on the job system
+    // while this thread handles input and the view.
+    JobCounter animated;
+    const EntityAnimation::Bounce bounce = m_scene.GetAnimation(m_entities, m_phase);
+    EntityAnimation::AnimateBounce(m_jobs, bounce, animated);
 
     const float frequency = 5.0f;
     const float amplitude = 0.2f;
 
-    HandleGlfwJoystick();
-    HandleKeyboardMovement();
+    // The sample's timestamp follows it down the pipeline to the swap.
     AccumulateInputs(dt);
+    m_inputsNs = HighResClock::NowNanoseconds();
     AssembleViewMatrix();
-    m_ok.UpdateEyeParams();
+    m_viewNs = HighResClock::NowNanoseconds();
+    m_jobs.Wait(animated);
+    PublishFrameState();
+}
+
+void OculusAppSkeleton::SetStreamView(int stream, int width, int height, OVRkill::DisplayMode mode)
+{
+    if ((stream < 0) || (stream >= FrameState::MaxStreams))
+        return;
+    FrameState::StreamView& sv = m_streamViews[stream];
+    sv.width = width;
+    sv.height = height;
+    sv.mode = mode;
+}
+
+/// Hand this timestep's results to the render side of each window.
+void OculusAppSkeleton::PublishFrameState()
+{
+    FrameState& fs = m_frameStates[0].GetWriteBuffer();
+    fs.oculusView = m_oculusView;
+    fs.controlView = m_controlView;
+    fs.headRotation = GetRollPitchYaw();
+    fs.eyePos = EyePos;
+    fs.phase = m_phase;
+    const int cubeCount = (m_entities.GetCount() < Scene::NumCubes) ? m_entities.GetCount() : Scene::NumCubes;
+    fs.cubeCount = cubeCount;
+    if (cubeCount > 0)
+    {
+        memcpy(fs.cubeX, m_entities.PosX(), cubeCount*sizeof(float));
+        memcpy(fs.cubeY, m_entities.PosY(), cubeCount*sizeof(float));
+        memcpy(fs.cubeZ, m_entities.PosZ(), cubeCount*sizeof(float));
+        memcpy(fs.cubeScale, m_entities.Scale(), cubeCount*sizeof(float));
+    }
+    fs.windowWidth = m_windowWidth;
+    fs.windowHeight = m_windowHeight;
+    fs.controlViewMode = m_controlViewMode;
+    fs.thirdPersonInterval = m_thirdPersonInterval;
+    for (int w=0; w<Window_Count; ++w)
+    {
+        fs.windowTargetFps[w] = m_windowTargetFps[w];
+        fs.windowSwapInterval[w] = m_windowSwapInterval[w];
+    }
+    fs.bufferGutterPx = m_bufferGutterPx;
+    fs.flattenStereo = m_flattenStereo;
+    fs.viewAngleDeg = m_viewAngleDeg;
+    fs.sortDraws = m_sortDraws;
+    fs.multiDraw = m_multiDraw;
+    fs.riftDist = m_riftDist;
+    fs.sampleNs = m_poseSampleNs;
+    fs.inputsNs = m_inputsNs;
+    fs.viewNs = m_viewNs;
+
+    // Only the timesteps a render thread picks up are logged, from there.
+    fs.eventFrame = EventLog::Instance().BeginFrame();
+    fs.simTime = m_simTime;
+    // Same composition as GetRollPitchYaw
+    const OVR::Quatf orient =
+        OVR::Quatf(UpVector, EyeYaw) *
+        OVR::Quatf(RightVector, EyePitch) *
+        OVR::Quatf(OVR::Vector3f(0.0f, 0.0f, 1.0f), EyeRoll);
+    fs.headOrientation[0] = orient.x;
+    fs.headOrientation[1] = orient.y;
+    fs.headOrientation[2] = orient.z;
+    fs.headOrientation[3] = orient.w;
+    const OVR::Vector3f* inputs[EventLog::Input_Count] = {
+        &GamepadMove, &GamepadRotate, &MouseMove, &MouseRotate, &KeyboardMove
+    };
+    for (int i=0; i<EventLog::Input_Count; ++i)
+    {
+        fs.inputs[i][0] = inputs[i]->x;
+        fs.inputs[i][1] = inputs[i]->y;
+        fs.inputs[i][2] = inputs[i]->z;
+    }
+
+    for (int i=0; i<FrameState::MaxStreams; ++i)
+    {
+        fs.streams[i] = m_streamViews[i];
+    }
+    for (int w=1; w<Window_Count; ++w)
+    {
+        m_frameStates[w].GetWriteBuffer() = fs;
+        m_frameStates[w].Publish();
+    }
+    m_frameStates[0].Publish();
+}
+
+///@brief Render side of the HMD window, after display and before its swap:
+/// copy the frame for the control window when that is showing a mirror.
+void OculusAppSkeleton::PublishMirrorFrame(int width, int height)
+{
+    const FrameState& fs = GetFrameState(Window_Oculus);
+    if (fs.controlViewMode != ControlView_Mirror)
+        return;
+    PROFILE_ZONE("PublishMirror");
+    const float scale = m_windowResolutionScale[Window_Control];
+    m_mirror.Publish(width, height, (int)(scale * (float)fs.windowWidth), (int)(scale * (float)fs.windowHeight));
+}
+
+/// Called on the render side of window w, with its context current, before
+/// drawing each frame. If the simulation has not published since last time,
+/// the previous snapshot is drawn again.
+///@param hmdView True for the window showing the HMD view, whose latency is measured
+///@return true if the snapshot is new
+bool OculusAppSkeleton::AcquireFrameState(GpuWindow w, bool hmdView)
+{
+    const bool fresh = m_frameStates[w].Acquire();
+    const FrameState& fs = m_frameStates[w].GetReadBuffer();
+
+    const unsigned int resizeRequests = m_fboResizeRequests.load();
+    if (resizeRequests != m_fboGeneration[w])
+    {
+        m_fboGeneration[w] = resizeRequests;
+        m_ok.CreateRenderBuffer(m_bufferScaleUp, w, m_windowResolutionScale[w]);
+        if (w == Window_Control)
+            m_controlFramesSinceDraw = 0;
+    }
+
+    if (hmdView)
+    {
+        // A repeated snapshot still counts: its sample is what reaches the screen.
+        m_latency.BeginFrame(fs.sampleNs);
+        m_latency.MarkAt(LatencyTester::Stage_Inputs, fs.inputsNs);
+        m_latency.MarkAt(LatencyTester::Stage_View, fs.viewNs);
+        if (fresh)
+            LogInputsAndPose(fs);
+    }
+    return fresh;
+}
+
+///@brief HMD render side, once per new snapshot: record the frame, its input
+/// vectors and the head pose they produced. Logging here rather than in
+/// timestep keeps one set of records per displayed frame, however often the
+/// simulation runs, and stamps them with the frame the swap will carry.
+void OculusAppSkeleton::LogInputsAndPose(const FrameState& fs)
+{
+    EventLog& events = EventLog::Instance();
+    if (!events.IsOpen())
+        return;
+
+    events.LogFrame(fs.eventFrame, (float)(fs.simTime - m_eventLogSimTime));
+    m_eventLogSimTime = fs.simTime;
+    events.LogInput(fs.eventFrame, fs.inputs);
+    const float pos[3] = { fs.eyePos.x, fs.eyePos.y, fs.eyePos.z };
+    events.LogHeadPose(fs.eventFrame, fs.headOrientation, pos, fs.sampleNs);
+}
+
+
+/// Called once per frame of the window showing the HMD view, before display.
+void OculusAppSkeleton::frameStart()
+{
+    m_frameScheduler.OnFrameStart(HighResClock::NowNanoseconds());
+    UpdateGpuTrace();
+    WriteGpuTrace();
+}
+
+/// Open or close the trace file to match the latest SetGpuTraceEnabled request.
+void OculusAppSkeleton::UpdateGpuTrace()
+{
+    const bool enable = m_gpuTraceRequested.load();
+    if (enable == (m_pGpuTrace != NULL))
+        return;
+
+    if (!enable)
+    {
+        fclose(m_pGpuTrace);
+        m_pGpuTrace = NULL;
+        return;
+    }
+
+    const char* filename = "gputimes.csv";
+    m_pGpuTrace = fopen(filename, "w");
+    if (m_pGpuTrace == NULL)
+    {
+        LOG_WARNING("Could not open %s for writing; GPU trace disabled.", filename);
+        // Otherwise every frame would try again.
+        m_gpuTraceRequested.store(false);
+        return;
+    }
+    m_traceFrame = 0;
+
+    const char* windowNames[Window_Count] = { "ctrl", "hmd" };
+    const char* passNames[Pass_Count] = { "scene_left", "scene_right", "scene_mono", "present", "tweakbar" };
+    fprintf(m_pGpuTrace, "frame");
+    for (int w=0; w<Window_Count; ++w)
+    {
+        for (int p=0; p<Pass_Count; ++p)
+        {
+            fprintf(m_pGpuTrace, ",%s_%s_ms", windowNames[w], passNames[p]);
+        }
+    }
+    fprintf(m_pGpuTrace, "\n");
+}
+
+/// Append one row of the most recently resolved GPU pass times.
+///@note Query results arrive a frame or two late, so each row holds the
+/// latest available sample for each pass rather than this exact frame's.
+void OculusAppSkeleton::WriteGpuTrace()
+{
+    if (m_pGpuTrace == NULL)
+        return;
+
+    fprintf(m_pGpuTrace, "%u", m_traceFrame++);
+    for (int w=0; w<Window_Count; ++w)
+    {
+        for (int p=0; p<Pass_Count; ++p)
+        {
+            fprintf(m_pGpuTrace, ",%.4f", m_gpuTimers[w][p].GetLastMs());
+        }
+    }
+    fprintf(m_pGpuTrace, "\n");
 }
 
 
 ///////////////////////////////////////////////////////////////////////////////
 
 
-/// Render avatar of Oculus user
-void OculusAppSkeleton::DrawFrustumAvatar(const OVR::Matrix4f& mview, const OVR::Matrix4f& persp) const
+/// OVR matrices are row major; GL takes them column major.
+static void StoreTransposed(float* pDst, const OVR::Matrix4f& m)
+{
+    for (int c=0; c<4; ++c)
+    {
+        for (int r=0; r<4; ++r)
+        {
+            pDst[4*c + r] = m.M[r][c];
+        }
+    }
+}
+
+/// Render avatar of Oculus user, with the mono view's camera block bound.
+/// Its lines are streamed through the window's dynamic vertex buffer.
+void OculusAppSkeleton::DrawFrustumAvatar(const FrameState& fs, GpuWindow w) const
 {
+    StreamingBuffer& stream = m_dynamicVertices[w];
+    const int vertCount = OriginLineVertices + ViewFrustumLineVertices;
+    GLintptr offset = 0;
+    LineVertex* pVerts = (LineVertex*)stream.Allocate(vertCount * sizeof(LineVertex), offset);
+    if (pVerts == NULL)
+        return;
+    const float aspect = (float)GetOculusWidth() / (float)GetOculusHeight();
+    const int originVerts = WriteOriginLines(pVerts);
+    WriteViewFrustum(pVerts + originVerts, aspect);
+    stream.Flush();
+
     //if (UseFollowCam)
-    const GLuint prog = m_avatarProg;
+    const GLuint prog = m_avatarProg[w];
     glUseProgram(prog);
     {
-        OVR::Matrix4f rollPitchYaw = GetRollPitchYaw();
-        OVR::Matrix4f eyetx = mview
-            * OVR::Matrix4f::Translation(EyePos.x, EyePos.y, EyePos.z)
-            * rollPitchYaw;
-
-        glUniformMatrix4fv(getUniLoc(prog, "mvmtx"), 1, false, &eyetx.Transposed().M[0][0]);
-        glUniformMatrix4fv(getUniLoc(prog, "prmtx"), 1, false, &persp.Transposed().M[0][0]);
+        const OVR::Matrix4f headtx =
+            OVR::Matrix4f::Translation(fs.eyePos.x, fs.eyePos.y, fs.eyePos.z)
+            * fs.headRotation;
+        float mdl[16];
+        StoreTransposed(mdl, headtx);
+        glUniformMatrix4fv(getUniLoc(prog, "mdlmtx"), 1, false, mdl);
+
+        const GLsizei stride = sizeof(LineVertex);
+        glBindBuffer(GL_ARRAY_BUFFER, stream.GetBuffer());
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, stride, (const GLvoid*)offset);
+        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, stride, (const GLvoid*)(offset + 3*sizeof(float)));
+        glEnableVertexAttribArray(0);
+        glEnableVertexAttribArray(1);
 
         glLineWidth(4.0f);
-        DrawOriginLines();
-        const float aspect = (float)GetOculusWidth() / (float)GetOculusHeight();
-        DrawViewFrustum(aspect);
+        glDrawArrays(GL_LINES, 0, vertCount);
         glLineWidth(1.0f);
+
+        glDisableVertexAttribArray(0);
+        glDisableVertexAttribArray(1);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
     }
 }
 
-void OculusAppSkeleton::DrawScene(bool stereo, OVRkill::DisplayMode mode) const
+void OculusAppSkeleton::DrawScene(const FrameState& fs, GpuWindow w, bool stereo, OVRkill::DisplayMode mode, GpuTimer* pPassTimers) const
 {
     glClearColor(0.3f, 0.4f, 0.5f, 0);
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-    const int fboWidth = m_ok.GetRenderBufferWidth();
-    const int fboHeight = m_ok.GetRenderBufferHeight();
+    const FBO& fbo = m_ok.GetRenderBuffer(w);
+    const int fboWidth = (int)fbo.w;
+    const int fboHeight = (int)fbo.h;
     const int halfWidth = fboWidth/2;
+
+    {
+        PROFILE_ZONE("PrepareSceneDraws");
+        m_scene.UpdateTransforms(fs.cubeX, fs.cubeY, fs.cubeZ, fs.cubeScale, fs.cubeCount, w);
+        m_scene.BuildDrawCommands(fs.sortDraws, fs.multiDraw, w);
+    }
+    StreamingBuffer& dynamicVertices = m_dynamicVertices[w];
+    dynamicVertices.BeginFrame();
+
     if (stereo)
     {
         const OVR::HMDInfo& hmd = m_ok.GetHMD();
@@ -528,15 +998,25 @@ void OculusAppSkeleton::DrawScene(bool stereo, OVRkill::DisplayMode mode) const
 
         // m_oculusView transformation translation in world units.
         float halfIPD = hmd.InterpupillaryDistance * 0.5f;
-        if (m_flattenStereo)
+        if (fs.flattenStereo)
             halfIPD = 0.0f;
-        OVR::Matrix4f viewLeft = OVR::Matrix4f::Translation(halfIPD, 0, 0) * m_oculusView;
-        OVR::Matrix4f viewRight= OVR::Matrix4f::Translation(-halfIPD, 0, 0) * m_oculusView;
-
-        const float* pViewLeft  = &viewLeft.Transposed().M[0][0];
-        const float* pViewRight = &viewRight.Transposed().M[0][0];
-        const float* pProjLeft  = &projLeft.Transposed().M[0][0];
-        const float* pProjRight = &projRight.Transposed().M[0][0];
+        OVR::Matrix4f viewLeft = OVR::Matrix4f::Translation(halfIPD, 0, 0) * fs.oculusView;
+        OVR::Matrix4f viewRight= OVR::Matrix4f::Translation(-halfIPD, 0, 0) * fs.oculusView;
+
+        // Both eyes' matrices go into this frame's camera blocks, transposed
+        // to GL's column major order on the way, before either eye draws.
+        UniformRing& cameras = m_cameraUniforms[w];
+        cameras.BeginFrame();
+        Scene::Camera* pLeft  = (Scene::Camera*)cameras.GetBlock(CameraBlock_Left);
+        Scene::Camera* pRight = (Scene::Camera*)cameras.GetBlock(CameraBlock_Right);
+        if ((pLeft != NULL) && (pRight != NULL))
+        {
+            StoreTransposed(pLeft->view,  viewLeft);
+            StoreTransposed(pLeft->proj,  projLeft);
+            StoreTransposed(pRight->view, viewRight);
+            StoreTransposed(pRight->proj, projRight);
+        }
+        cameras.Flush();
 
         ///@note Scissoring out the fragments near the periphery of the FOV should (hopefully)
         /// result in higher performance by having to draw fewer pixels.
@@ -544,59 +1024,116 @@ void OculusAppSkeleton::DrawScene(bool stereo, OVRkill::DisplayMode mode) const
         /// *before* execution of the fragment shader.
         glEnable(GL_SCISSOR_TEST);
         {
-            const GLsizei g = m_bufferGutterPx;
+            const GLsizei g = fs.bufferGutterPx;
 
             glViewport(0          , 0, (GLsizei)halfWidth     , (GLsizei)fboHeight     );
             glScissor (g          , g, (GLsizei)halfWidth -2*g, (GLsizei)fboHeight -2*g);
-            m_scene.RenderForOneEye(pViewLeft, pProjLeft);
+            {
+                PROFILE_ZONE("DrawScene left");
+                pPassTimers[Pass_SceneLeft].Begin();
+                cameras.BindBlock(CameraBlock_Left, Scene::CameraBinding);
+                m_scene.RenderForOneEye(w);
+                pPassTimers[Pass_SceneLeft].End();
+            }
 
             glViewport(halfWidth  , 0, (GLsizei)halfWidth     , (GLsizei)fboHeight     );
             glScissor (halfWidth+g, g, (GLsizei)halfWidth -2*g, (GLsizei)fboHeight -2*g);
-            m_scene.RenderForOneEye(pViewRight, pProjRight);
+            {
+                PROFILE_ZONE("DrawScene right");
+                pPassTimers[Pass_SceneRight].Begin();
+                cameras.BindBlock(CameraBlock_Right, Scene::CameraBinding);
+                m_scene.RenderForOneEye(w);
+                pPassTimers[Pass_SceneRight].End();
+            }
         }
         glDisable(GL_SCISSOR_TEST);
+        cameras.EndFrame();
     }
     else
     {
         /// Set up our 3D transformation matrices
         /// Remember DX and OpenGL use transposed conventions. And doesn't DX use left-handed coords?
-        OVR::Matrix4f mview = m_controlView;
+        OVR::Matrix4f mview = fs.controlView;
         OVR::Matrix4f persp = OVR::Matrix4f::PerspectiveRH(
-            m_viewAngleDeg * (float)M_PI / 180.0f,
-            (float)m_windowWidth/(float)m_windowHeight,
+            fs.viewAngleDeg * (float)M_PI / 180.0f,
+            (float)fs.windowWidth/(float)fs.windowHeight,
             0.004f,
             500.0f);
 
-        const float* pMview = &mview.Transposed().M[0][0];
-        const float* pPersp = &persp.Transposed().M[0][0];
+        UniformRing& cameras = m_cameraUniforms[w];
+        cameras.BeginFrame();
+        Scene::Camera* pCamera = (Scene::Camera*)cameras.GetBlock(CameraBlock_Left);
+        if (pCamera != NULL)
+        {
+            StoreTransposed(pCamera->view, mview);
+            StoreTransposed(pCamera->proj, persp);
+        }
+        cameras.Flush();
+        cameras.BindBlock(CameraBlock_Left, Scene::CameraBinding);
 
         glViewport(0,0,(GLsizei)fboWidth, (GLsizei)fboHeight);
-        m_scene.RenderForOneEye(pMview, pPersp);
+        PROFILE_ZONE("DrawScene mono");
+        pPassTimers[Pass_SceneMono].Begin();
+        m_scene.RenderForOneEye(w);
 
-        DrawFrustumAvatar(mview, persp);
+        DrawFrustumAvatar(fs, w);
+        pPassTimers[Pass_SceneMono].End();
+        cameras.EndFrame();
     }
+    dynamicVertices.EndFrame();
 }
 
 /// Set up view matrices, then draw scene
 void OculusAppSkeleton::display(bool isControl, OVRkill::DisplayMode mode) const
 {
-    /// This may save us some frame rate
-    if (isControl && !m_displaySceneInControl)
+    const GpuWindow window = isControl ? Window_Control : Window_Oculus;
+    const FrameState& fs = GetFrameState(window);
+    GpuTimer* pPassTimers = m_gpuTimers[window];
+
+    bool drawScene = true;
+    if (isControl)
     {
-        glClearColor(0.3f, 0.4f, 0.5f, 0);
-        glClear(GL_COLOR_BUFFER_BIT);
-        return;
+        /// This may save us some frame rate
+        if (fs.controlViewMode == ControlView_None)
+        {
+            m_controlFramesSinceDraw = 0;
+            glClearColor(0.3f, 0.4f, 0.5f, 0);
+            glClear(GL_COLOR_BUFFER_BIT);
+            return;
+        }
+
+        // Until the HMD window publishes a frame, fall through to the third person view.
+        if (fs.controlViewMode == ControlView_Mirror)
+        {
+            PROFILE_ZONE("PresentMirror");
+            pPassTimers[Pass_Present].Begin();
+            const bool mirrored = m_mirror.Present(fs.windowWidth, fs.windowHeight);
+            pPassTimers[Pass_Present].End();
+            if (mirrored)
+            {
+                m_controlFramesSinceDraw = 0;
+                return;
+            }
+        }
+
+        // Between third person redraws, present the last one again.
+        drawScene = (m_controlFramesSinceDraw == 0);
+        const unsigned int interval = (fs.thirdPersonInterval > 1) ? fs.thirdPersonInterval : 1;
+        m_controlFramesSinceDraw = (m_controlFramesSinceDraw + 1) % interval;
     }
 
     glEnable(GL_DEPTH_TEST);
 
-    m_ok.BindRenderBuffer();
+    if (drawScene)
     {
-        bool useStereo = (mode == OVRkill::Stereo) ||
-                         (mode == OVRkill::StereoWithDistortion);
-        DrawScene(useStereo, mode);
+        m_ok.BindRenderBuffer(window);
+        {
+            bool useStereo = (mode == OVRkill::Stereo) ||
+                             (mode == OVRkill::StereoWithDistortion);
+            DrawScene(fs, window, useStereo, mode, pPassTimers);
+        }
+        m_ok.UnBindRenderBuffer();
     }
-    m_ok.UnBindRenderBuffer();
 
     glDisable(GL_LIGHTING);
     glDisable(GL_DEPTH_TEST);
@@ -607,5 +1144,8 @@ void OculusAppSkeleton::display(bool isControl, OVRkill::DisplayMode mode) const
         post = OVRkill::PostProcess_Distortion;
     }
 
-    m_ok.PresentFbo(post, m_riftDist);
+    PROFILE_ZONE("PresentFbo");
+    pPassTimers[Pass_Present].Begin();
+    m_ok.PresentFbo(post, fs.riftDist, window);
+    pPassTimers[Pass_Present].End();
 }
@@ -12,6 +12,7 @@
 #  include <windows.h>
 #endif
 #include <stdlib.h>
+#include <stdio.h>
 #include <GL/glew.h>
 
 #include <GLFW/glfw3.h>
@@ -27,15 +28,117 @@
 
 #include "AppSkeleton.h"
 #include "Scene.h"
+#include "ViewerMotion.h"
 #include "OVRkill.h"
+#include "SimulatedHmd.h"
 #include "Timer.h"
+#include "GpuTimer.h"
+#include "LatencyTester.h"
+#include "FrameScheduler.h"
+#include "FrameFenceQueue.h"
+#include "InputRecorder.h"
+#include "JoystickPoller.h"
+#include "GamepadMapping.h"
+#include "MirrorTexture.h"
+#include "UniformRing.h"
+#include "StreamingBuffer.h"
+#include "TripleBuffer.h"
+#include "JobSystem.h"
+#include "EventLog.h"
+
+#include <atomic>
 
 ///@brief Encapsulates as much of the VR viewer state as possible,
 /// pushing all viewer-independent stuff to Scene.
 /// display takes a bool to indicate Oculus window or Control.
+///
+/// The app runs on two sides that may be on different threads: input and
+/// simulation (event callbacks, timestep) and rendering (AcquireFrameState,
+/// frameStart, display). timestep ends by publishing a FrameState snapshot;
+/// the render side draws only from the latest snapshot it acquired. Changes
+/// requested from the input side that touch GL, like an FBO resize, are
+/// deferred to the render side.
+///
+/// Each window renders from its own context, possibly on its own thread, so
+/// the render side is per window: every window has its own snapshot, render
+/// buffer and programs. frameStart is only for the window showing the HMD view.
 class OculusAppSkeleton : public AppSkeleton
 {
 public:
+    /// Render passes instrumented with GPU timer queries
+    enum GpuPass
+    {
+        Pass_SceneLeft,
+        Pass_SceneRight,
+        Pass_SceneMono,
+        Pass_Present,
+        Pass_TweakBar,
+        Pass_Count
+    };
+    enum GpuWindow
+    {
+        Window_Control,
+        Window_Oculus,
+        Window_Count
+    };
+
+    /// What the control window shows; Z cycles through them.
+    enum ControlViewMode
+    {
+        ControlView_ThirdPerson, ///< Follow cam render, redrawn every m_thirdPersonInterval frames
+        ControlView_Mirror,      ///< Copy of the HMD window's image
+        ControlView_None,
+        ControlView_Count
+    };
+
+    /// Everything display needs from the simulation, copied once per timestep.
+    struct FrameState
+    {
+        enum { MaxStreams = 4 };
+        struct StreamView
+        {
+            int width;
+            int height;
+            OVRkill::DisplayMode mode;
+        };
+
+        OVR::Matrix4f oculusView;
+        OVR::Matrix4f controlView;
+        OVR::Matrix4f headRotation; ///< GetRollPitchYaw, for the avatar
+        OVR::Vector3f eyePos;
+        float phase;
+        int   cubeCount;            ///< Animated cube entities, as of this timestep
+        float cubeX[Scene::NumCubes];
+        float cubeY[Scene::NumCubes];
+        float cubeZ[Scene::NumCubes];
+        float cubeScale[Scene::NumCubes];
+        int   windowWidth;          ///< Control window size for the mono projection
+        int   windowHeight;
+        ControlViewMode controlViewMode;
+        int   thirdPersonInterval;
+        /// Settings the input side may change at any time, e.g. from the tweakbar
+        float windowTargetFps[Window_Count];
+        int   windowSwapInterval[Window_Count];
+        int   bufferGutterPx;
+        bool  flattenStereo;
+        float viewAngleDeg;
+        bool  sortDraws;
+        bool  multiDraw;
+        RiftDistortionParams riftDist;
+        unsigned long long sampleNs; ///< Latency stamps of the sample the views came from
+        unsigned long long inputsNs;
+        unsigned long long viewNs;
+        StreamView streams[MaxStreams];
+
+        /// For the event log, which the HMD render side writes once per new snapshot
+        unsigned int eventFrame;  ///< EventLog frame number of the timestep
+        double simTime;           ///< Simulated seconds since startup
+        float  headOrientation[4]; ///< x,y,z,w
+        float  inputs[EventLog::Input_Count][3];
+
+        FrameState();
+    };
+
     OculusAppSkeleton();
     virtual ~OculusAppSkeleton();
 
@@ -47,8 +150,19 @@ public:
     virtual void resize(int w, int h);
     virtual bool initVR(bool fullScreen);
     virtual bool initJoysticks();
+    void LoadGamepadMappings(const char* filename);
     virtual bool initGL(int argc, char **argv);
+    virtual void initWindowGL(GpuWindow w);
+    virtual void destroyWindowGL(GpuWindow w);
     virtual void timestep(float dt);
+    virtual void frameStart();
+
+    /// Input side: window size and display mode of each output stream, published with the next timestep.
+    void SetStreamView(int stream, int width, int height, OVRkill::DisplayMode mode);
+    /// Render side: pick up the newest snapshot and apply deferred GL changes.
+    bool AcquireFrameState(GpuWindow w, bool hmdView);
+    const FrameState& GetFrameState(GpuWindow w) const { return m_frameStates[w].GetReadBuffer(); }
+    void PublishMirrorFrame(int width, int height);
 
     void SetBufferScaleUp(float s) { m_bufferScaleUp = s; }
     void ResetEyePosition()
@@ -57,15 +171,89 @@ public:
         EyeYaw = YawInitial;
         EyePitch = 0;
         EyeRoll = 0;
+        ViewerMotion::Pose pose;
+        pose.pos = EyePos;
+        pose.yaw = EyeYaw;
+        pose.pitch = EyePitch;
+        m_motion.Reset(pose);
     }
     float GetEyeHeight() const { return EyePos.y; }
-    void SetEyeHeight(float h) { EyePos.y = h; }
+    void SetEyeHeight(float h) { m_pendingEyeHeight = h; EyePos.y = h; }
+
+    /// Threads besides the caller's that timestep's jobs may use; 0 runs them inline.
+    void SetJobWorkers(int workerThreads) { m_jobs.Start(workerThreads); }
+    int  GetJobWorkers() const { return m_jobs.GetWorkerCount(); }
+
+    /// Fixed simulation step rate for viewer motion; 1kHz by default.
+    void SetSimulationRate(float hz) { m_motion.SetStepRate(hz); }
 
     int GetOculusWidth() const { return m_ok.GetOculusWidth(); }
     int GetOculusHeight() const { return m_ok.GetOculusHeight(); }
     float GetBufferScaleUp() const { return m_bufferScaleUp; }
-    float GetMegaPixelCount() const;
-    void ResizeFbo();
+    float GetMegaPixelCount() const; ///< Control window render side
+    void ResizeFbo() { m_fboResizeRequests.fetch_add(1); }
+
+    /// A window other than the HMD's can run slower and at a lower resolution,
+    /// e.g. a 20Hz half-resolution spectator view. 0 fps means no limit.
+    /// Input side; the render side reads FrameState::windowTargetFps.
+    void SetWindowTargetFps(GpuWindow w, float fps) { m_windowTargetFps[w] = fps; }
+    float GetWindowTargetFps(GpuWindow w) const { return m_windowTargetFps[w]; }
+    void SetWindowResolutionScale(GpuWindow w, float scale) { m_windowResolutionScale[w] = scale; ResizeFbo(); }
+    float GetWindowResolutionScale(GpuWindow w) const { return m_windowResolutionScale[w]; }
+
+    /// Vsync per window. main applies a change in the window's own context,
+    /// from FrameState::windowSwapInterval.
+    void SetWindowSwapInterval(GpuWindow w, int interval) { m_windowSwapInterval[w] = interval; }
+    int GetWindowSwapInterval(GpuWindow w) const { return m_windowSwapInterval[w]; }
+
+    /// How many frames each window may queue ahead of the GPU, 1 to 3.
+    /// main waits for a slot before each frame and fences it after the swap.
+    void SetMaxFramesInFlight(int frames)
+    {
+        for (int i=0; i<Window_Count; ++i)
+            m_frameFences[i].SetMaxFramesInFlight(frames);
+    }
+    int GetMaxFramesInFlight() const { return m_frameFences[Window_Control].GetMaxFramesInFlight(); }
+    void WaitForFrameSlot(GpuWindow w) { m_frameFences[w].WaitForSlot(); }
+    void OnFrameSwapped(GpuWindow w) { m_frameFences[w].OnFrameSubmitted(); }
+    const FrameFenceQueue& GetFrameFences(GpuWindow w) const { return m_frameFences[w]; }
+
+    /// Paces the window showing the HMD view; fed by frameStart and the hooks below.
+    FrameScheduler& GetFrameScheduler() { return m_frameScheduler; }
+    const FrameScheduler& GetFrameScheduler() const { return m_frameScheduler; }
+
+    const GpuTimer& GetGpuTimer(GpuWindow w, GpuPass p) const { return m_gpuTimers[w][p]; }
+
+    void SetGpuTraceEnabled(bool enable) { m_gpuTraceRequested.store(enable); }
+    bool GetGpuTraceEnabled() const { return m_gpuTraceRequested.load(); }
+
+    /// Call before initVR to use a simulated headset instead of looking for a Rift.
+    void SetSimulatedHmd(const SimulatedHmdParams& params)
+    {
+        m_useSimulatedHmd = true;
+        m_simulatedHmdParams = params;
+    }
+
+    /// Motion-to-photon measurement of the window showing the HMD view.
+    /// main calls the hooks around that window's SwapBuffers on the render side.
+    void SetLatencyTestEnabled(bool enable) { m_latency.SetEnabled(enable); }
+    bool GetLatencyTestEnabled() const { return m_latency.IsEnabled(); }
+    const LatencyTester& GetLatencyTester() const { return m_latency; }
+    void OnHmdFrameSubmitted()
+    {
+        m_frameScheduler.OnFrameSubmitted(HighResClock::NowNanoseconds());
+        m_latency.Mark(LatencyTester::Stage_Submit);
+    }
+    void OnHmdFrameSwapped()
+    {
+        // Before the latency tester, which may wait on the GPU.
+        m_frameScheduler.OnSwapped(HighResClock::NowNanoseconds());
+        m_latency.OnSwapped();
+    }
+
+    bool StartInputRecording(const char* filename) { return m_inputRecorder.StartRecording(filename); }
+    bool StartInputReplay(const char* filename, float fixedDt=0.0f);
+    bool IsInputReplayFinished() const { return m_inputRecorder.IsReplayFinished(); }
 
     OVR::Matrix4f GetRollPitchYaw() const {
         return OVR::Matrix4f::RotationY(EyeYaw) *
@@ -74,13 +262,22 @@ public:
     }
 
 protected:
-    void HandleGlfwJoystick();
+    void ConsumeJoystickEvents();
+    void SelectGamepad();
+    void GetGamepadVectors(const JoystickState& pad, OVR::Vector3f& move, OVR::Vector3f& rotate) const;
     void HandleKeyboardMovement();
+    void SampleHeadOrientation();
+    void CaptureInput(InputRecorder::Frame& frame, float dt) const;
+    void ApplyRecordedInput(const InputRecorder::Frame& frame);
     void AccumulateInputs(float dt);
     void AssembleViewMatrix();
+    void LogInputsAndPose(const FrameState& fs);
+    void PublishFrameState();
 
-    void DrawFrustumAvatar(const OVR::Matrix4f& mview, const OVR::Matrix4f& persp) const;
-    void DrawScene(bool stereo, OVRkill::DisplayMode mode=OVRkill::SingleEye) const;
+    void DrawFrustumAvatar(const FrameState& fs, GpuWindow w) const;
+    void DrawScene(const FrameState& fs, GpuWindow w, bool stereo, OVRkill::DisplayMode mode, GpuTimer* pPassTimers) const;
+    void UpdateGpuTrace();
+    void WriteGpuTrace();
 
     /// VR view parameters
     const OVR::Vector3f UpVector;
@@ -91,26 +288,48 @@ protected:
     const float  MoveSpeed;
     const float  m_standingHeight;
     const float  m_crouchingHeight;
-    OVR::Vector3f EyePos;
+    OVR::Vector3f EyePos;   ///< Eye pose as drawn: m_motion's interpolated pose
     float EyeYaw;
     float EyePitch;
     float EyeRoll;
     float LastSensorYaw;
+    ViewerMotion m_motion;
+    unsigned long long m_poseSampleNs; ///< When the sensor (or other input without one) was last read
+    bool m_sensorActive;   ///< Whether m_hmdOrient holds a sensor reading this frame
+    OVR::Quatf m_hmdOrient;
     OVR::Vector3f FollowCamDisplacement;
     OVR::Vector3f FollowCamPos;
+    float m_pendingEyeHeight; ///< Set between timesteps, recorded and applied by the next; negative for none
     float m_viewAngleDeg; ///< For the no HMD case
 
     OVR::Matrix4f  m_oculusView; /// World modelview matrix for Oculus
     OVR::Matrix4f  m_controlView; /// World modelview matrix for Control window
+    float m_phase;                ///< Scene animation time
+    double m_simTime;             ///< Simulated time, never reset
+    double m_eventLogSimTime;     ///< HMD render side: simTime of the last logged snapshot
+    EntityStore m_entities;       ///< The scene's animated objects, updated in timestep
+    JobSystem   m_jobs;           ///< Simulation side work, fanned out from timestep
+    unsigned long long m_inputsNs; ///< When AccumulateInputs applied m_poseSampleNs
+    unsigned long long m_viewNs;   ///< When AssembleViewMatrix built the views from it
+
+    /// Simulation to render handoff, one consumer per window
+    TripleBuffer<FrameState>  m_frameStates[Window_Count];
+    FrameState::StreamView    m_streamViews[FrameState::MaxStreams];
+    std::atomic<unsigned int> m_fboResizeRequests;
+    unsigned int              m_fboGeneration[Window_Count]; ///< Requests each window's buffer is current with
 
     /// Viewing parameters fed in from joystick and the HMD
     OVR::Vector3f  GamepadMove, GamepadRotate;
     OVR::Vector3f  MouseMove, MouseRotate;
     OVR::Vector3f  KeyboardMove, KeyboardRotate;
 
-    /// For choosing one connected joystick
-    int preferredGamepadID;
-    bool swapGamepadRAxes;
+    /// Joysticks as rebuilt from the poll thread's events, and the one chosen
+    JoystickPoller m_joystickPoller;
+    JoystickState  m_joysticks[JoystickPoller::MaxJoysticks];
+    unsigned long long m_joystickIntegratedNs; ///< Gamepad motion is accounted for up to here
+    int preferredGamepadID; ///< -1 for none
+    GamepadMapping         m_gamepadMapping;
+    GamepadMapping::Remap  m_gamepadRemap; ///< The chosen pad's layout
 
     /// Mouse motion internal state
     int oldx, oldy, newx, newy;
@@ -119,15 +338,40 @@ protected:
     int m_keyStates[GLFW_KEY_LAST];
 
     OVRkill m_ok;
+    bool m_useSimulatedHmd;
+    SimulatedHmdParams m_simulatedHmdParams;
+    InputRecorder m_inputRecorder;
+    LatencyTester m_latency;
+    FrameScheduler m_frameScheduler;
+    FrameFenceQueue m_frameFences[Window_Count];
     RiftDistortionParams  m_riftDist;
     float m_bufferScaleUp;
+    float m_windowTargetFps[Window_Count];
+    float m_windowResolutionScale[Window_Count]; ///< Applied on top of m_bufferScaleUp
+    int   m_windowSwapInterval[Window_Count];
     int   m_bufferGutterPx;
     bool  m_flattenStereo;
+    bool  m_sortDraws; ///< Sort draw packets by state before replay
+    bool  m_multiDraw; ///< Replay draws with multi-draw indirect where supported
 
     Scene   m_scene;
 
-    GLuint m_avatarProg;
-    bool   m_displaySceneInControl;
+    GLuint m_avatarProg[Window_Count];
+
+    /// Scene::Camera blocks per frame, one per eye; mono views use the first.
+    enum { CameraBlock_Left, CameraBlock_Right, CameraBlock_Count };
+    mutable UniformRing m_cameraUniforms[Window_Count];
+    mutable StreamingBuffer m_dynamicVertices[Window_Count]; ///< Lines and other per-frame geometry
+    ControlViewMode m_controlViewMode;
+    int    m_thirdPersonInterval;
+    mutable unsigned int m_controlFramesSinceDraw; ///< Control window render side only
+    mutable MirrorTexture m_mirror; ///< HMD window to control window
+
+    /// GPU pass timings, one set per window since query objects are per-context.
+    mutable GpuTimer m_gpuTimers[Window_Count][Pass_Count];
+    FILE*        m_pGpuTrace; ///< CSV trace of per-pass GPU times, NULL when disabled
+    std::atomic<bool> m_gpuTraceRequested; ///< Opened/closed on the render side
+    unsigned int m_traceFrame;
 
 
 private: // Disallow copy ctor and assignment operator
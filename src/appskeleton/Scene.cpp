@@ -12,6 +12,7 @@
 #  include <windows.h>
 #endif
 #include <stdlib.h>
+#include <string.h>
 #include <GL/glew.h>
 
 #ifdef USE_CUDA
@@ -20,6 +21,7 @@
 #endif
 
 #include "MatrixMath.h"
+#include "EntityAnimation.h"
 
 #define _USE_MATH_DEFINES
 #include <math.h>
@@ -27,60 +29,219 @@
 #include "Logger.h"
 
 Scene::Scene()
-: m_progBasic(0)
-, m_progPlane(0)
-, m_phaseVal(0.0f)
-, m_cubeScale(1.0f)
+: m_cubeScale(1.0f)
 , m_amplitude(1.0f)
 {
+    for (int i=0; i<MaxContexts; ++i)
+    {
+        for (int p=0; p<Program_Count; ++p)
+        {
+            m_programs[i][p] = 0;
+            m_multiDrawPrograms[i][p] = 0;
+        }
+        m_vertexBuffer[i] = 0;
+        m_indexBuffer[i] = 0;
+        m_vertexArray[i] = 0;
+        m_indirectBuffer[i] = 0;
+        m_transformBuffer[i] = 0;
+        m_drawIdBuffer[i] = 0;
+        m_drawIdCapacity[i] = 0;
+        memset(&m_drawStats[i], 0, sizeof(DrawStats));
+        BuildGraph(m_graph[i]);
+    }
+    memset(m_meshes, 0, sizeof(m_meshes));
 }
 
 Scene::~Scene()
 {
-    glDeleteProgram(m_progBasic);
-    glDeleteProgram(m_progPlane);
+    for (int i=0; i<MaxContexts; ++i)
+    {
+        for (int p=0; p<Program_Count; ++p)
+        {
+            glDeleteProgram(m_programs[i][p]);
+            glDeleteProgram(m_multiDrawPrograms[i][p]);
+        }
+        glDeleteBuffers(1, &m_vertexBuffer[i]);
+        glDeleteBuffers(1, &m_indexBuffer[i]);
+        glDeleteBuffers(1, &m_indirectBuffer[i]);
+        glDeleteBuffers(1, &m_transformBuffer[i]);
+        glDeleteBuffers(1, &m_drawIdBuffer[i]);
+        if (m_vertexArray[i] != 0)
+            glDeleteVertexArrays(1, &m_vertexArray[i]);
+    }
 }
 
-void Scene::initGL()
+/// Call with the given context current.
+void Scene::initGL(int context)
 {
-    m_progBasic = makeShaderByName("basic");
-    m_progPlane = makeShaderByName("basicplane");
+    m_programs[context][Program_Basic] = makeShaderByName("basic");
+    m_programs[context][Program_Plane] = makeShaderByName("basicplane");
+    for (int p=0; p<Program_Count; ++p)
+    {
+        bindUniformBlock(m_programs[context][p], "Camera", CameraBinding);
+    }
+    CreateMeshBuffers(context);
+    InitMultiDraw(context);
 }
 
-/// Draw an RGB color cube
-void Scene::DrawColorCube() const
+///@brief Floor and ceiling planes, and a ring of color cubes that bounce.
+/// Only the bob nodes change from frame to frame; the scale nodes below them
+/// change only when m_cubeScale does. Node indices are the same in every
+/// context's graph.
+void Scene::BuildGraph(SceneGraph& graph)
 {
-    const float3 minPt = {0,0,0};
-    const float3 maxPt = {1,1,1};
-    const float3 verts[] = {
-        minPt,
-        {maxPt.x, minPt.y, minPt.z},
-        {maxPt.x, maxPt.y, minPt.z},
-        {minPt.x, maxPt.y, minPt.z},
-        {minPt.x, minPt.y, maxPt.z},
-        {maxPt.x, minPt.y, maxPt.z},
-        maxPt,
-        {minPt.x, maxPt.y, maxPt.z}
+    graph.Clear();
+    const int root = graph.AddNode(SceneGraph::NoParent);
+
+    graph.AddNode(root, Drawable_Plane);
+    const int ceiling = graph.AddNode(root, Drawable_Plane);
+    const float ceilHeight = 3.0f;
+    graph.SetTranslation(ceiling, 0.0f, ceilHeight, 0.0f);
+
+    const int ring = graph.AddNode(root);
+    for (int i=0; i<NumCubes; ++i)
+    {
+        m_cubeBobNode[i] = graph.AddNode(ring);
+        m_cubeScaleNode[i] = graph.AddNode(m_cubeBobNode[i], Drawable_ColorCube);
+    }
+    graph.UpdateWorld();
+}
+
+///@brief Every mesh in one vertex buffer and one index buffer, with one
+/// vertex layout: a position and a second attribute, the color for the cube
+/// and the texture coordinate for the plane. Indices are stored already
+/// offset to their mesh's first vertex, so any mesh draws from the same
+/// bindings with nothing but a different range.
+void Scene::CreateMeshBuffers(int context)
+{
+    struct Vertex
+    {
+        float pos[3];
+        float attr[3];
     };
-    const uint3 quads[] = {
-        {0,3,2}, {1,0,2}, // ccw
-        {4,5,6}, {7,4,6},
-        {1,2,6}, {5,1,6},
-        {2,3,7}, {6,2,7},
-        {3,0,4}, {7,3,4},
-        {0,1,5}, {4,0,5},
+    const Vertex verts[] = {
+        // Plane: position, texture coordinate
+        {{-10.0f, 0.0f, -10.0f}, {0.0f, 0.0f, 0.0f}},
+        {{-10.0f, 0.0f,  10.0f}, {1.0f, 0.0f, 0.0f}},
+        {{ 10.0f, 0.0f,  10.0f}, {1.0f, 1.0f, 0.0f}},
+        {{ 10.0f, 0.0f, -10.0f}, {0.0f, 1.0f, 0.0f}},
+        // RGB color cube: position, color
+        {{0,0,0}, {0,0,0}},
+        {{1,0,0}, {1,0,0}},
+        {{1,1,0}, {1,1,0}},
+        {{0,1,0}, {0,1,0}},
+        {{0,0,1}, {0,0,1}},
+        {{1,0,1}, {1,0,1}},
+        {{1,1,1}, {1,1,1}},
+        {{0,1,1}, {0,1,1}},
     };
+    const GLuint planeBase = 0;
+    const GLuint cubeBase = 4;
+    const GLuint indices[] = {
+        // Plane, 2 triangles, ccw
+        planeBase+0, planeBase+3, planeBase+2,
+        planeBase+1, planeBase+0, planeBase+2,
+        // Cube, 6 triangle pairs, ccw
+        cubeBase+0, cubeBase+3, cubeBase+2,  cubeBase+1, cubeBase+0, cubeBase+2,
+        cubeBase+4, cubeBase+5, cubeBase+6,  cubeBase+7, cubeBase+4, cubeBase+6,
+        cubeBase+1, cubeBase+2, cubeBase+6,  cubeBase+5, cubeBase+1, cubeBase+6,
+        cubeBase+2, cubeBase+3, cubeBase+7,  cubeBase+6, cubeBase+2, cubeBase+7,
+        cubeBase+3, cubeBase+0, cubeBase+4,  cubeBase+7, cubeBase+3, cubeBase+4,
+        cubeBase+0, cubeBase+1, cubeBase+5,  cubeBase+4, cubeBase+0, cubeBase+5,
+    };
+
+    m_meshes[Mesh_Plane].mode = GL_TRIANGLES;
+    m_meshes[Mesh_Plane].firstIndex = 0;
+    m_meshes[Mesh_Plane].indexCount = 3*2;
+    m_meshes[Mesh_ColorCube].mode = GL_TRIANGLES;
+    m_meshes[Mesh_ColorCube].firstIndex = 3*2;
+    m_meshes[Mesh_ColorCube].indexCount = 6*3*2;
 
+    glGenBuffers(1, &m_vertexBuffer[context]);
+    glBindBuffer(GL_ARRAY_BUFFER, m_vertexBuffer[context]);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(verts), verts, GL_STATIC_DRAW);
     glBindBuffer(GL_ARRAY_BUFFER, 0);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, verts);
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 0, verts);
+
+    glGenBuffers(1, &m_indexBuffer[context]);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_indexBuffer[context]);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STATIC_DRAW);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+
+    // Vertex arrays are not shared between contexts, so each has its own.
+    if (GLEW_VERSION_3_0 || GLEW_ARB_vertex_array_object)
+    {
+        glGenVertexArrays(1, &m_vertexArray[context]);
+        glBindVertexArray(m_vertexArray[context]);
+        SetVertexPointers(context);
+        glBindVertexArray(0);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    }
+}
+
+void Scene::SetVertexPointers(int context) const
+{
+    const GLsizei stride = 6*sizeof(float);
+    glBindBuffer(GL_ARRAY_BUFFER, m_vertexBuffer[context]);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_indexBuffer[context]);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, stride, (const GLvoid*)0);
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, stride, (const GLvoid*)(3*sizeof(float)));
     glEnableVertexAttribArray(0);
     glEnableVertexAttribArray(1);
+}
 
-    glDrawElements(GL_TRIANGLES,
-                   6*3*2, // 6 triangle pairs
-                   GL_UNSIGNED_INT,
-                   &quads[0]);
+///@brief Programs and buffers for the multi-draw indirect replay, if the
+/// context has GL 4.3 and a vertex array to keep the draw id attribute in.
+/// Leaves the multi-draw programs 0 otherwise, and the replay per draw.
+void Scene::InitMultiDraw(int context)
+{
+    if (!GLEW_VERSION_4_3 || (m_vertexArray[context] == 0))
+    {
+        LOG_INFO("Scene context %d: no GL 4.3, drawing without multi-draw indirect.", context);
+        return;
+    }
+
+    GLuint programs[Program_Count];
+    programs[Program_Basic] = makeShaderByName("basic_mdi");
+    programs[Program_Plane] = makeShaderByName("basicplane_mdi");
+    bool linked = true;
+    for (int p=0; p<Program_Count; ++p)
+    {
+        GLint status = GL_FALSE;
+        glGetProgramiv(programs[p], GL_LINK_STATUS, &status);
+        linked = linked && (status == GL_TRUE);
+    }
+    if (!linked)
+    {
+        LOG_INFO("Scene context %d: multi-draw shaders did not link, drawing without multi-draw indirect.", context);
+        for (int p=0; p<Program_Count; ++p)
+        {
+            glDeleteProgram(programs[p]);
+        }
+        return;
+    }
+
+    glGenBuffers(1, &m_indirectBuffer[context]);
+    glGenBuffers(1, &m_transformBuffer[context]);
+    glGenBuffers(1, &m_drawIdBuffer[context]);
+
+    // One instance per command, and each command's base instance is its own
+    // index, so this attribute reads as the index of the draw. The buffer
+    // grows with the packet count; the vertex array keeps pointing at it.
+    ReserveDrawIds(64, context);
+    glBindVertexArray(m_vertexArray[context]);
+    glBindBuffer(GL_ARRAY_BUFFER, m_drawIdBuffer[context]);
+    glVertexAttribIPointer(2, 1, GL_UNSIGNED_INT, sizeof(GLuint), (const GLvoid*)0);
+    glVertexAttribDivisor(2, 1);
+    glEnableVertexAttribArray(2);
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    for (int p=0; p<Program_Count; ++p)
+    {
+        bindUniformBlock(programs[p], "Camera", CameraBinding);
+        m_multiDrawPrograms[context][p] = programs[p];
+    }
 }
 
 /// Utility function to draw colored line segments along unit x,y,z axes
@@ -112,106 +273,252 @@ void Scene::DrawOrigin() const
                    &lines[0]);
 }
 
-/// Draw a circle of color cubes(why not)
-void Scene::_DrawBouncingCubes(const float* pMview) const
+/// A ring of cubes, each a little further into the bounce cycle than the last.
+void Scene::InitEntities(EntityStore& store) const
 {
-    float sinmtx[16];
-    const int numCubes = 12;
-    for (int i=0; i<numCubes; ++i)
+    store.Clear();
+    store.Reserve(NumCubes);
+    for (int i=0; i<NumCubes; ++i)
     {
         const float radius = 15.0f;
-        const float posPhase = 2.0f * (float)M_PI * (float)i / (float)numCubes;
-        const float3 cubePosition = {radius * sin(posPhase), 0.0f, radius * cos(posPhase)};
-
-        const float frequency = 3.0f;
-        const float amplitude = m_amplitude;
-        float oscVal = amplitude * sin(frequency * (m_phaseVal + posPhase));
-
-        memcpy(sinmtx, pMview, 16*sizeof(float));
-        glhTranslate(sinmtx, cubePosition.x, oscVal, cubePosition.z);
+        const float posPhase = 2.0f * (float)M_PI * (float)i / (float)NumCubes;
+        store.Add(radius * sin(posPhase), 0.0f, radius * cos(posPhase), posPhase, m_cubeScale);
+    }
+}
 
-        const float scale = m_cubeScale;
-        glhScale(sinmtx, scale, scale, scale);
+///@brief Simulation side, once per timestep: the bounce update for the
+/// current animation parameters.
+///@param phase Animation time in seconds
+EntityAnimation::Bounce Scene::GetAnimation(EntityStore& store, float phase) const
+{
+    const float frequency = 3.0f;
+    const EntityAnimation::Bounce bounce = { &store, phase, m_amplitude, frequency, m_cubeScale };
+    return bounce;
+}
 
-        glUniformMatrix4fv(getUniLoc(m_progBasic, "mvmtx"), 1, false, sinmtx);
-        DrawColorCube();
+///@brief Move the cubes to the animated entity positions and bring the world
+/// matrices up to date. Call from the thread that draws with the given
+/// context, once per frame.
+///@return The number of nodes whose world matrix was recomputed
+int Scene::UpdateTransforms(const float* pX, const float* pY, const float* pZ, const float* pScale, int count, int context) const
+{
+    SceneGraph& graph = m_graph[context];
+    if (count > NumCubes)
+        count = NumCubes;
+    for (int i=0; i<count; ++i)
+    {
+        graph.SetTranslation(m_cubeBobNode[i], pX[i], pY[i], pZ[i]);
+        graph.SetScale(m_cubeScaleNode[i], pScale[i]);
     }
+    return graph.UpdateWorld();
 }
 
-
-void DrawPlane()
+///@brief Fill this context's command buffer with a packet for every drawable
+/// node and sort it. Call once per frame after UpdateTransforms; both eyes
+/// replay the same packets.
+///@param sortDraws Sort packets by state before replay
+///@param multiDraw Replay with multi-draw indirect where supported
+void Scene::BuildDrawCommands(bool sortDraws, bool multiDraw, int context) const
 {
-    const float3 minPt = {-10.0f, 0.0f, -10.0f};
-    const float3 maxPt = {10.0f, 0.0f, 10.0f};
-    const float3 verts[] = {
-        minPt.x, minPt.y, minPt.z,
-        minPt.x, minPt.y, maxPt.z,
-        maxPt.x, minPt.y, maxPt.z,
-        maxPt.x, minPt.y, minPt.z,
-    };
-    const float2 texs[] = {
-        0.0f, 0.0f,
-        1.0f, 0.0f,
-        1.0f, 1.0f,
-        0.0f, 1.0f,
-    };
-    const uint3 quads[] = {
-        {0,3,2}, {1,0,2}, // ccw
-    };
+    const SceneGraph& graph = m_graph[context];
+    DrawCommandBuffer& commands = m_commands[context];
+    commands.Clear();
 
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, verts);
-    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 0, texs);
-    glEnableVertexAttribArray(0);
-    glEnableVertexAttribArray(1);
+    const int count = graph.GetNodeCount();
+    for (int i=0; i<count; ++i)
+    {
+        switch (graph.GetDrawable(i))
+        {
+        default:
+            break;
+        case Drawable_Plane:
+            commands.Add(0, Program_Plane, Material_Checker, Mesh_Plane, i);
+            break;
+        case Drawable_ColorCube:
+            commands.Add(0, Program_Basic, Material_VertexColor, Mesh_ColorCube, i);
+            break;
+        }
+    }
 
-    glDrawElements(GL_TRIANGLES,
-                   3*2, // 2 triangle pairs
-                   GL_UNSIGNED_INT,
-                   &quads[0]);
+    DrawStats& stats = m_drawStats[context];
+    stats.packets = commands.GetCount();
+    stats.unsortedChanges = commands.CountStateChanges().Total();
+    stats.sorted = sortDraws ? 1 : 0;
+    if (sortDraws)
+        commands.Sort();
+    stats.sortedChanges = commands.CountStateChanges().Total();
+    stats.frameStateChanges = 0;
+    stats.frameDraws = 0;
+
+    // Decided once per frame so both eyes replay the same way.
+    stats.multiDraw = (multiDraw && IsMultiDrawSupported(context)) ? 1 : 0;
+    if (stats.multiDraw != 0)
+        UploadMultiDraw(context);
+}
 
-    glDisableVertexAttribArray(0);
-    glDisableVertexAttribArray(1);
+/// Make the draw id buffer hold at least count ids.
+void Scene::ReserveDrawIds(int count, int context) const
+{
+    if (count <= m_drawIdCapacity[context])
+        return;
+
+    int capacity = 2 * m_drawIdCapacity[context];
+    if (capacity < count)
+        capacity = count;
+    std::vector<GLuint> ids(capacity);
+    for (int i=0; i<capacity; ++i)
+    {
+        ids[i] = i;
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, m_drawIdBuffer[context]);
+    glBufferData(GL_ARRAY_BUFFER, capacity*sizeof(GLuint), &ids[0], GL_STATIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    m_drawIdCapacity[context] = capacity;
 }
 
-void Scene::_DrawScenePlanes(const float* pMview) const
+///@brief An indirect command and a world matrix per packet, in packet order,
+/// uploaded for both eyes to draw from.
+void Scene::UploadMultiDraw(int context) const
 {
-    DrawPlane(); // matrix uniform is already set by caller
+    const SceneGraph& graph = m_graph[context];
+    const DrawCommandBuffer& commands = m_commands[context];
+    std::vector<DrawElementsIndirectCommand>& indirect = m_indirectCommands[context];
+    std::vector<float>& transforms = m_drawTransforms[context];
+
+    const int count = commands.GetCount();
+    if (count == 0)
+        return;
+    indirect.resize(count);
+    transforms.resize(16 * count);
+    for (int i=0; i<count; ++i)
+    {
+        const DrawCommandBuffer::Packet& packet = commands.Get(i);
+        const MeshRange& mesh = m_meshes[DrawCommandBuffer::GetMesh(packet.key)];
+        DrawElementsIndirectCommand& cmd = indirect[i];
+        cmd.count = mesh.indexCount;
+        cmd.instanceCount = 1;
+        cmd.firstIndex = mesh.firstIndex;
+        cmd.baseVertex = 0; // Indices are stored already offset
+        cmd.baseInstance = i;
+        memcpy(&transforms[16*i], graph.GetWorld(packet.transform), 16*sizeof(float));
+    }
 
-    float mv[16];
-    memcpy(mv, pMview, 16*sizeof(float));
-    const float ceilHeight = 3.0f;
-    glhTranslate(mv, 0.0f, ceilHeight, 0.0f);
+    ReserveDrawIds(count, context);
 
-    glUniformMatrix4fv(getUniLoc(m_progBasic, "mvmtx"), 1, false, mv);
-    DrawPlane();
+    // Respecifying the whole store lets the driver hand back fresh memory
+    // instead of waiting on last frame's draws.
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, m_indirectBuffer[context]);
+    glBufferData(GL_DRAW_INDIRECT_BUFFER, count*sizeof(DrawElementsIndirectCommand), &indirect[0], GL_STREAM_DRAW);
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_transformBuffer[context]);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, transforms.size()*sizeof(float), &transforms[0], GL_STREAM_DRAW);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
 }
 
-
-/// Draw the scene(matrices have already been set up).
-void Scene::DrawScene(const float* pMview, const float* pPersp) const
+///@brief Draw this context's packets for one eye, through multi-draw
+/// indirect if BuildDrawCommands set it up for this frame. The eye's Camera
+/// block must be bound at CameraBinding.
+///@param context Index of the calling context's programs, as passed to initGL
+void Scene::RenderForOneEye(int context) const
 {
-    glUseProgram(m_progPlane);
-    {
-        glUniformMatrix4fv(getUniLoc(m_progPlane, "mvmtx"), 1, false, pMview);
-        glUniformMatrix4fv(getUniLoc(m_progPlane, "prmtx"), 1, false, pPersp);
-
-        _DrawScenePlanes(pMview);
-    }
+    DrawStats& stats = m_drawStats[context];
+
+    if (m_vertexArray[context] != 0)
+        glBindVertexArray(m_vertexArray[context]);
+    else
+        SetVertexPointers(context);
+    ++stats.frameStateChanges;
+
+    if (stats.multiDraw != 0)
+        ReplayMultiDraw(context);
+    else
+        ReplayPerDraw(context);
     glUseProgram(0);
 
-    glUseProgram(m_progBasic);
+    // Leave client-side arrays usable for the avatar and the present pass.
+    if (m_vertexArray[context] != 0)
     {
-        glUniformMatrix4fv(getUniLoc(m_progBasic, "mvmtx"), 1, false, pMview);
-        glUniformMatrix4fv(getUniLoc(m_progBasic, "prmtx"), 1, false, pPersp);
-
-        _DrawBouncingCubes(pMview);
+        glBindVertexArray(0);
     }
-    glUseProgram(0);
+    else
+    {
+        glDisableVertexAttribArray(0);
+        glDisableVertexAttribArray(1);
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
 }
 
+///@brief Replay the sorted packets, changing only the state that differs from
+/// the packet before. Each packet's world matrix goes in the model matrix
+/// uniform.
+void Scene::ReplayPerDraw(int context) const
+{
+    const SceneGraph& graph = m_graph[context];
+    const DrawCommandBuffer& commands = m_commands[context];
+    DrawStats& stats = m_drawStats[context];
+
+    // Materials have no uniforms of their own yet, so only the program and
+    // the bindings above are state; meshes differ only in their index range.
+    int program = -1;
+    GLint mdlLoc = -1;
+    const int count = commands.GetCount();
+    for (int i=0; i<count; ++i)
+    {
+        const DrawCommandBuffer::Packet& packet = commands.Get(i);
+        const int packetProgram = DrawCommandBuffer::GetProgram(packet.key);
+        if (packetProgram != program)
+        {
+            program = packetProgram;
+            const GLuint prog = m_programs[context][program];
+            glUseProgram(prog);
+            mdlLoc = getUniLoc(prog, "mdlmtx");
+            ++stats.frameStateChanges;
+        }
+
+        const MeshRange& mesh = m_meshes[DrawCommandBuffer::GetMesh(packet.key)];
+        glUniformMatrix4fv(mdlLoc, 1, false, graph.GetWorld(packet.transform));
+        glDrawElements(mesh.mode, mesh.indexCount, GL_UNSIGNED_INT,
+            (const GLvoid*)(mesh.firstIndex * sizeof(GLuint)));
+        ++stats.frameDraws;
+    }
+}
 
-void Scene::RenderForOneEye(const float* pMview, const float* pPersp) const
+///@brief One glMultiDrawElementsIndirect per run of packets that share a
+/// program and primitive mode. World matrices come from the transform
+/// buffer, so nothing is set per packet.
+void Scene::ReplayMultiDraw(int context) const
 {
-    DrawScene(pMview, pPersp);
+    const DrawCommandBuffer& commands = m_commands[context];
+    DrawStats& stats = m_drawStats[context];
+
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, m_indirectBuffer[context]);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, m_transformBuffer[context]);
+
+    const int count = commands.GetCount();
+    int first = 0;
+    while (first < count)
+    {
+        const unsigned long long key = commands.Get(first).key;
+        const int program = DrawCommandBuffer::GetProgram(key);
+        const GLenum mode = m_meshes[DrawCommandBuffer::GetMesh(key)].mode;
+        int end = first + 1;
+        while ((end < count) &&
+            (DrawCommandBuffer::GetProgram(commands.Get(end).key) == program) &&
+            (m_meshes[DrawCommandBuffer::GetMesh(commands.Get(end).key)].mode == mode))
+        {
+            ++end;
+        }
+
+        glUseProgram(m_multiDrawPrograms[context][program]);
+        ++stats.frameStateChanges;
+
+        glMultiDrawElementsIndirect(mode, GL_UNSIGNED_INT,
+            (const GLvoid*)(first * sizeof(DrawElementsIndirectCommand)), end - first, 0);
+        ++stats.frameDraws;
+        first = end;
+    }
+
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, 0);
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
 }
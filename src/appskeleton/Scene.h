@@ -8,35 +8,161 @@
 #  include <windows.h>
 #endif
 #include <stdlib.h>
+#include <vector>
 #include <GL/glew.h>
 
+#include "SceneGraph.h"
+#include "EntityAnimation.h"
+#include "DrawCommandBuffer.h"
+
 ///@brief The Scene class renders everything in the VR world that will be the same
 /// in the Oculus and Control windows. The RenderForOneEye function is the display entry point.
+///@note Windows may render concurrently from their own contexts. Programs are
+/// shared between contexts but their uniform values are not per-context, so
+/// each context gets its own copies, selected by the context index.
+/// The same goes for the scene graph, since each window animates to the phase
+/// of the frame it is drawing. Call UpdateTransforms once per frame, then
+/// RenderForOneEye for each eye; the world matrices are shared by both eyes.
+/// Every program reads the eye's view and projection from the Camera uniform
+/// block, which the caller binds at CameraBinding before each eye.
+///
+/// Drawing goes through a command buffer per context. BuildDrawCommands
+/// emits a packet per drawable node and sorts them by state. RenderForOneEye
+/// replays them from one shared vertex array, binding a program only when
+/// it changes.
+///
+/// On GL 4.3 contexts the replay can instead go through multi-draw indirect:
+/// BuildDrawCommands also writes an indirect command per packet and its
+/// world matrix to a storage buffer, and RenderForOneEye issues one
+/// glMultiDrawElementsIndirect per run of packets sharing a program. The
+/// CPU cost of a replay is then per program, not per draw.
+///
+/// The cubes are entities: the simulation side owns an EntityStore made by
+/// InitEntities and runs the animation from GetAnimation on it once per timestep. The renderer gets
+/// the resulting positions through UpdateTransforms.
 class Scene
 {
 public:
+    enum { MaxContexts = 2 };
+    enum { NumCubes = 12 };
+    enum { CameraBinding = 0 }; ///< Uniform buffer binding point of the Camera block
+
+    /// The Camera uniform block as laid out by std140: column major matrices
+    struct Camera
+    {
+        float view[16];
+        float proj[16];
+    };
+
+    /// Values of the drawable tag on scene graph nodes
+    enum Drawable
+    {
+        Drawable_Plane,
+        Drawable_ColorCube
+    };
+
+    /// Ids that go into draw packet keys
+    enum Program
+    {
+        Program_Plane,
+        Program_Basic,
+        Program_Count
+    };
+    enum Material
+    {
+        Material_Checker,
+        Material_VertexColor
+    };
+    enum Mesh
+    {
+        Mesh_Plane,
+        Mesh_ColorCube,
+        Mesh_Count
+    };
+
+    /// Per context, for one frame. Change counts are program, material and
+    /// mesh switches for one eye's replay, in the order the packets were
+    /// emitted and in sorted order. The frame totals are what the replays
+    /// actually did for every eye.
+    struct DrawStats
+    {
+        int packets;
+        int unsortedChanges;
+        int sortedChanges;
+        int frameStateChanges; ///< Program and vertex array binds
+        int frameDraws;        ///< GL draw calls, indirect or not
+        int sorted;            ///< 1 if the packets were replayed in sorted order
+        int multiDraw;         ///< 1 if the replay went through multi-draw indirect
+    };
+
     Scene();
     virtual ~Scene();
 
-    void initGL();
-    void RenderForOneEye(const float* pMview, const float* pPersp) const;
+    void initGL(int context=0);
+    void InitEntities(EntityStore& store) const;
+    EntityAnimation::Bounce GetAnimation(EntityStore& store, float phase) const;
+    int  UpdateTransforms(const float* pX, const float* pY, const float* pZ, const float* pScale, int count, int context=0) const;
+    void BuildDrawCommands(bool sortDraws, bool multiDraw, int context=0) const;
+    void RenderForOneEye(int context=0) const;
+
+    /// Render side of the given context only
+    const DrawStats& GetDrawStats(int context) const { return m_drawStats[context]; }
+    bool IsMultiDrawSupported(int context) const { return m_multiDrawPrograms[context][0] != 0; }
 
 protected:
-    void DrawColorCube() const;
+    /// A mesh's range in the shared index buffer
+    struct MeshRange
+    {
+        GLenum  mode;
+        GLuint  firstIndex;
+        GLsizei indexCount;
+    };
+
+    /// Layout fixed by glMultiDrawElementsIndirect
+    struct DrawElementsIndirectCommand
+    {
+        GLuint count;
+        GLuint instanceCount;
+        GLuint firstIndex;
+        GLuint baseVertex;
+        GLuint baseInstance;
+    };
+
+    void BuildGraph(SceneGraph& graph);
+    void CreateMeshBuffers(int context);
+    void SetVertexPointers(int context) const;
+    void InitMultiDraw(int context);
+    void ReserveDrawIds(int count, int context) const;
+    void UploadMultiDraw(int context) const;
+    void ReplayPerDraw(int context) const;
+    void ReplayMultiDraw(int context) const;
     void DrawGrid() const;
     void DrawOrigin() const;
-    void DrawScene(const float* pMview, const float* pPersp) const;
 
-protected:
-    void _DrawBouncingCubes(const float* pMview) const;
-    void _DrawScenePlanes(const float* pMview) const;
+    GLuint    m_programs[MaxContexts][Program_Count];
+    GLuint    m_vertexBuffer[MaxContexts];
+    GLuint    m_indexBuffer[MaxContexts];
+    GLuint    m_vertexArray[MaxContexts]; ///< 0 without vertex array object support
+    MeshRange m_meshes[Mesh_Count];       ///< The same in every context
+
+    /// Multi-draw indirect; programs are 0 where the context lacks GL 4.3
+    GLuint m_multiDrawPrograms[MaxContexts][Program_Count];
+    GLuint m_indirectBuffer[MaxContexts];
+    GLuint m_transformBuffer[MaxContexts]; ///< World matrices in packet order
+    GLuint m_drawIdBuffer[MaxContexts];    ///< 0,1,2... read per instance as the draw id
+    mutable int m_drawIdCapacity[MaxContexts];
 
-    GLuint m_progBasic;
-    GLuint m_progPlane;
+    /// Render side: written by the thread drawing with each context
+    mutable SceneGraph m_graph[MaxContexts];
+    int m_cubeBobNode[NumCubes];   ///< Position on the ring and bounce height
+    int m_cubeScaleNode[NumCubes]; ///< Child of the bob node, draws the cube
+    mutable DrawCommandBuffer m_commands[MaxContexts];
+    mutable DrawStats         m_drawStats[MaxContexts];
+    mutable std::vector<DrawElementsIndirectCommand> m_indirectCommands[MaxContexts];
+    mutable std::vector<float>                       m_drawTransforms[MaxContexts];
 
 public:
     /// Scene animation state
-    float m_phaseVal;
     float m_cubeScale;
     float m_amplitude;
 
@@ -0,0 +1,106 @@
+// SceneGraph.cpp
+
+#include "SceneGraph.h"
+
+#include <string.h>
+#include "MatrixMath.h"
+
+SceneGraph::SceneGraph()
+{
+}
+
+SceneGraph::~SceneGraph()
+{
+}
+
+void SceneGraph::Clear()
+{
+    m_parent.clear();
+    m_drawable.clear();
+    m_dirty.clear();
+    m_updated.clear();
+    m_local.clear();
+    m_world.clear();
+}
+
+///@brief Append a node with an identity transform.
+///@param parent An existing node, or NoParent
+///@return The new node's index, or -1 if parent does not exist yet
+int SceneGraph::AddNode(int parent, int drawable)
+{
+    const int node = GetNodeCount();
+    if (parent >= node)
+        return -1;
+
+    m_parent.push_back(parent < 0 ? (int)NoParent : parent);
+    m_drawable.push_back(drawable);
+    m_dirty.push_back(1);
+    m_updated.push_back(0);
+
+    float id[16];
+    MakeIdentityMatrix(id);
+    m_local.insert(m_local.end(), id, id+16);
+    m_world.insert(m_world.end(), id, id+16);
+    return node;
+}
+
+/// Marks the node dirty only if the transform differs from the current one,
+/// so callers can set every frame without forcing an update.
+void SceneGraph::SetLocal(int node, const float* pMtx)
+{
+    float* pLocal = &m_local[16*node];
+    if (!memcmp(pLocal, pMtx, 16*sizeof(float)))
+        return;
+    memcpy(pLocal, pMtx, 16*sizeof(float));
+    m_dirty[node] = 1;
+}
+
+void SceneGraph::SetTranslation(int node, float x, float y, float z)
+{
+    const float3 t = {x, y, z};
+    float mtx[16];
+    MakeTranslationMatrix(mtx, t);
+    SetLocal(node, mtx);
+}
+
+void SceneGraph::SetScale(int node, float s)
+{
+    float mtx[16];
+    MakeIdentityMatrix(mtx);
+    glhScale(mtx, s, s, s);
+    SetLocal(node, mtx);
+}
+
+///@brief Recompute the world matrices of dirty nodes and their descendants.
+///@return The number of nodes recomputed
+int SceneGraph::UpdateWorld()
+{
+    const int count = GetNodeCount();
+    int updated = 0;
+    for (int i=0; i<count; ++i)
+    {
+        const int parent = m_parent[i];
+        const bool parentUpdated = (parent != NoParent) && m_updated[parent];
+        if (!m_dirty[i] && !parentUpdated)
+        {
+            m_updated[i] = 0;
+            continue;
+        }
+
+        float* pWorld = &m_world[16*i];
+        const float* pLocal = &m_local[16*i];
+        if (parent == NoParent)
+        {
+            memcpy(pWorld, pLocal, 16*sizeof(float));
+        }
+        else
+        {
+            memcpy(pWorld, &m_world[16*parent], 16*sizeof(float));
+            postMultiply(pWorld, pLocal);
+        }
+        m_dirty[i] = 0;
+        m_updated[i] = 1;
+        ++updated;
+    }
+    return updated;
+}
@@ -0,0 +1,52 @@
+// SceneGraph.h
+
+#pragma once
+
+#include <vector>
+
+///@brief A transform hierarchy kept in flat arrays, parents before children.
+///
+/// Each node has a local transform and a cached world transform, both column
+/// major 4x4 as GL expects. Setting a local transform marks the node dirty.
+/// UpdateWorld recomputes world matrices in one pass over the arrays in
+/// order. A node is recomputed if it is dirty or if its parent was recomputed
+/// in this pass. Because a parent always comes before its children, a change
+/// reaches its whole subtree in that same pass, and nodes that did not change
+/// are skipped. World matrices hold no view transform, so both eyes and both
+/// windows share them, and the view is applied when drawing.
+///
+/// The drawable of a node is a tag for the owner to use; the graph does not
+/// draw anything.
+class SceneGraph
+{
+public:
+    enum { NoParent = -1, NoDrawable = -1 };
+
+    SceneGraph();
+    virtual ~SceneGraph();
+
+    void Clear();
+    int  AddNode(int parent, int drawable=NoDrawable);
+
+    void SetLocal(int node, const float* pMtx);
+    void SetTranslation(int node, float x, float y, float z);
+    void SetScale(int node, float s);
+
+    int  UpdateWorld();
+
+    int          GetNodeCount() const { return (int)m_parent.size(); }
+    int          GetDrawable(int node) const { return m_drawable[node]; }
+    const float* GetWorld(int node) const { return &m_world[16*node]; }
+
+protected:
+    std::vector<int>           m_parent;
+    std::vector<int>           m_drawable;
+    std::vector<unsigned char> m_dirty;   ///< Local transform changed since the last update
+    std::vector<unsigned char> m_updated; ///< World transform recomputed in the current update
+    std::vector<float>         m_local;   ///< 16 per node
+    std::vector<float>         m_world;   ///< 16 per node
+
+private: // Disallow copy ctor and assignment operator
+    SceneGraph(const SceneGraph&);
+    SceneGraph& operator=(const SceneGraph&);
+};
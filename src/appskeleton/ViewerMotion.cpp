@@ -0,0 +1,105 @@
+// ViewerMotion.cpp
+
+#include "ViewerMotion.h"
+
+ViewerMotion::ViewerMotion()
+: m_accumulator(0.0)
+, m_stepSec(0.001)
+{
+    Pose p;
+    p.pos = OVR::Vector3f(0.0f, 0.0f, 0.0f);
+    p.yaw = 0.0f;
+    p.pitch = 0.0f;
+    Reset(p);
+}
+
+ViewerMotion::~ViewerMotion()
+{
+}
+
+void ViewerMotion::SetStepRate(float hz)
+{
+    if (hz <= 0.0f)
+        return;
+    m_stepSec = 1.0 / (double)hz;
+}
+
+/// Jump to a pose with no interpolation from the old one.
+void ViewerMotion::Reset(const Pose& pose)
+{
+    m_previous = pose;
+    m_current = pose;
+    m_accumulator = 0.0;
+}
+
+/// Crouching and eye height changes are immediate too.
+void ViewerMotion::SetHeight(float y)
+{
+    m_previous.pos.y = y;
+    m_current.pos.y = y;
+}
+
+void ViewerMotion::ApplySensor(float deltaYaw, float pitch)
+{
+    m_previous.yaw += deltaYaw;
+    m_current.yaw += deltaYaw;
+    m_previous.pitch = pitch;
+    m_current.pitch = pitch;
+}
+
+///@brief Simulate a frame's worth of time in fixed steps.
+/// After a long stall, time beyond MaxStepsPerAdvance steps is dropped rather
+/// than spent catching up, which would only make the next frame later.
+///@return The number of steps run
+int ViewerMotion::Advance(const Rates& rates, float dt)
+{
+    m_accumulator += (double)dt;
+    int steps = 0;
+    while (m_accumulator >= m_stepSec)
+    {
+        if (steps == MaxStepsPerAdvance)
+        {
+            m_accumulator = 0.0;
+            break;
+        }
+        m_previous = m_current;
+        Step(m_current, rates, (float)m_stepSec);
+        m_accumulator -= m_stepSec;
+        ++steps;
+    }
+    return steps;
+}
+
+ViewerMotion::Pose ViewerMotion::GetInterpolatedPose() const
+{
+    const float t = (float)(m_accumulator / m_stepSec);
+    Pose p;
+    p.pos = m_previous.pos + (m_current.pos - m_previous.pos) * t;
+    p.yaw = m_previous.yaw + (m_current.yaw - m_previous.yaw) * t;
+    p.pitch = m_previous.pitch + (m_current.pitch - m_previous.pitch) * t;
+    return p;
+}
+
+///@brief One step of integration. Every movement source turns by the same yaw,
+/// so the sources are summed first and rotated once.
+void ViewerMotion::Step(Pose& pose, const Rates& rates, float dt)
+{
+    pose.yaw -= rates.yaw * dt;
+
+    if (rates.freePitch)
+    {
+        pose.pitch -= rates.pitch * dt;
+
+        const float maxPitch = ((3.1415f/2)*0.98f);
+        if (pose.pitch > maxPitch)
+            pose.pitch = maxPitch;
+        if (pose.pitch < -maxPitch)
+            pose.pitch = -maxPitch;
+    }
+
+    if (rates.move.LengthSq() > 0)
+    {
+        const OVR::Matrix4f yawRotate = OVR::Matrix4f::RotationY(pose.yaw);
+        pose.pos += yawRotate.Transform(rates.move) * dt;
+    }
+}
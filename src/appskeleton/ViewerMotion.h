@@ -0,0 +1,62 @@
+// ViewerMotion.h
+
+#pragma once
+
+#include "OVR.h"
+
+///@brief The viewer's body as driven by gamepad, mouse and keyboard, simulated
+/// in fixed steps that do not depend on the frame rate.
+///
+/// Advance adds a frame's dt to an accumulator and runs as many whole steps as
+/// fit. The pose to draw is interpolated between the last two steps by the
+/// fraction of a step left over, so motion stays smooth when frames and steps
+/// do not line up. The same inputs and total time give the same path however
+/// the time is split into frames. At 1kHz the interpolation lags the input by
+/// under a millisecond.
+///
+/// The HMD sensor is not simulated: its orientation is absolute and is
+/// applied to both poses at once with ApplySensor, so head motion is never
+/// interpolated or delayed.
+class ViewerMotion
+{
+public:
+    struct Pose
+    {
+        OVR::Vector3f pos;
+        float yaw;
+        float pitch;
+    };
+
+    /// Per second, constant over a frame
+    struct Rates
+    {
+        OVR::Vector3f move;  ///< All sources summed, in the viewer's yaw frame, in m/s
+        float yaw;
+        float pitch;
+        bool  freePitch;     ///< Pitch is ours to clamp; false while a sensor sets it
+    };
+
+    enum { MaxStepsPerAdvance = 250 };
+
+    ViewerMotion();
+    virtual ~ViewerMotion();
+
+    void  SetStepRate(float hz);
+    float GetStepRate() const { return (float)(1.0 / m_stepSec); }
+
+    void Reset(const Pose& pose);
+    void SetHeight(float y);
+    void ApplySensor(float deltaYaw, float pitch);
+
+    int  Advance(const Rates& rates, float dt);
+    Pose GetInterpolatedPose() const;
+    const Pose& GetPose() const { return m_current; }
+
+    static void Step(Pose& pose, const Rates& rates, float dt);
+
+protected:
+    Pose   m_previous;
+    Pose   m_current;
+    double m_accumulator; ///< Seconds not yet simulated
+    double m_stepSec;
+};
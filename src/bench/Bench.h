@@ -0,0 +1,27 @@
+// Bench.h
+// Shared helpers for the Benchmarks executable.
+
+#pragma once
+
+#include "Timer.h"
+
+/// Each benchmark prints its own results to stdout.
+void BenchSimulation();
+void BenchEntities();
+void BenchJobs();
+void BenchDraws();
+
+///@brief Wall-clock stopwatch for benchmark loops.
+class BenchTimer
+{
+public:
+    BenchTimer() : m_start(HighResClock::Now()) {}
+    void   Restart() { m_start = HighResClock::Now(); }
+    double Seconds() const { return HighResClock::TicksToSeconds(HighResClock::Now() - m_start); }
+
+protected:
+    HighResClock::Ticks m_start;
+};
+
+/// Keep a result alive so the loop that made it is not optimized away.
+extern volatile float g_benchSink;
@@ -0,0 +1,82 @@
+// bench_draws.cpp
+// Sorting draw packets by state: the cost of the sort and the state changes
+// it saves, for scenes with many programs, materials and meshes.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <vector>
+#include "Bench.h"
+#include "DrawCommandBuffer.h"
+
+static bool KeyLess(const DrawCommandBuffer::Packet& a, const DrawCommandBuffer::Packet& b)
+{
+    return a.key < b.key;
+}
+
+/// Packets in scene order, with state that varies the way a scene graph
+/// walk gives it: no order at all.
+static void FillRandom(DrawCommandBuffer& commands, int count, int programs, int materials, int meshes)
+{
+    commands.Clear();
+    for (int i=0; i<count; ++i)
+    {
+        commands.Add(0, rand() % programs, rand() % materials, rand() % meshes, (unsigned int)i);
+    }
+}
+
+void BenchDraws()
+{
+    const int programs = 8;
+    const int materials = 64;
+    const int meshes = 256;
+    printf("Random packets over %d programs, %d materials, %d meshes\n", programs, materials, meshes);
+    printf("%9s %12s %12s %14s %14s\n", "packets", "radix us", "std::sort us", "changes before", "changes after");
+
+    const int counts[] = { 14, 100, 1000, 10000, 100000 };
+    for (int c=0; c<(int)(sizeof(counts)/sizeof(counts[0])); ++c)
+    {
+        const int count = counts[c];
+        const int reps = (200000 / count > 1) ? (200000 / count) : 1;
+
+        srand(1);
+        DrawCommandBuffer commands;
+        FillRandom(commands, count, programs, materials, meshes);
+        const int before = commands.CountStateChanges().Total();
+
+        std::vector<DrawCommandBuffer::Packet> unsorted(count);
+        for (int i=0; i<count; ++i)
+            unsorted[i] = commands.Get(i);
+
+        double radixSec = 0.0;
+        for (int r=0; r<reps; ++r)
+        {
+            commands.Clear();
+            srand(1);
+            FillRandom(commands, count, programs, materials, meshes);
+            BenchTimer t;
+            commands.Sort();
+            radixSec += t.Seconds();
+        }
+        const int after = commands.CountStateChanges().Total();
+
+        double stdSec = 0.0;
+        std::vector<DrawCommandBuffer::Packet> packets;
+        for (int r=0; r<reps; ++r)
+        {
+            packets = unsorted;
+            BenchTimer t;
+            std::sort(packets.begin(), packets.end(), KeyLess);
+            stdSec += t.Seconds();
+        }
+
+        bool same = true;
+        for (int i=0; i<count; ++i)
+            same = same && (packets[i].key == commands.Get(i).key);
+        g_benchSink = (float)packets[count/2].transform;
+
+        printf("%9d %12.2f %12.2f %14d %14d%s\n",
+            count, 1.0e6 * radixSec / reps, 1.0e6 * stdSec / reps, before, after,
+            same ? "" : "  radix and std::sort orders differ");
+    }
+}
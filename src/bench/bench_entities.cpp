@@ -0,0 +1,149 @@
+// bench_entities.cpp
+// Bounce animation over the SoA entity store, from the scene's 12 cubes up
+// to 100k entities.
+
+#include <stdio.h>
+#include <math.h>
+#include <vector>
+#include "Bench.h"
+#include "EntityStore.h"
+#include "EntityAnimation.h"
+
+/// One object as the scene used to keep it, animated at draw time.
+struct BenchCube
+{
+    float x, y, z;
+    float phase;
+    float scale;
+};
+
+static void FillStore(EntityStore& store, int count)
+{
+    store.Clear();
+    store.Reserve(count);
+    for (int i=0; i<count; ++i)
+    {
+        const float posPhase = 6.2831853f * (float)i / (float)count;
+        store.Add(15.0f * sinf(posPhase), 0.0f, 15.0f * cosf(posPhase), posPhase, 1.0f);
+    }
+}
+
+static float SumY(const EntityStore& store)
+{
+    float sum = 0.0f;
+    for (int i=0; i<store.GetCount(); ++i)
+        sum += store.PosY()[i];
+    return sum;
+}
+
+void BenchEntities()
+{
+    const float amplitude = 1.0f;
+    const float frequency = 3.0f;
+    const float dt = 1.0f / 90.0f;
+
+    // Accuracy of the polynomial over the range the animation sees
+    {
+        float maxErr = 0.0f;
+        for (int i=-200000; i<=200000; ++i)
+        {
+            const float x = 0.001f * (float)i;
+            const float err = fabsf(EntityAnimation::FastSin(x) - sinf(x));
+            if (err > maxErr)
+                maxErr = err;
+        }
+        printf("FastSin max error on [-200, 200]: %.2e\n", maxErr);
+    }
+
+#ifdef ENTITY_ANIMATION_SSE
+    printf("SIMD path: SSE2, %d lanes\n", (int)EntityStore::Lanes);
+#else
+    printf("SIMD path: none, AnimateBounce is scalar\n");
+#endif
+
+    printf("%9s %16s %16s %16s %14s\n", "entities", "per-eye sin", "SoA scalar", "SoA SIMD", "SIMD/update");
+    printf("%9s %16s %16s %16s %14s\n", "", "ns/entity", "ns/entity", "ns/entity", "us");
+
+    const int counts[] = { 12, 100, 1000, 10000, 100000 };
+    for (int c=0; c<(int)(sizeof(counts)/sizeof(counts[0])); ++c)
+    {
+        const int count = counts[c];
+        const int updates = (20000000 / count > 1) ? (20000000 / count) : 1;
+        const double entityUpdates = (double)count * (double)updates;
+
+        // The old way: each object computed in place for every view drawn,
+        // two HMD eyes and the control window.
+        std::vector<BenchCube> cubes(count);
+        for (int i=0; i<count; ++i)
+        {
+            const float posPhase = 6.2831853f * (float)i / (float)count;
+            cubes[i].x = 15.0f * sinf(posPhase);
+            cubes[i].y = 0.0f;
+            cubes[i].z = 15.0f * cosf(posPhase);
+            cubes[i].phase = posPhase;
+            cubes[i].scale = 1.0f;
+        }
+        double perEyeSec;
+        {
+            float phase = 0.0f;
+            float sum = 0.0f;
+            BenchTimer t;
+            for (int u=0; u<updates; ++u)
+            {
+                phase += dt;
+                for (int view=0; view<3; ++view)
+                {
+                    for (int i=0; i<count; ++i)
+                    {
+                        BenchCube& cube = cubes[i];
+                        cube.y = amplitude * sin(frequency * (phase + cube.phase));
+                        sum += cube.y * cube.scale;
+                    }
+                }
+            }
+            perEyeSec = t.Seconds();
+            g_benchSink = sum;
+        }
+
+        EntityStore store;
+        FillStore(store, count);
+
+        double scalarSec;
+        {
+            float phase = 0.0f;
+            BenchTimer t;
+            for (int u=0; u<updates; ++u)
+            {
+                phase += dt;
+                EntityAnimation::AnimateBounceScalar(store, phase, amplitude, frequency, 1.0f);
+                g_benchSink = store.PosY()[u % count];
+            }
+            scalarSec = t.Seconds();
+        }
+        const float scalarSum = SumY(store);
+
+        double simdSec;
+        {
+            float phase = 0.0f;
+            BenchTimer t;
+            for (int u=0; u<updates; ++u)
+            {
+                phase += dt;
+                EntityAnimation::AnimateBounce(store, phase, amplitude, frequency, 1.0f);
+                g_benchSink = store.PosY()[u % count];
+            }
+            simdSec = t.Seconds();
+        }
+        const float simdSum = SumY(store);
+
+        printf("%9d %16.2f %16.2f %16.2f %14.3f",
+            count,
+            1.0e9 * perEyeSec / entityUpdates,
+            1.0e9 * scalarSec / entityUpdates,
+            1.0e9 * simdSec / entityUpdates,
+            1.0e6 * simdSec / updates);
+        if (fabsf(scalarSum - simdSum) > 1.0e-3f * (float)count)
+            printf("  scalar and SIMD disagree: %f vs %f", scalarSum, simdSum);
+        printf("\n");
+    }
+}
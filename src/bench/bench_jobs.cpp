@@ -0,0 +1,97 @@
+// bench_jobs.cpp
+// Frame preparation on the job system against the number of cores it gets.
+
+#include <stdio.h>
+#include <string.h>
+#include <thread>
+#include <vector>
+#include "Bench.h"
+#include "JobSystem.h"
+#include "EntityStore.h"
+#include "EntityAnimation.h"
+
+/// The second stage of a frame: a model matrix per entity from its animated
+/// position and scale, as the renderer would upload them.
+struct MatrixBuild
+{
+    const EntityStore* pStore;
+    float*             pMatrices; ///< 16 per entity, column major
+};
+
+static void BuildMatrices(void* pData, int begin, int end)
+{
+    const MatrixBuild& build = *(const MatrixBuild*)pData;
+    const float* pX = build.pStore->PosX();
+    const float* pY = build.pStore->PosY();
+    const float* pZ = build.pStore->PosZ();
+    const float* pS = build.pStore->Scale();
+    for (int i=begin; i<end; ++i)
+    {
+        float* m = build.pMatrices + 16*i;
+        const float s = pS[i];
+        m[0] = s;    m[1] = 0.0f;  m[2] = 0.0f;  m[3] = 0.0f;
+        m[4] = 0.0f; m[5] = s;     m[6] = 0.0f;  m[7] = 0.0f;
+        m[8] = 0.0f; m[9] = 0.0f;  m[10] = s;    m[11] = 0.0f;
+        m[12] = pX[i]; m[13] = pY[i]; m[14] = pZ[i]; m[15] = 1.0f;
+    }
+}
+
+void BenchJobs()
+{
+    const int entityCount = 100000;
+    const int frames = 300;
+    const float dt = 1.0f / 90.0f;
+
+    EntityStore store;
+    store.Reserve(entityCount);
+    for (int i=0; i<entityCount; ++i)
+    {
+        const float posPhase = 6.2831853f * (float)i / (float)entityCount;
+        store.Add(0.001f * (float)i, 0.0f, 15.0f, posPhase, 1.0f);
+    }
+    std::vector<float> matrices(16 * store.GetPaddedCount());
+    MatrixBuild build = { &store, &matrices[0] };
+
+    int maxWorkers = (int)std::thread::hardware_concurrency() - 1;
+    if (maxWorkers < 1)
+        maxWorkers = 1;
+    if (maxWorkers > 15)
+        maxWorkers = 15;
+
+    printf("Frame prep: bounce %d entities, then build their model matrices\n", entityCount);
+    printf("%8s %12s %12s %10s\n", "threads", "ms/frame", "best ms", "speedup");
+
+    double baseMs = 0.0;
+    for (int workers=0; workers<=maxWorkers; ++workers)
+    {
+        JobSystem jobs;
+        jobs.Start(workers);
+
+        double totalSec = 0.0;
+        double bestSec = 1.0e9;
+        float time = 0.0f;
+        for (int f=0; f<frames; ++f)
+        {
+            time += dt;
+            BenchTimer t;
+            {
+                JobCounter animated;
+                JobCounter built;
+                const EntityAnimation::Bounce bounce = { &store, time, 1.0f, 3.0f, 1.0f };
+                EntityAnimation::AnimateBounce(jobs, bounce, animated);
+                jobs.ParallelFor(0, store.GetCount(), 2048, BuildMatrices, &build, built, &animated);
+                jobs.Wait(built);
+            }
+            const double sec = t.Seconds();
+            totalSec += sec;
+            if (sec < bestSec)
+                bestSec = sec;
+            g_benchSink = matrices[13 + 16 * (f % entityCount)];
+        }
+
+        const double ms = 1000.0 * totalSec / frames;
+        if (workers == 0)
+            baseMs = ms;
+        printf("%8d %12.3f %12.3f %9.2fx\n", workers + 1, ms, 1000.0 * bestSec, baseMs / ms);
+    }
+}
@@ -0,0 +1,55 @@
+// bench_main.cpp
+// Runs the named benchmarks, or all of them.
+
+#include <stdio.h>
+#include <string.h>
+#include "Bench.h"
+
+volatile float g_benchSink = 0.0f;
+
+struct BenchEntry
+{
+    const char* name;
+    void (*run)();
+};
+
+static const BenchEntry s_benchmarks[] = {
+    { "simulation", BenchSimulation },
+    { "entities",   BenchEntities },
+    { "jobs",       BenchJobs },
+    { "draws",      BenchDraws },
+};
+static const int s_benchmarkCount = sizeof(s_benchmarks) / sizeof(s_benchmarks[0]);
+
+int main(int argc, char *argv[])
+{
+    int ran = 0;
+    for (int i=0; i<s_benchmarkCount; ++i)
+    {
+        bool selected = (argc < 2);
+        for (int a=1; a<argc; ++a)
+        {
+            if (!strcmp(argv[a], s_benchmarks[i].name))
+                selected = true;
+        }
+        if (!selected)
+            continue;
+
+        printf("== %s ==\n", s_benchmarks[i].name);
+        s_benchmarks[i].run();
+        printf("\n");
+        ++ran;
+    }
+
+    if (ran == 0)
+    {
+        printf("Usage: %s [benchmark...]\nBenchmarks:", argv[0]);
+        for (int i=0; i<s_benchmarkCount; ++i)
+        {
+            printf(" %s", s_benchmarks[i].name);
+        }
+        printf("\n");
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,144 @@
+// bench_simulation.cpp
+// Cost of a fixed simulation step for viewer motion, and how frame timing
+// affects the result.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include "Bench.h"
+#include "ViewerMotion.h"
+
+static ViewerMotion::Rates MakeRates()
+{
+    ViewerMotion::Rates rates;
+    rates.move = OVR::Vector3f(0.7f, 0.1f, -1.3f);
+    rates.yaw = 0.4f;
+    rates.pitch = 0.2f;
+    rates.freePitch = true;
+    return rates;
+}
+
+static ViewerMotion::Pose MakePose()
+{
+    ViewerMotion::Pose pose;
+    pose.pos = OVR::Vector3f(0.0f, 1.78f, -5.0f);
+    pose.yaw = 3.141592f;
+    pose.pitch = 0.0f;
+    return pose;
+}
+
+/// The integration as it was before, with a yaw rotation for each of the
+/// gamepad, mouse and keyboard paths.
+static void StepPerSource(ViewerMotion::Pose& pose, const OVR::Vector3f* moves, const ViewerMotion::Rates& rates, float dt)
+{
+    pose.yaw -= rates.yaw * dt;
+    pose.pitch -= rates.pitch * dt;
+    for (int i=0; i<3; ++i)
+    {
+        if (moves[i].LengthSq() > 0)
+        {
+            OVR::Matrix4f yawRotate = OVR::Matrix4f::RotationY(pose.yaw);
+            OVR::Vector3f orientationVector = yawRotate.Transform(moves[i]);
+            orientationVector *= dt;
+            pose.pos += orientationVector;
+        }
+    }
+}
+
+/// Frame times around 90Hz with up to +-4ms of jitter, repeatable.
+static float NextJitteredDt()
+{
+    return 0.0111f + 0.004f * (2.0f * (float)rand() / (float)RAND_MAX - 1.0f);
+}
+
+void BenchSimulation()
+{
+    const ViewerMotion::Rates rates = MakeRates();
+    const int stepCount = 10000000;
+    const float stepDt = 0.001f;
+
+    // One fixed step, all sources summed and rotated once
+    {
+        ViewerMotion::Pose pose = MakePose();
+        BenchTimer t;
+        for (int i=0; i<stepCount; ++i)
+        {
+            ViewerMotion::Step(pose, rates, stepDt);
+        }
+        const double sec = t.Seconds();
+        g_benchSink = pose.pos.x + pose.yaw;
+        printf("Step, one yaw rotation:     %7.2f ns/step\n", 1.0e9 * sec / stepCount);
+    }
+
+    // The same motion split across three sources, each rotated separately
+    {
+        const OVR::Vector3f moves[3] = {
+            rates.move * 0.5f,
+            rates.move * 0.25f,
+            rates.move * 0.25f,
+        };
+        ViewerMotion::Pose pose = MakePose();
+        BenchTimer t;
+        for (int i=0; i<stepCount; ++i)
+        {
+            StepPerSource(pose, moves, rates, stepDt);
+        }
+        const double sec = t.Seconds();
+        g_benchSink = pose.pos.x + pose.yaw;
+        printf("Step, rotation per source:  %7.2f ns/step\n", 1.0e9 * sec / stepCount);
+    }
+
+    // A minute of jittery 90Hz frames at the default 1kHz step rate,
+    // including the accumulator and the interpolated pose
+    {
+        srand(1);
+        ViewerMotion motion;
+        motion.Reset(MakePose());
+        const int frameCount = 90 * 60;
+        long long steps = 0;
+        BenchTimer t;
+        for (int f=0; f<frameCount; ++f)
+        {
+            steps += motion.Advance(rates, NextJitteredDt());
+            const ViewerMotion::Pose p = motion.GetInterpolatedPose();
+            g_benchSink = p.pos.z;
+        }
+        const double sec = t.Seconds();
+        printf("Advance at 1kHz:            %7.2f ns/step, %.1f steps/frame, %.3f us/frame\n",
+            1.0e9 * sec / (double)steps, (double)steps / frameCount, 1.0e6 * sec / frameCount);
+    }
+
+    // The same ten seconds of input in steady frames and in jittered ones
+    {
+        const double totalSec = 10.0;
+
+        ViewerMotion steady;
+        steady.Reset(MakePose());
+        double elapsed = 0.0;
+        while (elapsed + 0.0111 <= totalSec)
+        {
+            steady.Advance(rates, 0.0111f);
+            elapsed += 0.0111;
+        }
+        steady.Advance(rates, (float)(totalSec - elapsed));
+
+        srand(2);
+        ViewerMotion jittered;
+        jittered.Reset(MakePose());
+        elapsed = 0.0;
+        for (;;)
+        {
+            const float dt = NextJitteredDt();
+            if (elapsed + dt > totalSec)
+                break;
+            jittered.Advance(rates, dt);
+            elapsed += dt;
+        }
+        jittered.Advance(rates, (float)(totalSec - elapsed));
+
+        const ViewerMotion::Pose a = steady.GetInterpolatedPose();
+        const ViewerMotion::Pose b = jittered.GetInterpolatedPose();
+        printf("After %.0fs, steady vs jittered frames: position differs by %.6f m, yaw by %.6f rad\n",
+            totalSec, (a.pos - b.pos).Length(), fabs(a.yaw - b.yaw));
+    }
+}
@@ -8,9 +8,14 @@
 #endif
 
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include <GL/glew.h>
 #include <GLFW/glfw3.h>
 #include <vector>
+#include <atomic>
+#include <chrono>
+#include <thread>
 
 #ifdef USE_CUDA
 #else
@@ -20,17 +25,27 @@
 
 #include "Logger.h"
 #include "FBO.h"
+#include "Profiler.h"
+#include "EventLog.h"
 
 #include "AntOculusAppSkeleton.h"
 
 AntOculusAppSkeleton g_app;
 
-int running = 0;
+std::atomic<int> running(0);
+
+///@brief When set, render on the GLFW thread between event polls as before.
+/// Otherwise each window gets a render thread that owns its GL context and
+/// draws from the app's latest published FrameState, while this thread polls
+/// events and runs timestep. A window then only ever waits on its own vsync.
+bool g_singleThreaded = false;
 
 struct OutputStream {
     GLFWwindow*  pWindow;
     GLFWmonitor* pMonitor;
     OVRkill::DisplayMode outtype;
+    unsigned long long nextFrameNs; ///< Earliest next frame under the window's target fps
+    int swapInterval;               ///< As last set in the window's context; -1 before the first frame
 };
 
 void CycleOutputType(OutputStream& os)
@@ -51,26 +66,118 @@ void CycleOutputType(OutputStream& os)
 
 std::vector<OutputStream> g_outStreams;
 
+/// The stream drawn to the HMD, or the only window there is. Its frames are
+/// the ones timed, paced and measured for latency. Set by initGlfw.
+int g_hmdStream = 0;
+
 Timer g_timer;
 
-void display()
+/// The first stream is the control window; any other is the Oculus window.
+AntOculusAppSkeleton::GpuWindow StreamWindow(int stream)
 {
-    int i=0;
-    for (std::vector<OutputStream>::const_iterator it = g_outStreams.begin();
-        it != g_outStreams.end();
-        ++it, ++i)
+    return (stream == 0) ? AntOculusAppSkeleton::Window_Control : AntOculusAppSkeleton::Window_Oculus;
+}
+
+///@brief Draw and swap one window, whose context must be current. Sizes and
+/// output types come from the frame state snapshot, not g_outStreams, which
+/// the GLFW thread may change.
+void renderStream(int i)
+{
+    OutputStream& os = g_outStreams[i];
+    GLFWwindow* pWin = os.pWindow;
+    const AntOculusAppSkeleton::GpuWindow window = StreamWindow(i);
+
+    const bool isHmdStream = (i == g_hmdStream);
+
+    // Wait out the frames-in-flight limit before sampling the frame state.
     {
-        const OutputStream& os = *it;
-        GLFWwindow* pWin = os.pWindow;
-        glfwMakeContextCurrent(pWin);
+        PROFILE_ZONE("WaitForFrameSlot");
+        g_app.WaitForFrameSlot(window);
+    }
 
-        int width, height;
-        glfwGetWindowSize(pWin, &width, &height);
+    g_app.AcquireFrameState(window, isHmdStream);
+    const AntOculusAppSkeleton::FrameState& fs = g_app.GetFrameState(window);
 
-        glViewport(0,0, width, height);
-        g_app.display(i==0, os.outtype);
+    // Swap interval is per context, so it can only be set from here.
+    const int swapInterval = fs.windowSwapInterval[window];
+    if (swapInterval != os.swapInterval)
+    {
+        glfwSwapInterval(swapInterval);
+        os.swapInterval = swapInterval;
+        if (isHmdStream)
+            g_app.GetFrameScheduler().SetSwapInterval(swapInterval);
+    }
+
+    if (isHmdStream)
+        g_app.frameStart();
+
+    const AntOculusAppSkeleton::FrameState::StreamView& sv = fs.streams[i];
+    glViewport(0,0, sv.width, sv.height);
+    g_app.display(i==0, sv.mode);
+
+    if (isHmdStream)
+    {
+        if (i != 0)
+            g_app.PublishMirrorFrame(sv.width, sv.height);
+        g_app.OnHmdFrameSubmitted();
+    }
+    {
+        PROFILE_ZONE("glfwSwapBuffers");
         glfwSwapBuffers(pWin);
     }
+    g_app.OnFrameSwapped(window);
+    EventLog::Instance().LogSwap(fs.eventFrame, i);
+    if (isHmdStream)
+        g_app.OnHmdFrameSwapped();
+}
+
+bool IsRenderedStream(int i)
+{
+    return (g_outStreams[i].pWindow != NULL) && (i < AntOculusAppSkeleton::FrameState::MaxStreams);
+}
+
+///@brief Nanoseconds until stream i may draw again under its window's target fps.
+/// The HMD stream is never rate limited; on its own thread it waits for the
+/// frame scheduler's start time instead. A window that skips a frame keeps
+/// showing the last one it swapped.
+unsigned long long StreamWaitNs(int i)
+{
+    if (i == g_hmdStream)
+    {
+        // Serially, the main loop waits before sampling input instead.
+        if (g_singleThreaded)
+            return 0;
+        return g_app.GetFrameScheduler().GetFrameStartWaitNs(HighResClock::NowNanoseconds());
+    }
+    // The window's last snapshot; a change shows up from its next frame.
+    const AntOculusAppSkeleton::GpuWindow window = StreamWindow(i);
+    const float fps = g_app.GetFrameState(window).windowTargetFps[window];
+    if (fps <= 0.0f)
+        return 0;
+
+    OutputStream& os = g_outStreams[i];
+    const unsigned long long nowNs = HighResClock::NowNanoseconds();
+    if (nowNs < os.nextFrameNs)
+        return os.nextFrameNs - nowNs;
+
+    // Fixed cadence, but a late frame does not earn a burst of catch-up frames.
+    const unsigned long long periodNs = (unsigned long long)(1.0e9 / (double)fps);
+    os.nextFrameNs += periodNs;
+    if (os.nextFrameNs < nowNs)
+        os.nextFrameNs = nowNs + periodNs;
+    return 0;
+}
+
+/// Serial rendering: draw and swap every window that is due in turn.
+void display()
+{
+    for (int i=0; i<(int)g_outStreams.size(); ++i)
+    {
+        if (!IsRenderedStream(i) || (StreamWaitNs(i) > 0))
+            continue;
+        glfwMakeContextCurrent(g_outStreams[i].pWindow);
+        renderStream(i);
+    }
 }
 
 void mouseDown(GLFWwindow* pWindow, int button, int action, int mods)
@@ -123,7 +230,8 @@ void keyboard(GLFWwindow* pWindow, int key, int codes, int action, int mods)
     default: break;
 
     case GLFW_KEY_ESCAPE:
-        exit(0);
+        // Leave through the bottom of main so the render thread is joined.
+        running = GL_FALSE;
         break;
     }
 
@@ -136,25 +244,63 @@ void keyboard(GLFWwindow* pWindow, int key, int codes, int action, int mods)
 }
 
 
+///@brief Advance the simulation and publish its state, including each
+/// window's current size and output type, for the next frame drawn.
 void timestep()
 {
+    PROFILE_ZONE("timestep");
+    int i=0;
+    for (std::vector<OutputStream>::const_iterator it = g_outStreams.begin();
+        it != g_outStreams.end();
+        ++it, ++i)
+    {
+        const OutputStream& os = *it;
+        if (os.pWindow == NULL)
+            continue;
+        int width, height;
+        glfwGetWindowSize(os.pWindow, &width, &height);
+        g_app.SetStreamView(i, width, height, os.outtype);
+    }
+
     float dt = (float)g_timer.seconds();
     g_timer.reset();
     g_app.timestep(dt);
 }
 
+///@brief Body of one window's render thread, which owns its context.
+void renderThreadMain(int i)
+{
+    PROFILE_THREAD_NAME((i == 0) ? "render control" : "render hmd");
+    glfwMakeContextCurrent(g_outStreams[i].pWindow);
+    while (running)
+    {
+        const unsigned long long waitNs = StreamWaitNs(i);
+        if (waitNs > 0)
+        {
+            std::this_thread::sleep_for(std::chrono::nanoseconds(waitNs));
+            continue;
+        }
+        renderStream(i);
+    }
+    glfwMakeContextCurrent(NULL);
+}
+
 
 ///@brief Window resized event callback
 void resize(GLFWwindow* pWindow, int w, int h)
 {
     g_app.resize(w,h);
-    glViewport(0,0,(GLsizei)w, (GLsizei)h);
 
     ///@note We can mitigate the effect of resizing the control window on the Oculus user
     /// by continuing to track the head in timestep as we resize.
     /// However, when the mouse is held still while resizing, we do not refresh.
+    /// The render threads keep drawing on their own; only the serial loop must be
+    /// driven from here.
     timestep();
-    display();
+    if (g_singleThreaded)
+    {
+        display();
+    }
 }
 
 
@@ -177,6 +323,7 @@ void IdentifyMonitors()
         // In initGlfw they will be paired with monitors.
         OutputStream os = {0};
         os.pMonitor = pMonitor;
+        os.swapInterval = -1;
         g_outStreams.push_back(os);
     }
 }
@@ -323,6 +470,7 @@ bool initGlfw(int argc, char **argv, bool fullScreen)
 
         g_outStreams[1].pWindow = pOculusWindow;
         g_outStreams[1].outtype = OVRkill::StereoWithDistortion;
+        g_hmdStream = 1;
     }
 
     /// If we are not sharing contexts between windows, make the appropriate one current here.
@@ -333,27 +481,345 @@ bool initGlfw(int argc, char **argv, bool fullScreen)
 
 
 
+/// Options not meant for glfw or the app's initGL.
+struct CommandLineOptions
+{
+    const char* eventLogFile; ///< --eventlog <file>   Record binary frame events from the first frame on
+    const char* recordFile;   ///< --record <file>     Record per-frame input and HMD orientation
+    const char* replayFile;   ///< --replay <file>     Drive the viewer from a recording, then exit
+    float       replayDt;     ///< --replay-dt <sec>   Fixed replay timestep; default is the recording's mean
+    bool        simulateHmd;  ///< --simhmd             Use a simulated headset with synthetic head motion
+    bool        latencyTest;  ///< --latency            Measure motion-to-photon latency from the start
+    bool        singleThread; ///< --single-thread      Render on the GLFW thread; implied by --record and --replay
+    SimulatedHmdParams simHmd;///< --simhmd-rate <hz>, --simhmd-res <w>x<h>
+    float       controlFps;   ///< --control-fps <hz>   Control window update rate; 0 for no limit
+    float       controlScale; ///< --control-scale <s>  Control window render buffer scale
+    float       benchmarkSec; ///< --benchmark <sec>    Compare HMD headroom with a full-rate and a spectator control window
+    int         swapInterval; ///< --swap-interval <n>  Vblanks per HMD window frame; 0 for no vsync
+    int         controlSwapInterval; ///< --control-swap-interval <n>  Default 0 when rendering serially, else 1
+    bool        lateStart;    ///< --no-late-start      Start HMD frames right after the last swap
+    int         framesInFlight; ///< --frames-in-flight <n>  Frames the CPU may queue ahead of the GPU, 1 to 3
+    const char* gamepadFile;  ///< --gamepads <file>    Controller layouts; default ../config/gamepads.cfg
+    float       simRate;      ///< --sim-rate <hz>      Fixed viewer motion step rate; default 1000
+    int         jobWorkers;   ///< --jobs <n>           Job worker threads; default is the cores left after the main and render threads
+};
+
+CommandLineOptions parseCommandLine(int argc, char *argv[])
+{
+    CommandLineOptions opts;
+    opts.eventLogFile = NULL;
+    opts.recordFile = NULL;
+    opts.replayFile = NULL;
+    opts.replayDt = 0.0f;
+    opts.simulateHmd = false;
+    opts.latencyTest = false;
+    opts.singleThread = false;
+    opts.controlFps = 0.0f;
+    opts.controlScale = 1.0f;
+    opts.benchmarkSec = 0.0f;
+    opts.swapInterval = 1;
+    opts.controlSwapInterval = -1;
+    opts.lateStart = true;
+    opts.framesInFlight = 2;
+    opts.gamepadFile = "../config/gamepads.cfg";
+    opts.simRate = 1000.0f;
+    opts.jobWorkers = -1;
+
+    for (int i=1; i<argc; ++i)
+    {
+        const bool hasValue = (i+1 < argc);
+        if (!strcmp(argv[i], "--eventlog") && hasValue)
+            opts.eventLogFile = argv[++i];
+        else if (!strcmp(argv[i], "--record") && hasValue)
+            opts.recordFile = argv[++i];
+        else if (!strcmp(argv[i], "--replay") && hasValue)
+            opts.replayFile = argv[++i];
+        else if (!strcmp(argv[i], "--replay-dt") && hasValue)
+            opts.replayDt = (float)atof(argv[++i]);
+        else if (!strcmp(argv[i], "--simhmd"))
+            opts.simulateHmd = true;
+        else if (!strcmp(argv[i], "--latency"))
+            opts.latencyTest = true;
+        else if (!strcmp(argv[i], "--single-thread"))
+            opts.singleThread = true;
+        else if (!strcmp(argv[i], "--control-fps") && hasValue)
+            opts.controlFps = (float)atof(argv[++i]);
+        else if (!strcmp(argv[i], "--control-scale") && hasValue)
+            opts.controlScale = (float)atof(argv[++i]);
+        else if (!strcmp(argv[i], "--benchmark") && hasValue)
+            opts.benchmarkSec = (float)atof(argv[++i]);
+        else if (!strcmp(argv[i], "--swap-interval") && hasValue)
+            opts.swapInterval = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--control-swap-interval") && hasValue)
+            opts.controlSwapInterval = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--no-late-start"))
+            opts.lateStart = false;
+        else if (!strcmp(argv[i], "--sim-rate") && hasValue)
+            opts.simRate = (float)atof(argv[++i]);
+        else if (!strcmp(argv[i], "--gamepads") && hasValue)
+            opts.gamepadFile = argv[++i];
+        else if (!strcmp(argv[i], "--jobs") && hasValue)
+            opts.jobWorkers = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--frames-in-flight") && hasValue)
+            opts.framesInFlight = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--simhmd-rate") && hasValue)
+            opts.simHmd.sensorRateHz = (float)atof(argv[++i]);
+        else if (!strcmp(argv[i], "--simhmd-res") && hasValue)
+        {
+            unsigned int w = 0, h = 0;
+            if (sscanf(argv[++i], "%ux%u", &w, &h) == 2)
+            {
+                opts.simHmd.display.HResolution = w;
+                opts.simHmd.display.VResolution = h;
+            }
+        }
+    }
+    return opts;
+}
+
+///@brief --benchmark: what a reduced-rate spectator view buys the HMD window.
+/// Runs the control window at full rate and resolution, then at the spectator
+/// settings, each for the same time after a short warmup, and prints the HMD
+/// window's frame time and GPU headroom for both. Ticked from the main loop.
+class SpectatorBenchmark
+{
+public:
+    SpectatorBenchmark()
+    : m_phase(Phase_Off)
+    , m_phaseEndNs(0)
+    , m_phaseNs(0)
+    , m_spectatorFps(0.0f)
+    , m_spectatorScale(1.0f)
+    {}
+
+    void Start(float seconds, float spectatorFps, float spectatorScale)
+    {
+        m_phaseNs = (unsigned long long)(1.0e9 * (double)seconds);
+        m_spectatorFps = (spectatorFps > 0.0f) ? spectatorFps : 20.0f;
+        m_spectatorScale = (spectatorScale < 1.0f) ? spectatorScale : 0.5f;
+        _Enter(Phase_FullWarmup, 0.0f, 1.0f);
+    }
+
+    ///@return false once finished
+    bool Tick()
+    {
+        if (m_phase == Phase_Off)
+            return true;
+        if (HighResClock::NowNanoseconds() < m_phaseEndNs)
+            return true;
+
+        switch (m_phase)
+        {
+        default:
+            break;
+
+        case Phase_FullWarmup:
+            g_app.RequestFrameStatsReset();
+            m_phase = Phase_Full;
+            m_phaseEndNs = HighResClock::NowNanoseconds() + m_phaseNs;
+            break;
+
+        case Phase_Full:
+            printf("== Benchmark: control window at full rate and resolution ==\n");
+            g_app.RequestFrameStatsPrint();
+            _Enter(Phase_SpectatorWarmup, m_spectatorFps, m_spectatorScale);
+            break;
+
+        case Phase_SpectatorWarmup:
+            g_app.RequestFrameStatsReset();
+            m_phase = Phase_Spectator;
+            m_phaseEndNs = HighResClock::NowNanoseconds() + m_phaseNs;
+            break;
+
+        case Phase_Spectator:
+            printf("== Benchmark: control window at %.0f fps, %.2fx resolution ==\n",
+                m_spectatorFps, m_spectatorScale);
+            g_app.RequestFrameStatsPrint();
+            m_phase = Phase_Done;
+            // Let the render side pick up the print request before exiting.
+            m_phaseEndNs = HighResClock::NowNanoseconds() + 500000000ULL;
+            break;
+
+        case Phase_Done:
+            return false;
+        }
+        return true;
+    }
+
+protected:
+    enum Phase
+    {
+        Phase_Off,
+        Phase_FullWarmup,
+        Phase_Full,
+        Phase_SpectatorWarmup,
+        Phase_Spectator,
+        Phase_Done
+    };
+
+    void _Enter(Phase phase, float controlFps, float controlScale)
+    {
+        g_app.SetWindowTargetFps(AntOculusAppSkeleton::Window_Control, controlFps);
+        g_app.SetWindowResolutionScale(AntOculusAppSkeleton::Window_Control, controlScale);
+        m_phase = phase;
+        m_phaseEndNs = HighResClock::NowNanoseconds() + 1000000000ULL;
+    }
+
+    Phase m_phase;
+    unsigned long long m_phaseEndNs;
+    unsigned long long m_phaseNs;
+    float m_spectatorFps;
+    float m_spectatorScale;
+};
+
 /// Initialize then enter the main loop
 int main(int argc, char *argv[])
 {
     bool fullScreen = false;
+    PROFILE_THREAD_NAME("main");
+    const CommandLineOptions opts = parseCommandLine(argc, argv);
+    if ((opts.eventLogFile != NULL) && !EventLog::Instance().Open(opts.eventLogFile))
+    {
+        printf("Could not open event log %s\n", opts.eventLogFile);
+    }
+
+    if (opts.simulateHmd)
+    {
+        g_app.SetSimulatedHmd(opts.simHmd);
+    }
 
     // Call initVR before initGL to get recommended size for our FBO distortion buffer
     g_app.initVR(fullScreen);
 
     initGlfw(argc, argv, fullScreen);
 
+    // Set before initGL so the control window's buffer starts at its own size.
+    g_app.SetWindowTargetFps(AntOculusAppSkeleton::Window_Control, opts.controlFps);
+    g_app.SetWindowResolutionScale(AntOculusAppSkeleton::Window_Control, opts.controlScale);
+
+    // Each window's GL objects are created in its own context.
+    glfwMakeContextCurrent(g_outStreams[0].pWindow);
     g_app.initGL(argc, argv);
+    for (int i=1; i<(int)g_outStreams.size(); ++i)
+    {
+        if (!IsRenderedStream(i))
+            continue;
+        glfwMakeContextCurrent(g_outStreams[i].pWindow);
+        g_app.initWindowGL(StreamWindow(i));
+    }
+    g_app.SetSimulationRate(opts.simRate);
+    g_app.LoadGamepadMappings(opts.gamepadFile);
     g_app.initJoysticks();
 
+    // Frames longer than one refresh of the HMD display (or the only display) are judder.
+    {
+        const OutputStream& hmdStream = g_outStreams[g_hmdStream];
+        const GLFWvidmode* pMode = glfwGetVideoMode(hmdStream.pMonitor);
+        if ((pMode != NULL) && (pMode->refreshRate > 0))
+        {
+            g_app.SetFrameBudgetMs(1000.0f / (float)pMode->refreshRate);
+            g_app.GetFrameScheduler().SetRefreshRate((float)pMode->refreshRate);
+        }
+    }
+
+    g_app.SetLatencyTestEnabled(opts.latencyTest);
+
+    if (opts.replayFile != NULL)
+    {
+        if (!g_app.StartInputReplay(opts.replayFile, opts.replayDt))
+            return 1;
+    }
+    else if (opts.recordFile != NULL)
+    {
+        g_app.StartInputRecording(opts.recordFile);
+    }
+
+    // A replay must draw exactly the frames it steps, so it runs serially.
+    // So does a recording, so that it holds one frame per displayed frame
+    // rather than one per input sample of the threaded loop.
+    g_singleThreaded = opts.singleThread || (opts.replayFile != NULL) || (opts.recordFile != NULL);
+
+    // Serially, a vsynced control window would block the HMD window's frame.
+    {
+        int controlSwapInterval = opts.controlSwapInterval;
+        if (controlSwapInterval < 0)
+            controlSwapInterval = g_singleThreaded ? 0 : 1;
+        g_app.SetWindowSwapInterval(AntOculusAppSkeleton::Window_Control, controlSwapInterval);
+        g_app.SetWindowSwapInterval(StreamWindow(g_hmdStream), opts.swapInterval);
+        g_app.GetFrameScheduler().SetEnabled(opts.lateStart);
+        g_app.SetMaxFramesInFlight(opts.framesInFlight);
+    }
+
+    // Leave a core each to the main thread and the render threads.
+    {
+        int jobWorkers = opts.jobWorkers;
+        if (jobWorkers < 0)
+        {
+            int renderThreadCount = 0;
+            for (int i=0; !g_singleThreaded && (i<(int)g_outStreams.size()); ++i)
+            {
+                if (IsRenderedStream(i))
+                    ++renderThreadCount;
+            }
+            jobWorkers = (int)std::thread::hardware_concurrency() - 1 - renderThreadCount;
+            if (jobWorkers < 0)
+                jobWorkers = 0;
+        }
+        g_app.SetJobWorkers(jobWorkers);
+    }
+
+    SpectatorBenchmark benchmark;
+    if (opts.benchmarkSec > 0.0f)
+    {
+        if (g_hmdStream != 0)
+            benchmark.Start(opts.benchmarkSec, opts.controlFps, opts.controlScale);
+        else
+            printf("--benchmark needs a separate HMD window; ignoring.\n");
+    }
+
     /// Main loop
     running = GL_TRUE;
-    while (running)
+    std::vector<std::thread> renderThreads;
+    if (!g_singleThreaded)
     {
+        // Publish a first state so no render thread draws an empty one.
         timestep();
-        g_app.frameStart();
-        display();
-        glfwPollEvents();
+        // A context may only be current on one thread at a time.
+        glfwMakeContextCurrent(NULL);
+        for (int i=0; i<(int)g_outStreams.size(); ++i)
+        {
+            if (IsRenderedStream(i))
+                renderThreads.push_back(std::thread(renderThreadMain, i));
+        }
+    }
+
+    while (running)
+    {
+        if (g_singleThreaded)
+        {
+            // Sample input as late as the HMD window's next vblank allows.
+            const unsigned long long waitNs = g_app.GetFrameScheduler().GetSampleWaitNs(HighResClock::NowNanoseconds());
+            if (waitNs > 0)
+                std::this_thread::sleep_for(std::chrono::nanoseconds(waitNs));
+            timestep();
+            display();
+        }
+        {
+            PROFILE_ZONE("glfwPollEvents");
+            glfwPollEvents();
+        }
+        if (!g_singleThreaded)
+        {
+            timestep();
+            // Sample input often enough to stay ahead of any display, but
+            // leave the cores to the render threads. Wake for one more sample
+            // just before the HMD window's scheduled frame start.
+            unsigned long long sleepNs = 1000000;
+            const unsigned long long sampleWaitNs = g_app.GetFrameScheduler().GetSampleWaitNs(HighResClock::NowNanoseconds());
+            if ((sampleWaitNs > 0) && (sampleWaitNs < sleepNs))
+                sleepNs = sampleWaitNs;
+            std::this_thread::sleep_for(std::chrono::nanoseconds(sleepNs));
+        }
 
         for (std::vector<OutputStream>::const_iterator it = g_outStreams.begin();
             it != g_outStreams.end();
@@ -363,7 +829,29 @@ int main(int argc, char *argv[])
             if (glfwWindowShouldClose(os.pWindow))
                 running = GL_FALSE;
         }
+
+        // A replay is a benchmark run; stop when it is over.
+        if (g_app.IsInputReplayFinished())
+            running = GL_FALSE;
+        if (!benchmark.Tick())
+            running = GL_FALSE;
+    }
+
+    for (size_t i=0; i<renderThreads.size(); ++i)
+    {
+        renderThreads[i].join();
+    }
+
+    // Per-context objects go with their own context current; the app's
+    // destructors release the shared ones from the control context.
+    for (int i=0; i<(int)g_outStreams.size(); ++i)
+    {
+        if (!IsRenderedStream(i))
+            continue;
+        glfwMakeContextCurrent(g_outStreams[i].pWindow);
+        g_app.destroyWindowGL(StreamWindow(i));
     }
+    glfwMakeContextCurrent(g_outStreams[0].pWindow);
 
     return 0;
 }
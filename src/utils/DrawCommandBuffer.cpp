@@ -0,0 +1,128 @@
+// DrawCommandBuffer.cpp
+
+#include "DrawCommandBuffer.h"
+
+#include <string.h>
+
+DrawCommandBuffer::DrawCommandBuffer()
+{
+}
+
+DrawCommandBuffer::~DrawCommandBuffer()
+{
+}
+
+///@return false if an id is out of range or the buffer is full
+bool DrawCommandBuffer::Add(int layer, int program, int material, int mesh, unsigned int transform)
+{
+    const int sequence = GetCount();
+    if ((layer < 0) || (layer >= MaxLayers) ||
+        (program < 0) || (program >= MaxPrograms) ||
+        (material < 0) || (material >= MaxMaterials) ||
+        (mesh < 0) || (mesh >= MaxMeshes) ||
+        (sequence >= MaxPackets))
+    {
+        return false;
+    }
+
+    Packet p;
+    p.key = ((unsigned long long)layer    << 56)
+          | ((unsigned long long)program  << 48)
+          | ((unsigned long long)material << 36)
+          | ((unsigned long long)mesh     << 24)
+          |  (unsigned long long)sequence;
+    p.transform = transform;
+    m_packets.push_back(p);
+    return true;
+}
+
+void DrawCommandBuffer::Sort()
+{
+    const int count = GetCount();
+    if (count < 2)
+        return;
+
+    // Below a few dozen packets, clearing and scanning the histograms costs
+    // more than moving the packets around.
+    if (count <= InsertionSortMax)
+    {
+        for (int i=1; i<count; ++i)
+        {
+            const Packet p = m_packets[i];
+            int j = i;
+            for (; (j > 0) && (m_packets[j-1].key > p.key); --j)
+            {
+                m_packets[j] = m_packets[j-1];
+            }
+            m_packets[j] = p;
+        }
+        return;
+    }
+
+    m_scratch.resize(count);
+
+    Packet* pSrc = &m_packets[0];
+    Packet* pDst = &m_scratch[0];
+    for (int shift=0; shift<64; shift+=8)
+    {
+        int histogram[256];
+        memset(histogram, 0, sizeof(histogram));
+        for (int i=0; i<count; ++i)
+        {
+            ++histogram[(pSrc[i].key >> shift) & 0xff];
+        }
+
+        // All keys share this byte; the pass would not move anything.
+        if (histogram[(pSrc[0].key >> shift) & 0xff] == count)
+            continue;
+
+        int offset = 0;
+        for (int b=0; b<256; ++b)
+        {
+            const int n = histogram[b];
+            histogram[b] = offset;
+            offset += n;
+        }
+        for (int i=0; i<count; ++i)
+        {
+            pDst[histogram[(pSrc[i].key >> shift) & 0xff]++] = pSrc[i];
+        }
+
+        Packet* pTmp = pSrc;
+        pSrc = pDst;
+        pDst = pTmp;
+    }
+
+    if (pSrc != &m_packets[0])
+        memcpy(&m_packets[0], pSrc, count*sizeof(Packet));
+}
+
+DrawCommandBuffer::StateChanges DrawCommandBuffer::CountStateChanges() const
+{
+    StateChanges changes = { 0, 0, 0 };
+    int program = -1;
+    int material = -1;
+    int mesh = -1;
+    for (int i=0; i<GetCount(); ++i)
+    {
+        const unsigned long long key = m_packets[i].key;
+        if (GetProgram(key) != program)
+        {
+            program = GetProgram(key);
+            ++changes.programs;
+            // Material uniforms belong to the program, so they are set again.
+            material = -1;
+        }
+        if (GetMaterial(key) != material)
+        {
+            material = GetMaterial(key);
+            ++changes.materials;
+        }
+        if (GetMesh(key) != mesh)
+        {
+            mesh = GetMesh(key);
+            ++changes.meshes;
+        }
+    }
+    return changes;
+}
@@ -0,0 +1,78 @@
+// DrawCommandBuffer.h
+
+#pragma once
+
+#include <vector>
+
+///@brief A frame's draws as compact packets, sorted by the GL state they need.
+///
+/// Each packet names a program, material and mesh by small integer ids, plus
+/// the index of the transform to draw with. The ids are packed into a 64 bit
+/// key, most expensive state change first:
+///
+///     63      56 55      48 47       36 35       24 23             0
+///     [ layer  ][ program ][ material  ][   mesh    ][   sequence    ]
+///
+/// Layer orders whole passes (opaque before transparent, say). Sequence is
+/// the order packets were added in, so packets with identical state keep
+/// their submission order and the sort is deterministic. Sorting the keys
+/// puts packets that share a program next to each other, then those that
+/// share a material within it, then those that share a mesh. A replay that
+/// only changes what differs from the previous packet then does the fewest
+/// state changes.
+///
+/// Sort is an LSD radix sort, one byte per pass. Passes where every key has
+/// the same byte are skipped. Small buffers use an insertion sort instead.
+class DrawCommandBuffer
+{
+public:
+    enum
+    {
+        MaxLayers    = 1 << 8,
+        MaxPrograms  = 1 << 8,
+        MaxMaterials = 1 << 12,
+        MaxMeshes    = 1 << 12,
+        MaxPackets   = 1 << 24
+    };
+    enum { InsertionSortMax = 64 };
+
+    struct Packet
+    {
+        unsigned long long key;
+        unsigned int       transform;
+    };
+
+    /// State changes a replay in the current order would make; the first
+    /// packet counts as a change of everything.
+    struct StateChanges
+    {
+        int programs;
+        int materials;
+        int meshes;
+        int Total() const { return programs + materials + meshes; }
+    };
+
+    DrawCommandBuffer();
+    virtual ~DrawCommandBuffer();
+
+    void Clear() { m_packets.clear(); }
+    bool Add(int layer, int program, int material, int mesh, unsigned int transform);
+    void Sort();
+
+    int           GetCount() const { return (int)m_packets.size(); }
+    const Packet& Get(int i) const { return m_packets[i]; }
+    StateChanges  CountStateChanges() const;
+
+    static int GetLayer   (unsigned long long key) { return (int)((key >> 56) & 0xff); }
+    static int GetProgram (unsigned long long key) { return (int)((key >> 48) & 0xff); }
+    static int GetMaterial(unsigned long long key) { return (int)((key >> 36) & 0xfff); }
+    static int GetMesh    (unsigned long long key) { return (int)((key >> 24) & 0xfff); }
+
+protected:
+    std::vector<Packet> m_packets;
+    std::vector<Packet> m_scratch; ///< Sort ping-pong buffer, kept to avoid reallocating
+
+private: // Disallow copy ctor and assignment operator
+    DrawCommandBuffer(const DrawCommandBuffer&);
+    DrawCommandBuffer& operator=(const DrawCommandBuffer&);
+};
@@ -0,0 +1,235 @@
+// EventLog.cpp
+
+#include "EventLog.h"
+#include "Timer.h"
+#include "Logger.h"
+
+#include <string.h>
+
+#ifdef _LINUX
+#  include <fcntl.h>
+#  include <sys/mman.h>
+#  include <sys/stat.h>
+#  include <unistd.h>
+#endif
+
+#include <thread>
+
+static const unsigned int s_eventLogVersion = 1;
+
+// The offline reader in tools/ depends on these sizes.
+typedef char HeaderSizeCheck[(sizeof(EventLog::Header) == 64) ? 1 : -1];
+typedef char RecordSizeCheck[(sizeof(EventLog::Record) == 128) ? 1 : -1];
+
+EventLog::EventLog()
+: m_open(false)
+, m_writers(0)
+, m_next(0)
+, m_frame(0)
+, m_dropped(0)
+, m_capacity(0)
+, m_pHeader(NULL)
+, m_pRecords(NULL)
+, m_mappedSize(0)
+#ifdef _WIN32
+, m_file(INVALID_HANDLE_VALUE)
+, m_mapping(NULL)
+#else
+, m_fd(-1)
+#endif
+{
+}
+
+EventLog::~EventLog()
+{
+    Close();
+}
+
+/// Create the file at its full capacity and map it. On Linux the file is sparse
+/// until written; Close truncates it to the records actually used.
+bool EventLog::Open(const char* filename, unsigned int capacityRecords)
+{
+    if (IsOpen())
+        return true;
+
+    m_capacity = capacityRecords;
+    m_mappedSize = sizeof(Header) + (size_t)capacityRecords * sizeof(Record);
+
+#ifdef _WIN32
+    m_file = CreateFileA(filename, GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ,
+        NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (m_file == INVALID_HANDLE_VALUE)
+        return false;
+    const unsigned long long sz = m_mappedSize;
+    m_mapping = CreateFileMappingA(m_file, NULL, PAGE_READWRITE,
+        (DWORD)(sz >> 32), (DWORD)(sz & 0xffffffff), NULL);
+    void* pMem = (m_mapping != NULL) ? MapViewOfFile(m_mapping, FILE_MAP_WRITE, 0, 0, m_mappedSize) : NULL;
+    if (pMem == NULL)
+    {
+        if (m_mapping != NULL)
+            CloseHandle(m_mapping);
+        CloseHandle(m_file);
+        m_mapping = NULL;
+        m_file = INVALID_HANDLE_VALUE;
+        return false;
+    }
+#else
+    m_fd = open(filename, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (m_fd < 0)
+        return false;
+    void* pMem = MAP_FAILED;
+    if (ftruncate(m_fd, (off_t)m_mappedSize) == 0)
+        pMem = mmap(NULL, m_mappedSize, PROT_READ | PROT_WRITE, MAP_SHARED, m_fd, 0);
+    if (pMem == MAP_FAILED)
+    {
+        close(m_fd);
+        m_fd = -1;
+        return false;
+    }
+#endif
+
+    m_pHeader = static_cast<Header*>(pMem);
+    m_pRecords = reinterpret_cast<Record*>(static_cast<char*>(pMem) + sizeof(Header));
+
+    memset(m_pHeader, 0, sizeof(Header));
+    memcpy(m_pHeader->magic, "OGSEVLOG", 8);
+    m_pHeader->version = s_eventLogVersion;
+    m_pHeader->recordSize = sizeof(Record);
+    m_pHeader->startNs = HighResClock::NowNanoseconds();
+
+    m_next.store(0, std::memory_order_relaxed);
+    m_dropped.store(0, std::memory_order_relaxed);
+    m_open.store(true, std::memory_order_release);
+    return true;
+}
+
+/// Stop accepting records, wait for appends in flight, then trim and close the file.
+void EventLog::Close()
+{
+    if (!IsOpen())
+        return;
+    m_open.store(false, std::memory_order_seq_cst);
+    while (m_writers.load(std::memory_order_seq_cst) != 0)
+    {
+        std::this_thread::yield();
+    }
+
+    unsigned int count = m_next.load(std::memory_order_relaxed);
+    if (count > m_capacity)
+        count = m_capacity;
+    m_pHeader->recordCount = count;
+    const size_t usedSize = sizeof(Header) + (size_t)count * sizeof(Record);
+
+#ifdef _WIN32
+    UnmapViewOfFile(m_pHeader);
+    CloseHandle(m_mapping);
+    LARGE_INTEGER end;
+    end.QuadPart = (LONGLONG)usedSize;
+    SetFilePointerEx(m_file, end, NULL, FILE_BEGIN);
+    SetEndOfFile(m_file);
+    CloseHandle(m_file);
+    m_mapping = NULL;
+    m_file = INVALID_HANDLE_VALUE;
+#else
+    munmap(m_pHeader, m_mappedSize);
+    if (ftruncate(m_fd, (off_t)usedSize) != 0)
+    {
+        LOG_ERROR("EventLog: could not trim file to %lu bytes", (unsigned long)usedSize);
+    }
+    close(m_fd);
+    m_fd = -1;
+#endif
+
+    m_pHeader = NULL;
+    m_pRecords = NULL;
+}
+
+/// Claim the next record slot. Returns NULL if the log is closed or full.
+/// Each successful call must be followed by _Commit.
+EventLog::Record* EventLog::_Reserve(unsigned int frame)
+{
+    if (!IsOpen())
+        return NULL;
+
+    m_writers.fetch_add(1, std::memory_order_seq_cst);
+    if (!m_open.load(std::memory_order_seq_cst))
+    {
+        m_writers.fetch_sub(1, std::memory_order_release);
+        return NULL;
+    }
+
+    const unsigned int idx = m_next.fetch_add(1, std::memory_order_relaxed);
+    if (idx >= m_capacity)
+    {
+        m_dropped.fetch_add(1, std::memory_order_relaxed);
+        m_writers.fetch_sub(1, std::memory_order_release);
+        return NULL;
+    }
+
+    Record* pRec = &m_pRecords[idx];
+    pRec->frame = frame;
+    pRec->timestampNs = HighResClock::NowNanoseconds();
+    return pRec;
+}
+
+/// Storing the type last marks the record complete for readers.
+void EventLog::_Commit(Record* pRec, EventType type)
+{
+    std::atomic_thread_fence(std::memory_order_release);
+    pRec->type = type;
+    m_writers.fetch_sub(1, std::memory_order_release);
+}
+
+void EventLog::LogFrame(unsigned int frame, float dt)
+{
+    Record* pRec = _Reserve(frame);
+    if (pRec == NULL)
+        return;
+    pRec->u.frame.dt = dt;
+    _Commit(pRec, Event_Frame);
+}
+
+void EventLog::LogHeadPose(unsigned int frame, const float* orientationXYZW, const float* position, unsigned long long sampleNs)
+{
+    Record* pRec = _Reserve(frame);
+    if (pRec == NULL)
+        return;
+    PosePayload& p = pRec->u.pose;
+    memcpy(p.orientation, orientationXYZW, 4*sizeof(float));
+    memcpy(p.position, position, 3*sizeof(float));
+    p.pad = 0;
+    p.sampleNs = sampleNs;
+    _Commit(pRec, Event_HeadPose);
+}
+
+void EventLog::LogInput(unsigned int frame, const float vectors[Input_Count][3])
+{
+    Record* pRec = _Reserve(frame);
+    if (pRec == NULL)
+        return;
+    memcpy(pRec->u.input.vectors, vectors, sizeof(InputPayload));
+    _Commit(pRec, Event_Input);
+}
+
+void EventLog::LogPassTimings(unsigned int frame, float cpuFrameMs, const float* gpuMs, unsigned int count)
+{
+    Record* pRec = _Reserve(frame);
+    if (pRec == NULL)
+        return;
+    if (count > MaxPassTimings)
+        count = MaxPassTimings;
+    TimingsPayload& t = pRec->u.timings;
+    t.cpuFrameMs = cpuFrameMs;
+    t.count = count;
+    memcpy(t.gpuMs, gpuMs, count*sizeof(float));
+    _Commit(pRec, Event_PassTimings);
+}
+
+void EventLog::LogSwap(unsigned int frame, unsigned int window)
+{
+    Record* pRec = _Reserve(frame);
+    if (pRec == NULL)
+        return;
+    pRec->u.swap.window = window;
+    _Commit(pRec, Event_Swap);
+}
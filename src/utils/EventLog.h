@@ -0,0 +1,132 @@
+// EventLog.h
+
+#ifndef _EVENT_LOG_H_
+#define _EVENT_LOG_H_
+
+#include <stddef.h>
+#include <atomic>
+
+#ifdef _WIN32
+#  define WINDOWS_LEAN_AND_MEAN
+#  define NOMINMAX
+#  include <windows.h>
+#endif
+
+///@brief Machine-readable companion to Logger: an append-only file of fixed-size
+/// binary records (frame timestamps, head pose, input vectors, per-pass timings)
+/// written through a memory mapping, so appending is a memcpy with no syscall.
+/// Works in every build configuration. Convert with tools/eventlog_to_csv.py.
+///
+/// File layout: one Header followed by Records. A record is complete
+/// once its type field is non-zero; the type is stored last, so a reader of a file
+/// from a crashed run can skip the zero-filled tail.
+class EventLog
+{
+public:
+    enum EventType
+    {
+        Event_None = 0,
+        Event_Frame,       ///< A simulation frame reached the HMD window, and the simulated time since the last one
+        Event_HeadPose,    ///< Orientation and eye position used for the frame
+        Event_Input,       ///< Movement/rotation vectors from each input source
+        Event_PassTimings, ///< CPU frame time and GPU per-pass times
+        Event_Swap,        ///< glfwSwapBuffers returned for a window
+    };
+
+    enum InputVector
+    {
+        Input_GamepadMove,
+        Input_GamepadRotate,
+        Input_MouseMove,
+        Input_MouseRotate,
+        Input_KeyboardMove,
+        Input_Count
+    };
+
+    enum { MaxPassTimings = 24 };
+
+    struct FramePayload   { float dt; };
+    struct PosePayload    { float orientation[4]; float position[3]; unsigned int pad; unsigned long long sampleNs; };
+    struct InputPayload   { float vectors[Input_Count][3]; };
+    struct TimingsPayload { float cpuFrameMs; unsigned int count; float gpuMs[MaxPassTimings]; };
+    struct SwapPayload    { unsigned int window; };
+
+    struct Header
+    {
+        char               magic[8];    ///< "OGSEVLOG"
+        unsigned int       version;
+        unsigned int       recordSize;
+        unsigned long long startNs;     ///< HighResClock at Open
+        unsigned long long recordCount; ///< Written at Close; 0 if the run did not exit cleanly
+        unsigned char      reserved[32];
+    };
+
+    struct Record
+    {
+        unsigned int       type;
+        unsigned int       frame;
+        unsigned long long timestampNs;
+        union
+        {
+            FramePayload   frame;
+            PosePayload    pose;
+            InputPayload   input;
+            TimingsPayload timings;
+            SwapPayload    swap;
+            unsigned char  raw[112];
+        } u;
+    };
+
+    static EventLog& Instance()
+    {
+        static EventLog theLog;   // Instantiated when this function is called
+        return theLog;
+    }
+
+    bool Open(const char* filename, unsigned int capacityRecords = 1<<20);
+    void Close();
+    bool IsOpen() const { return m_open.load(std::memory_order_acquire); }
+
+    /// Frame numbers are handed out by the simulation and travel with its
+    /// results, so every record names the frame it belongs to no matter
+    /// which thread writes it.
+    unsigned int BeginFrame() { return m_frame.fetch_add(1, std::memory_order_relaxed) + 1; }
+    unsigned int GetFrame() const { return m_frame.load(std::memory_order_relaxed); }
+
+    void LogFrame(unsigned int frame, float dt);
+    void LogHeadPose(unsigned int frame, const float* orientationXYZW, const float* position, unsigned long long sampleNs);
+    void LogInput(unsigned int frame, const float vectors[Input_Count][3]);
+    void LogPassTimings(unsigned int frame, float cpuFrameMs, const float* gpuMs, unsigned int count);
+    void LogSwap(unsigned int frame, unsigned int window);
+
+    unsigned int GetDroppedCount() const { return m_dropped.load(std::memory_order_relaxed); }
+
+protected:
+    Record* _Reserve(unsigned int frame);
+    void    _Commit(Record* pRec, EventType type);
+
+    std::atomic<bool>         m_open;
+    std::atomic<unsigned int> m_writers;   ///< Appends in flight; Close waits for zero
+    std::atomic<unsigned int> m_next;      ///< Next free record index
+    std::atomic<unsigned int> m_frame;
+    std::atomic<unsigned int> m_dropped;   ///< Records lost to a full mapping
+    unsigned int              m_capacity;
+
+    Header* m_pHeader;
+    Record* m_pRecords;
+    size_t  m_mappedSize;
+#ifdef _WIN32
+    HANDLE  m_file;
+    HANDLE  m_mapping;
+#else
+    int     m_fd;
+#endif
+
+private:
+    EventLog();                             ///< disallow default constructor
+    EventLog(const EventLog&);              ///< disallow copy constructor
+    EventLog& operator = (const EventLog&); ///< disallow assignment operator
+    virtual ~EventLog();
+};
+
+#endif //_EVENT_LOG_H_
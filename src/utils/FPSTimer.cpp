@@ -5,6 +5,10 @@
 FPSTimer::FPSTimer()
 : m_timer()
 , m_count(0)
+, m_frameTimer()
+, m_firstFrame(true)
+, m_lastFrameMs(0.0f)
+, m_frameStats()
 {
 }
 
@@ -14,6 +18,15 @@ FPSTimer::~FPSTimer()
 
 void FPSTimer::OnFrame()
 {
+    // The first call has no previous frame to measure against.
+    if (!m_firstFrame)
+    {
+        m_lastFrameMs = (float)m_frameTimer.milliseconds();
+        m_frameStats.AddSample(m_lastFrameMs);
+    }
+    m_frameTimer.reset();
+    m_firstFrame = false;
+
     ++m_count;
     if (m_count > 60)
         Reset();
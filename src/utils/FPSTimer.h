@@ -3,8 +3,11 @@
 #pragma once
 
 #include "Timer.h"
+#include "TimingStats.h"
 
 ///@brief Keeps a count of elapsed frames and time for calculating average FPS.
+/// Also records every frame's duration into a TimingStats distribution so that
+/// dropped-frame spikes, which an average hides, can be seen.
 class FPSTimer
 {
 public:
@@ -14,11 +17,21 @@ public:
     void OnFrame();
     void Reset();
     float GetFPS() const;
+    float GetLastFrameMs() const { return m_lastFrameMs; }
+
+    void SetFrameBudgetMs(float ms) { m_frameStats.SetBudgetMs(ms); }
+    const TimingStats& GetFrameStats() const { return m_frameStats; }
+    void ResetFrameStats() { m_frameStats.Reset(); }
 
 protected:
     Timer        m_timer; ///< Platform-independent timer
     unsigned int m_count; ///< Number of samples
 
+    Timer        m_frameTimer;  ///< Time since the previous OnFrame
+    bool         m_firstFrame;
+    float        m_lastFrameMs;
+    TimingStats  m_frameStats;  ///< Per-frame durations in ms
+
 private: // Disallow copy ctor and assignment operator
     FPSTimer(const FPSTimer&);
     FPSTimer& operator=(const FPSTimer&);
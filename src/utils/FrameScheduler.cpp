@@ -0,0 +1,141 @@
+// FrameScheduler.cpp
+
+#include "FrameScheduler.h"
+
+/// Time the input side needs to poll events and run timestep.
+static const unsigned long long s_sampleLeadNs = 500000;
+
+static const double s_minMarginNs = 500000.0;
+static const double s_initialMarginNs = 2000000.0;
+static const double s_missedMarginStepNs = 1000000.0;
+static const double s_marginDecayNs = 5000.0;
+
+FrameScheduler::FrameScheduler()
+: m_enabled(true)
+, m_swapInterval(1)
+, m_nominalPeriodNs(16666667)
+, m_nextFrameStartNs(0)
+, m_periodNs(16666667.0)
+, m_renderEstimateNs(0.0)
+, m_marginNs(s_initialMarginNs)
+, m_frameStartNs(0)
+, m_lastSwapNs(0)
+, m_predictedVblankNs(0)
+, m_missedVblanks(0)
+, m_displayPeriodMs(0.0f)
+, m_displayRenderEstimateMs(0.0f)
+, m_displayMarginMs(0.0f)
+, m_displayMissedVblanks(0)
+{
+    _PublishForDisplay();
+}
+
+FrameScheduler::~FrameScheduler()
+{
+}
+
+void FrameScheduler::SetRefreshRate(float hz)
+{
+    if (hz <= 0.0f)
+        return;
+    m_nominalPeriodNs.store((unsigned long long)(1.0e9 / (double)hz));
+}
+
+///@return Nanoseconds to wait before starting the next frame
+unsigned long long FrameScheduler::GetFrameStartWaitNs(unsigned long long nowNs) const
+{
+    if (!_IsPacing())
+        return 0;
+    const unsigned long long startNs = m_nextFrameStartNs.load();
+    if (startNs <= nowNs)
+        return 0;
+    // Never hold a frame back longer than the interval it is paced to.
+    const unsigned long long maxNs = m_nominalPeriodNs.load() * m_swapInterval.load();
+    const unsigned long long waitNs = startNs - nowNs;
+    return (waitNs < maxNs) ? waitNs : maxNs;
+}
+
+///@return Nanoseconds to wait before sampling input for the next frame
+unsigned long long FrameScheduler::GetSampleWaitNs(unsigned long long nowNs) const
+{
+    const unsigned long long waitNs = GetFrameStartWaitNs(nowNs);
+    return (waitNs > s_sampleLeadNs) ? (waitNs - s_sampleLeadNs) : 0;
+}
+
+void FrameScheduler::OnFrameStart(unsigned long long ns)
+{
+    m_frameStartNs = ns;
+}
+
+/// One slow frame raises the estimate at once; fast frames lower it gradually.
+void FrameScheduler::OnFrameSubmitted(unsigned long long ns)
+{
+    if ((m_frameStartNs == 0) || (ns < m_frameStartNs))
+        return;
+    const double costNs = (double)(ns - m_frameStartNs);
+    if (costNs > m_renderEstimateNs)
+        m_renderEstimateNs = costNs;
+    else
+        m_renderEstimateNs += (costNs - m_renderEstimateNs) / 64.0;
+    _PublishForDisplay();
+}
+
+/// Call right after SwapBuffers returns for the paced window.
+void FrameScheduler::OnSwapped(unsigned long long ns)
+{
+    const int interval = m_swapInterval.load();
+    const double nominalNs = (double)m_nominalPeriodNs.load();
+    if ((m_periodNs < 0.9 * nominalNs) || (m_periodNs > 1.1 * nominalNs))
+        m_periodNs = nominalNs;
+
+    if (!_IsPacing())
+    {
+        m_lastSwapNs = ns;
+        m_predictedVblankNs = 0;
+        m_nextFrameStartNs.store(0);
+        _PublishForDisplay();
+        return;
+    }
+
+    const double frameNs = m_periodNs * (double)interval;
+    if (m_predictedVblankNs != 0)
+    {
+        if ((double)ns > (double)m_predictedVblankNs + 0.5 * frameNs)
+        {
+            ++m_missedVblanks;
+            m_marginNs += s_missedMarginStepNs;
+        }
+        else
+        {
+            m_marginNs -= s_marginDecayNs;
+        }
+        if (m_marginNs < s_minMarginNs)
+            m_marginNs = s_minMarginNs;
+        if (m_marginNs > 0.5 * frameNs)
+            m_marginNs = 0.5 * frameNs;
+    }
+
+    // Only a swap one interval after the last says anything about the period.
+    if (m_lastSwapNs != 0)
+    {
+        const double deltaNs = (double)(ns - m_lastSwapNs);
+        if ((deltaNs > 0.75 * frameNs) && (deltaNs < 1.25 * frameNs))
+            m_periodNs += (deltaNs / (double)interval - m_periodNs) / 32.0;
+    }
+    m_lastSwapNs = ns;
+
+    m_predictedVblankNs = ns + (unsigned long long)(m_periodNs * (double)interval);
+    const double leadNs = m_renderEstimateNs + m_marginNs;
+    const double startNs = (double)m_predictedVblankNs - leadNs;
+    m_nextFrameStartNs.store((startNs > (double)ns) ? (unsigned long long)startNs : ns);
+    _PublishForDisplay();
+}
+
+/// Render thread: copy the state the tweakbar shows, which another thread reads.
+void FrameScheduler::_PublishForDisplay()
+{
+    m_displayPeriodMs.store(1.0e-6f * (float)m_periodNs);
+    m_displayRenderEstimateMs.store(1.0e-6f * (float)m_renderEstimateNs);
+    m_displayMarginMs.store(1.0e-6f * (float)m_marginNs);
+    m_displayMissedVblanks.store(m_missedVblanks);
+}
@@ -0,0 +1,81 @@
+// FrameScheduler.h
+
+#pragma once
+
+#include <atomic>
+
+///@brief Paces a vsynced window so its frame starts as late as it can and still
+/// make the next vblank, and so input is sampled just before that.
+///
+/// With vsync on, SwapBuffers returns at a vblank; those returns give the phase
+/// and, averaged, the true refresh period. The next vblank is predicted one swap
+/// interval on. The render side's cost is measured from frame start to submit.
+/// Its estimate rises at once to a slower frame and decays slowly. The frame
+/// start is the predicted vblank minus that estimate and a safety margin. A
+/// swap that comes back more than half a period late counts as a missed vblank
+/// and widens the margin, which then shrinks back a little on every frame that
+/// is on time.
+///
+/// The input side asks how long to wait before sampling. Its answer is a short
+/// lead ahead of the frame start, to allow for the poll and timestep.
+///@note The render thread owns OnFrameStart, OnFrameSubmitted and OnSwapped.
+/// The rest may be called from any thread. With a swap interval of 0, or when
+/// disabled, frames and samples are never delayed.
+///@note A driver that queues frames may return from SwapBuffers before the
+/// vblank. The prediction then follows the queue's pace instead. The missed
+/// frame margin still keeps the schedule safe, but the latency gain is smaller.
+class FrameScheduler
+{
+public:
+    FrameScheduler();
+    virtual ~FrameScheduler();
+
+    void SetEnabled(bool enable) { m_enabled.store(enable); }
+    bool IsEnabled() const { return m_enabled.load(); }
+    void SetRefreshRate(float hz);
+    void SetSwapInterval(int interval) { m_swapInterval.store(interval); }
+    int  GetSwapInterval() const { return m_swapInterval.load(); }
+
+    /// Render side
+    unsigned long long GetFrameStartWaitNs(unsigned long long nowNs) const;
+    void OnFrameStart(unsigned long long ns);
+    void OnFrameSubmitted(unsigned long long ns);
+    void OnSwapped(unsigned long long ns);
+
+    /// Input side
+    unsigned long long GetSampleWaitNs(unsigned long long nowNs) const;
+
+    /// For display, from any thread; copies of the render thread's state
+    float GetVblankPeriodMs() const { return m_displayPeriodMs.load(); }
+    float GetRenderEstimateMs() const { return m_displayRenderEstimateMs.load(); }
+    float GetMarginMs() const { return m_displayMarginMs.load(); }
+    unsigned int GetMissedVblanks() const { return m_displayMissedVblanks.load(); }
+
+protected:
+    bool _IsPacing() const { return m_enabled.load() && (m_swapInterval.load() > 0); }
+    void _PublishForDisplay();
+
+    std::atomic<bool> m_enabled;
+    std::atomic<int>  m_swapInterval;
+    std::atomic<unsigned long long> m_nominalPeriodNs;  ///< From the display mode's refresh rate
+    std::atomic<unsigned long long> m_nextFrameStartNs; ///< 0 when there is nothing to wait for
+
+    /// Render thread only
+    double             m_periodNs;         ///< Measured refresh period
+    double             m_renderEstimateNs; ///< Frame start to submit
+    double             m_marginNs;
+    unsigned long long m_frameStartNs;
+    unsigned long long m_lastSwapNs;
+    unsigned long long m_predictedVblankNs;
+    unsigned int       m_missedVblanks;
+
+    /// Written by _PublishForDisplay
+    std::atomic<float>        m_displayPeriodMs;
+    std::atomic<float>        m_displayRenderEstimateMs;
+    std::atomic<float>        m_displayMarginMs;
+    std::atomic<unsigned int> m_displayMissedVblanks;
+
+private: // Disallow copy ctor and assignment operator
+    FrameScheduler(const FrameScheduler&);
+    FrameScheduler& operator=(const FrameScheduler&);
+};
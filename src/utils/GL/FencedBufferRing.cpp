@@ -0,0 +1,121 @@
+// FencedBufferRing.cpp
+
+#ifdef _WIN32
+#  define WINDOWS_LEAN_AND_MEAN
+#  define NOMINMAX
+#  include <windows.h>
+#endif
+
+#include <GL/glew.h>
+#include <stdlib.h>
+#include "FencedBufferRing.h"
+#include "GLUtils.h"
+
+FencedBufferRing::FencedBufferRing()
+: m_target(GL_ARRAY_BUFFER)
+, m_buffer(0)
+, m_regionBytes(0)
+, m_region(0)
+, m_pMapped(NULL)
+, m_staging()
+{
+    for (int i=0; i<FrameCount; ++i)
+    {
+        m_fences[i] = 0;
+    }
+}
+
+FencedBufferRing::~FencedBufferRing()
+{
+}
+
+bool FencedBufferRing::IsSupported() const
+{
+    return HasFenceSync();
+}
+
+///@brief Create the buffer, with the calling thread's context current.
+///@param target The binding the buffer is created and uploaded through
+///@param readable Map for reading too, for checks on what was written
+///@return false if the context has no fences
+bool FencedBufferRing::Init(GLenum target, int regionBytes, bool readable)
+{
+    if (!IsSupported() || (regionBytes <= 0))
+        return false;
+
+    m_target = target;
+    m_regionBytes = regionBytes;
+    m_region = FrameCount - 1;
+
+    const GLsizeiptr size = (GLsizeiptr)FrameCount * m_regionBytes;
+    glGenBuffers(1, &m_buffer);
+    glBindBuffer(m_target, m_buffer);
+    if (GLEW_VERSION_4_4 || GLEW_ARB_buffer_storage)
+    {
+        GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        if (readable)
+            flags |= GL_MAP_READ_BIT;
+        glBufferStorage(m_target, size, NULL, flags);
+        m_pMapped = (char*)glMapBufferRange(m_target, 0, size, flags);
+        if (m_pMapped == NULL)
+        {
+            // Storage from glBufferStorage is immutable; the fallback below
+            // needs a fresh buffer for glBufferData.
+            glBindBuffer(m_target, 0);
+            glDeleteBuffers(1, &m_buffer);
+            glGenBuffers(1, &m_buffer);
+            glBindBuffer(m_target, m_buffer);
+        }
+    }
+    if (m_pMapped == NULL)
+    {
+        glBufferData(m_target, size, NULL, GL_STREAM_DRAW);
+        m_staging.resize(m_regionBytes);
+    }
+    glBindBuffer(m_target, 0);
+    return true;
+}
+
+/// Move to the next region, waiting until the GPU is done with its last use.
+void FencedBufferRing::BeginFrame()
+{
+    if (m_buffer == 0)
+        return;
+    m_region = (m_region + 1) % FrameCount;
+    WaitAndDeleteFence(m_fences[m_region]);
+}
+
+/// Call after the last draw reading this frame's region.
+void FencedBufferRing::EndFrame()
+{
+    if (m_buffer == 0)
+        return;
+
+    GLsync& fence = m_fences[m_region];
+    if (fence != 0)
+        glDeleteSync(fence);
+    fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+///@return Where to write this frame's region, or NULL before Init
+char* FencedBufferRing::GetRegionData() const
+{
+    if (m_buffer == 0)
+        return NULL;
+    if (m_pMapped != NULL)
+        return m_pMapped + GetRegionOffset();
+    return (char*)&m_staging[0];
+}
+
+///@brief Make bytes [begin, end) of this frame's region visible to the GPU.
+/// Coherent mapping makes persistent writes visible to later commands by
+/// itself, so this only uploads from the copy.
+void FencedBufferRing::Upload(int begin, int end)
+{
+    if ((m_buffer == 0) || (m_pMapped != NULL) || (end <= begin))
+        return;
+
+    glBindBuffer(m_target, m_buffer);
+    glBufferSubData(m_target, GetRegionOffset() + begin, end - begin, &m_staging[begin]);
+    glBindBuffer(m_target, 0);
+}
@@ -0,0 +1,63 @@
+// FencedBufferRing.h
+
+#ifndef _FENCED_BUFFER_RING_H_
+#define _FENCED_BUFFER_RING_H_
+
+#if defined(_WIN32)
+#include <windows.h>
+#endif
+
+#include <GL/glew.h>
+#include <vector>
+
+///@brief A buffer object split into FrameCount regions, one written per frame
+/// by the CPU while the GPU still reads the others. The storage under
+/// UniformRing and StreamingBuffer.
+///
+/// EndFrame puts a fence behind the frame's draws, and BeginFrame waits on the
+/// fence of the region it is about to reuse, which has normally long passed.
+/// Where the context has GL 4.4 or ARB_buffer_storage the buffer is mapped
+/// once, persistent and coherent, and GetRegionData points into it. Otherwise
+/// it points into a copy of one region in memory, and Upload sends a range of
+/// that copy with one glBufferSubData.
+///@note Fences and the mapping belong to the context that called Init; use
+/// one instance per context, from the thread rendering it.
+///@note GL objects are left to their context at exit.
+class FencedBufferRing
+{
+public:
+    enum { FrameCount = 3 };
+
+    FencedBufferRing();
+    virtual ~FencedBufferRing();
+
+    bool IsSupported() const;
+    bool Init(GLenum target, int regionBytes, bool readable=false);
+    bool IsInitialized() const { return m_buffer != 0; }
+    bool IsPersistent() const { return m_pMapped != NULL; }
+    GLuint GetBuffer() const { return m_buffer; }
+    int    GetRegionBytes() const { return m_regionBytes; }
+
+    void BeginFrame();
+    void EndFrame();
+
+    /// The current frame's region
+    char*    GetRegionData() const;
+    GLintptr GetRegionOffset() const { return (GLintptr)m_region * m_regionBytes; }
+    void     Upload(int begin, int end);
+
+protected:
+    GLenum  m_target;
+    GLuint  m_buffer;
+    int     m_regionBytes;
+    int     m_region;
+    GLsync  m_fences[FrameCount];
+    char*   m_pMapped;    ///< Whole buffer, persistently mapped
+    std::vector<char> m_staging; ///< One region, without persistent mapping
+
+private: // Disallow copy ctor and assignment operator
+    FencedBufferRing(const FencedBufferRing&);
+    FencedBufferRing& operator=(const FencedBufferRing&);
+};
+
+#endif //_FENCED_BUFFER_RING_H_
@@ -0,0 +1,81 @@
+// FrameFenceQueue.cpp
+
+#ifdef _WIN32
+#  define WINDOWS_LEAN_AND_MEAN
+#  define NOMINMAX
+#  include <windows.h>
+#endif
+
+#include <GL/glew.h>
+#include "FrameFenceQueue.h"
+#include "Timer.h"
+#include "GLUtils.h"
+
+FrameFenceQueue::FrameFenceQueue()
+: m_head(0)
+, m_count(0)
+, m_maxFrames(2)
+, m_waitStats()
+{
+    for (int i=0; i<MaxFramesInFlight; ++i)
+    {
+        m_fences[i] = 0;
+    }
+}
+
+FrameFenceQueue::~FrameFenceQueue()
+{
+}
+
+bool FrameFenceQueue::IsSupported() const
+{
+    return HasFenceSync();
+}
+
+/// Clamped to [1, MaxFramesInFlight]. Takes effect at the next WaitForSlot.
+void FrameFenceQueue::SetMaxFramesInFlight(int frames)
+{
+    if (frames < 1)
+        frames = 1;
+    if (frames > MaxFramesInFlight)
+        frames = MaxFramesInFlight;
+    m_maxFrames.store(frames);
+}
+
+/// Call before starting a frame's CPU work. Blocks until fewer than the limit
+/// of earlier frames are still on the GPU.
+void FrameFenceQueue::WaitForSlot()
+{
+    if (!IsSupported())
+        return;
+
+    const int maxFrames = m_maxFrames.load();
+    const HighResClock::Ticks start = HighResClock::Now();
+    while (m_count >= maxFrames)
+    {
+        WaitAndDeleteFence(m_fences[m_head]);
+        m_head = (m_head + 1) % MaxFramesInFlight;
+        --m_count;
+    }
+    const double waitSec = HighResClock::TicksToSeconds(HighResClock::Now() - start);
+    m_waitStats.AddSample((float)(1000.0 * waitSec));
+}
+
+/// Call right after SwapBuffers, with the same context current.
+void FrameFenceQueue::OnFrameSubmitted()
+{
+    if (!IsSupported())
+        return;
+
+    // WaitForSlot was skipped; make room rather than leak a fence.
+    if (m_count == MaxFramesInFlight)
+    {
+        glDeleteSync(m_fences[m_head]);
+        m_fences[m_head] = 0;
+        m_head = (m_head + 1) % MaxFramesInFlight;
+        --m_count;
+    }
+    const int tail = (m_head + m_count) % MaxFramesInFlight;
+    m_fences[tail] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    ++m_count;
+}
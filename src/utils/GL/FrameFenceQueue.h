@@ -0,0 +1,56 @@
+// FrameFenceQueue.h
+
+#ifndef _FRAME_FENCE_QUEUE_H_
+#define _FRAME_FENCE_QUEUE_H_
+
+#if defined(_WIN32)
+#include <windows.h>
+#endif
+
+#include <GL/glew.h>
+#include <atomic>
+#include "TimingStats.h"
+
+///@brief Bounds how many frames the CPU may queue ahead of the GPU in one
+/// context, rather than leaving it to the driver.
+/// A fence goes in after each frame's SwapBuffers. Before the CPU starts a new
+/// frame, WaitForSlot blocks on the oldest fences until fewer than the limit
+/// are still unsignaled. A limit of 1 means the GPU is idle while the CPU
+/// prepares the next frame, which gives the least latency. A limit of 3 keeps
+/// both busy, which gives the most throughput. Each wait's duration is
+/// recorded, so the cost of a lower limit can be seen.
+///@note Fences are only valid in their own context. Use one instance per
+/// context, from the thread rendering it. SetMaxFramesInFlight may be called
+/// from any thread.
+///@note Fences still pending at exit are left to their context.
+class FrameFenceQueue
+{
+public:
+    enum { MaxFramesInFlight = 3 };
+
+    FrameFenceQueue();
+    virtual ~FrameFenceQueue();
+
+    bool IsSupported() const;
+    void SetMaxFramesInFlight(int frames);
+    int  GetMaxFramesInFlight() const { return m_maxFrames.load(); }
+
+    void WaitForSlot();
+    void OnFrameSubmitted();
+
+    const TimingStats& GetWaitStats() const { return m_waitStats; }
+    void ResetWaitStats() { m_waitStats.Reset(); }
+
+protected:
+    GLsync            m_fences[MaxFramesInFlight]; ///< Ring, oldest at m_head
+    int               m_head;
+    int               m_count;
+    std::atomic<int>  m_maxFrames;
+    TimingStats       m_waitStats; ///< CPU time blocked in WaitForSlot in ms
+
+private: // Disallow copy ctor and assignment operator
+    FrameFenceQueue(const FrameFenceQueue&);
+    FrameFenceQueue& operator=(const FrameFenceQueue&);
+};
+
+#endif //_FRAME_FENCE_QUEUE_H_
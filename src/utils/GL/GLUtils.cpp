@@ -25,3 +25,21 @@ void CheckErrorGL(const char* file, const int line)
         fprintf(stderr, "%s\n", errString);
     }
 }
+
+/// Give up on a fence after this long rather than hang on a lost context.
+static const GLuint64 s_fenceTimeoutNs = 100000000;
+
+bool HasFenceSync()
+{
+    return (GLEW_VERSION_3_2 || GLEW_ARB_sync) ? true : false;
+}
+
+bool WaitAndDeleteFence(GLsync& fence)
+{
+    if (fence == 0)
+        return true;
+    const GLenum result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, s_fenceTimeoutNs);
+    glDeleteSync(fence);
+    fence = 0;
+    return (result == GL_ALREADY_SIGNALED) || (result == GL_CONDITION_SATISFIED);
+}
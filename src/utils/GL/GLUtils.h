@@ -3,6 +3,12 @@
 #ifndef _GL_UTILS_H_
 #define _GL_UTILS_H_
 
+#if defined(_WIN32)
+#include <windows.h>
+#endif
+
+#include <GL/glew.h>
+
 /// Error printing function called by CHECK_GL_ERROR_MACRO(),
 /// which is only defined when _DEBUG is defined.
 void CheckErrorGL(const char* file, const int line);
@@ -14,5 +20,13 @@ void CheckErrorGL(const char* file, const int line);
 #define CHECK_GL_ERROR_MACRO()
 #endif
 
+/// Fence sync is core in GL 3.2.
+bool HasFenceSync();
+
+/// Block until the fence signals, or give up after a timeout rather than hang
+/// on a lost context, then delete it and set it to 0. Does nothing for 0.
+///@return true if the fence signaled
+bool WaitAndDeleteFence(GLsync& fence);
+
 
 #endif // _GL_UTILS_H_
\ No newline at end of file
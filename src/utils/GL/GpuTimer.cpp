@@ -0,0 +1,143 @@
+// GpuTimer.cpp
+
+#ifdef _WIN32
+#  define WINDOWS_LEAN_AND_MEAN
+#  define NOMINMAX
+#  include <windows.h>
+#endif
+
+#include <GL/glew.h>
+#include "GpuTimer.h"
+
+GpuTimer::GpuTimer()
+: m_current(0)
+, m_initialized(false)
+, m_supported(false)
+, m_active(false)
+, m_sampleCount(0)
+, m_sampleIdx(0)
+, m_lastMs(0.0f)
+, m_dropped(0)
+{
+    for (int i=0; i<NumQueries; ++i)
+    {
+        m_queries[i] = 0;
+        m_pending[i] = false;
+    }
+    for (int i=0; i<NumSamples; ++i)
+    {
+        m_samples[i] = 0.0f;
+    }
+}
+
+GpuTimer::~GpuTimer()
+{
+    ///@note The owning context may already be gone at this point; call DestroyGL
+    /// explicitly with the context current to release the query objects.
+}
+
+/// Timer queries are core in GL 3.3; fall back to a no-op without them.
+void GpuTimer::_InitGL()
+{
+    m_initialized = true;
+    m_supported = (GLEW_VERSION_3_3 || GLEW_ARB_timer_query) ? true : false;
+    if (!m_supported)
+        return;
+    glGenQueries(NumQueries, m_queries);
+}
+
+void GpuTimer::DestroyGL()
+{
+    if (m_supported)
+    {
+        glDeleteQueries(NumQueries, m_queries);
+    }
+    for (int i=0; i<NumQueries; ++i)
+    {
+        m_queries[i] = 0;
+        m_pending[i] = false;
+    }
+    m_initialized = false;
+    m_supported = false;
+}
+
+/// Read back any results the driver has made available without blocking.
+void GpuTimer::_CollectResults()
+{
+    for (int i=0; i<NumQueries; ++i)
+    {
+        if (!m_pending[i])
+            continue;
+
+        GLint available = 0;
+        glGetQueryObjectiv(m_queries[i], GL_QUERY_RESULT_AVAILABLE, &available);
+        if (available == 0)
+            continue;
+
+        GLuint64 ns = 0;
+        glGetQueryObjectui64v(m_queries[i], GL_QUERY_RESULT, &ns);
+        m_pending[i] = false;
+        _AddSample((float)((double)ns * 1.0e-6));
+    }
+}
+
+void GpuTimer::_AddSample(float ms)
+{
+    m_lastMs = ms;
+    m_samples[m_sampleIdx] = ms;
+    m_sampleIdx = (m_sampleIdx + 1) % NumSamples;
+    if (m_sampleCount < NumSamples)
+        ++m_sampleCount;
+}
+
+void GpuTimer::Begin()
+{
+    if (!m_initialized)
+        _InitGL();
+    if (!m_supported || m_active)
+        return;
+
+    _CollectResults();
+
+    // If the GPU is more than a frame behind, the result in this slot
+    // has not arrived yet. Re-issuing the query discards it.
+    if (m_pending[m_current])
+        ++m_dropped;
+
+    glBeginQuery(GL_TIME_ELAPSED, m_queries[m_current]);
+    m_active = true;
+}
+
+void GpuTimer::End()
+{
+    if (!m_supported || !m_active)
+        return;
+
+    glEndQuery(GL_TIME_ELAPSED);
+    m_pending[m_current] = true;
+    m_current = (m_current + 1) % NumQueries;
+    m_active = false;
+}
+
+float GpuTimer::GetAverageMs() const
+{
+    if (m_sampleCount == 0)
+        return 0.0f;
+    float sum = 0.0f;
+    for (unsigned int i=0; i<m_sampleCount; ++i)
+    {
+        sum += m_samples[i];
+    }
+    return sum / (float)m_sampleCount;
+}
+
+float GpuTimer::GetMaxMs() const
+{
+    float mx = 0.0f;
+    for (unsigned int i=0; i<m_sampleCount; ++i)
+    {
+        if (m_samples[i] > mx)
+            mx = m_samples[i];
+    }
+    return mx;
+}
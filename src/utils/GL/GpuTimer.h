@@ -0,0 +1,61 @@
+// GpuTimer.h
+
+#ifndef _GPU_TIMER_H_
+#define _GPU_TIMER_H_
+
+#if defined(_WIN32)
+#include <windows.h>
+#endif
+
+#include <GL/glew.h>
+
+///@brief Measures the GPU time taken by one render pass using GL_TIME_ELAPSED queries.
+/// Queries are double-buffered: each Begin/End pair writes to one query object while
+/// the result of the previous frame's query is collected only once the driver reports
+/// it available, so reading results never stalls the pipeline.
+///@note Query objects are not shared between contexts. Each instance is lazily
+/// initialized in the context current at its first Begin() and must only be used there.
+///@note GL_TIME_ELAPSED queries cannot nest; only one GpuTimer may be active at a time.
+class GpuTimer
+{
+public:
+    GpuTimer();
+    virtual ~GpuTimer();
+
+    void Begin();
+    void End();
+    void DestroyGL();
+
+    bool  IsSupported() const { return m_supported; }
+    float GetLastMs() const { return m_lastMs; }
+    float GetAverageMs() const;
+    float GetMaxMs() const;
+    unsigned int GetDroppedCount() const { return m_dropped; }
+
+protected:
+    void _InitGL();
+    void _CollectResults();
+    void _AddSample(float ms);
+
+    enum { NumQueries = 2 };
+    enum { NumSamples = 60 }; ///< Rolling stats window in frames
+
+    GLuint m_queries[NumQueries];
+    bool   m_pending[NumQueries]; ///< Issued, result not yet read back
+    unsigned int m_current;       ///< Index of the query to issue next
+    bool   m_initialized;
+    bool   m_supported;
+    bool   m_active;
+
+    float  m_samples[NumSamples];
+    unsigned int m_sampleCount;
+    unsigned int m_sampleIdx;
+    float  m_lastMs;
+    unsigned int m_dropped; ///< Results overwritten before they became available
+
+private: // Disallow copy ctor and assignment operator
+    GpuTimer(const GpuTimer&);
+    GpuTimer& operator=(const GpuTimer&);
+};
+
+#endif //_GPU_TIMER_H_
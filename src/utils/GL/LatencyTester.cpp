@@ -0,0 +1,131 @@
+// LatencyTester.cpp
+
+#ifdef _WIN32
+#  define WINDOWS_LEAN_AND_MEAN
+#  define NOMINMAX
+#  include <windows.h>
+#endif
+
+#include <GL/glew.h>
+#include "LatencyTester.h"
+#include "Timer.h"
+#include "GLUtils.h"
+
+static const char* s_stageNames[] = {
+    "Sample to inputs",
+    "Sample to view",
+    "Sample to submit",
+    "Sample to swap",
+    "Sample to GPU done",
+};
+
+LatencyTester::LatencyTester()
+: m_enabled(false)
+, m_frameOpen(false)
+, m_sampleNs(0)
+{
+    for (int i=0; i<Stage_Count; ++i)
+    {
+        m_stageNs[i] = 0;
+    }
+}
+
+LatencyTester::~LatencyTester()
+{
+}
+
+const char* LatencyTester::GetStageName(Stage stage)
+{
+    return s_stageNames[stage];
+}
+
+/// A frame already open when disabling still completes; the next BeginFrame
+/// sees the new setting.
+void LatencyTester::SetEnabled(bool enable)
+{
+    m_enabled.store(enable);
+}
+
+void LatencyTester::Reset()
+{
+    for (int i=0; i<Stage_Count; ++i)
+    {
+        m_stats[i].Reset();
+    }
+}
+
+/// Start tracking the frame that consumes the sensor sample taken at sampleNs.
+void LatencyTester::BeginFrame(unsigned long long sampleNs)
+{
+    if (!m_enabled.load())
+    {
+        m_frameOpen = false;
+        return;
+    }
+    m_frameOpen = true;
+    m_sampleNs = sampleNs;
+    for (int i=0; i<Stage_Count; ++i)
+    {
+        m_stageNs[i] = 0;
+    }
+}
+
+void LatencyTester::Mark(Stage stage)
+{
+    if (!m_frameOpen)
+        return;
+    m_stageNs[stage] = HighResClock::NowNanoseconds();
+}
+
+/// For stages timestamped on another thread.
+void LatencyTester::MarkAt(Stage stage, unsigned long long ns)
+{
+    if (!m_frameOpen)
+        return;
+    m_stageNs[stage] = ns;
+}
+
+///@return true if the GPU signaled the fence
+bool LatencyTester::_WaitForGpu()
+{
+    if (!HasFenceSync())
+        return false;
+
+    GLsync fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    if (fence == 0)
+        return false;
+    return WaitAndDeleteFence(fence);
+}
+
+/// Call right after SwapBuffers returns for the window being measured.
+/// Closes out the frame and adds each stage it reached to the distributions.
+void LatencyTester::OnSwapped()
+{
+    if (!m_frameOpen)
+        return;
+    m_frameOpen = false;
+
+    m_stageNs[Stage_Swap] = HighResClock::NowNanoseconds();
+    if (_WaitForGpu())
+    {
+        m_stageNs[Stage_GpuDone] = HighResClock::NowNanoseconds();
+    }
+
+    for (int i=0; i<Stage_Count; ++i)
+    {
+        const unsigned long long t = m_stageNs[i];
+        if (t < m_sampleNs)
+            continue;
+        m_stats[i].AddSample(1.0e-6f * (float)(t - m_sampleNs));
+    }
+}
+
+void LatencyTester::Print(FILE* pFile) const
+{
+    for (int i=0; i<Stage_Count; ++i)
+    {
+        if (m_stats[i].Summarize().total == 0)
+            continue;
+        m_stats[i].Print(pFile, s_stageNames[i]);
+    }
+}
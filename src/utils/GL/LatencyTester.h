@@ -0,0 +1,73 @@
+// LatencyTester.h
+
+#ifndef _LATENCY_TESTER_H_
+#define _LATENCY_TESTER_H_
+
+#if defined(_WIN32)
+#include <windows.h>
+#endif
+
+#include <GL/glew.h>
+#include <stdio.h>
+#include <atomic>
+#include "TimingStats.h"
+
+///@brief Measures motion-to-photon latency through the frame pipeline.
+/// Each frame starts from the acquisition time of the sensor sample it consumed;
+/// the pipeline marks when that sample reached each stage, and every stage's
+/// distance from the sample is collected into its own distribution.
+///
+/// Stages, in order: inputs accumulated, view matrix assembled, draw calls
+/// submitted, SwapBuffers returned, and the GPU finished the frame. The last is
+/// found by waiting on a fence placed after the swap, so while enabled the CPU
+/// cannot run ahead of the GPU; that is the price of an exact number.
+///@note Fences are only valid in their own context. Call OnSwapped with the
+/// swapped window's context current.
+///@note SetEnabled may be called from any thread; everything else belongs to
+/// the thread that renders. Stages reached on another thread are passed in
+/// with MarkAt.
+class LatencyTester
+{
+public:
+    enum Stage
+    {
+        Stage_Inputs,
+        Stage_View,
+        Stage_Submit,
+        Stage_Swap,
+        Stage_GpuDone,
+        Stage_Count
+    };
+
+    LatencyTester();
+    virtual ~LatencyTester();
+
+    void SetEnabled(bool enable);
+    bool IsEnabled() const { return m_enabled.load(); }
+
+    void BeginFrame(unsigned long long sampleNs);
+    void Mark(Stage stage);
+    void MarkAt(Stage stage, unsigned long long ns);
+    void OnSwapped();
+
+    const TimingStats& GetStats(Stage stage) const { return m_stats[stage]; }
+    void Reset();
+    void Print(FILE* pFile) const;
+
+    static const char* GetStageName(Stage stage);
+
+protected:
+    bool _WaitForGpu();
+
+    std::atomic<bool>  m_enabled;
+    bool               m_frameOpen;   ///< BeginFrame called, OnSwapped not yet
+    unsigned long long m_sampleNs;
+    unsigned long long m_stageNs[Stage_Count];
+    TimingStats        m_stats[Stage_Count]; ///< Sample-to-stage latency in ms
+
+private: // Disallow copy ctor and assignment operator
+    LatencyTester(const LatencyTester&);
+    LatencyTester& operator=(const LatencyTester&);
+};
+
+#endif //_LATENCY_TESTER_H_
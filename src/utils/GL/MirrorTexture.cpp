@@ -0,0 +1,153 @@
+// MirrorTexture.cpp
+
+#ifdef _WIN32
+#  define WINDOWS_LEAN_AND_MEAN
+#  define NOMINMAX
+#  include <windows.h>
+#endif
+
+#include <GL/glew.h>
+#include "MirrorTexture.h"
+#include "GLUtils.h"
+
+MirrorTexture::MirrorTexture()
+: m_slots()
+, m_producerFbo(0)
+, m_consumerFbo(0)
+{
+}
+
+MirrorTexture::~MirrorTexture()
+{
+}
+
+bool MirrorTexture::IsSupported() const
+{
+    return HasFenceSync() && GLEW_EXT_framebuffer_blit;
+}
+
+/// Fence everything issued so far. The flush makes sure the fence reaches the
+/// GPU, or a wait for it in another context could never return.
+void MirrorTexture::_ReplaceFence(GLsync& fence)
+{
+    if (fence != 0)
+        glDeleteSync(fence);
+    fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    glFlush();
+}
+
+///@brief Copy the current back buffer into the next mirror texture and hand it
+/// to the consumer. Call after drawing and before SwapBuffers.
+/// The copy is scaled down to fit maxWidth x maxHeight, keeping its aspect ratio.
+void MirrorTexture::Publish(int srcWidth, int srcHeight, int maxWidth, int maxHeight)
+{
+    if (!IsSupported())
+        return;
+
+    int w = srcWidth;
+    int h = srcHeight;
+    if (w > maxWidth)
+    {
+        h = h * maxWidth / w;
+        w = maxWidth;
+    }
+    if (h > maxHeight)
+    {
+        w = w * maxHeight / h;
+        h = maxHeight;
+    }
+    if ((w <= 0) || (h <= 0))
+        return;
+
+    Slot& s = m_slots.GetWriteBuffer();
+    if (s.released != 0)
+    {
+        glWaitSync(s.released, 0, GL_TIMEOUT_IGNORED);
+        glDeleteSync(s.released);
+        s.released = 0;
+    }
+
+    if (s.tex == 0)
+    {
+        glGenTextures(1, &s.tex);
+    }
+    if ((s.w != w) || (s.h != h))
+    {
+        glBindTexture(GL_TEXTURE_2D, s.tex);
+        {
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8,
+                         w, h, 0,
+                         GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+        }
+        glBindTexture(GL_TEXTURE_2D, 0);
+        s.w = w;
+        s.h = h;
+    }
+
+    if (m_producerFbo == 0)
+    {
+        glGenFramebuffersEXT(1, &m_producerFbo);
+    }
+    glBindFramebufferEXT(GL_FRAMEBUFFER_EXT, m_producerFbo);
+    glFramebufferTexture2DEXT(GL_FRAMEBUFFER_EXT, GL_COLOR_ATTACHMENT0_EXT, GL_TEXTURE_2D, s.tex, 0);
+    glBindFramebufferEXT(GL_READ_FRAMEBUFFER_EXT, 0);
+    glReadBuffer(GL_BACK);
+    glBlitFramebufferEXT(
+        0, 0, srcWidth, srcHeight,
+        0, 0, w, h,
+        GL_COLOR_BUFFER_BIT, GL_LINEAR);
+    glBindFramebufferEXT(GL_FRAMEBUFFER_EXT, 0);
+
+    _ReplaceFence(s.written);
+    m_slots.Publish();
+}
+
+///@brief Draw the newest mirror texture into the default framebuffer,
+/// centered and scaled to fit without changing its aspect ratio.
+///@return false if there is nothing to show yet
+bool MirrorTexture::Present(int dstWidth, int dstHeight)
+{
+    if (!IsSupported())
+        return false;
+
+    m_slots.Acquire();
+    Slot& s = m_slots.GetReadBuffer();
+    if ((s.tex == 0) || (s.written == 0))
+        return false;
+
+    glWaitSync(s.written, 0, GL_TIMEOUT_IGNORED);
+
+    if (m_consumerFbo == 0)
+    {
+        glGenFramebuffersEXT(1, &m_consumerFbo);
+    }
+    // Reattach every time: the producer reallocates the texture on resize.
+    glBindFramebufferEXT(GL_FRAMEBUFFER_EXT, m_consumerFbo);
+    glFramebufferTexture2DEXT(GL_FRAMEBUFFER_EXT, GL_COLOR_ATTACHMENT0_EXT, GL_TEXTURE_2D, s.tex, 0);
+    glBindFramebufferEXT(GL_DRAW_FRAMEBUFFER_EXT, 0);
+
+    glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+    glClear(GL_COLOR_BUFFER_BIT);
+
+    int w = dstWidth;
+    int h = s.h * dstWidth / s.w;
+    if (h > dstHeight)
+    {
+        w = s.w * dstHeight / s.h;
+        h = dstHeight;
+    }
+    const int x0 = (dstWidth - w) / 2;
+    const int y0 = (dstHeight - h) / 2;
+    glBlitFramebufferEXT(
+        0, 0, s.w, s.h,
+        x0, y0, x0 + w, y0 + h,
+        GL_COLOR_BUFFER_BIT, GL_LINEAR);
+    glBindFramebufferEXT(GL_FRAMEBUFFER_EXT, 0);
+
+    _ReplaceFence(s.released);
+    return true;
+}
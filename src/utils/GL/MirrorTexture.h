@@ -0,0 +1,64 @@
+// MirrorTexture.h
+
+#ifndef _MIRROR_TEXTURE_H_
+#define _MIRROR_TEXTURE_H_
+
+#if defined(_WIN32)
+#include <windows.h>
+#endif
+
+#include <GL/glew.h>
+#include "TripleBuffer.h"
+
+///@brief Hands finished frames from one GL context to another in the same share
+/// group, e.g. the HMD window's image to the control window, with a copy on
+/// each side instead of a second scene render.
+///
+/// The producer blits its back buffer, downsampled, into one of three shared
+/// textures, which a TripleBuffer passes between the two threads. GL fences
+/// order the GPU work across contexts. Each texture carries a fence set when it
+/// was written, which the consumer waits on before reading. It also carries a
+/// fence set after the consumer's last read, which the producer waits on before
+/// writing the texture again. Both waits are glWaitSync, so they hold up the
+/// GPU queue and never the calling thread.
+///@note Publish and Present must each be called from a single thread, with
+/// that side's context current. Framebuffer objects are not shared, so each
+/// side lazily creates its own in the context of its first call.
+///@note GL objects are left to their contexts at exit, as with OVRkill's.
+class MirrorTexture
+{
+public:
+    MirrorTexture();
+    virtual ~MirrorTexture();
+
+    bool IsSupported() const;
+
+    /// Producer side
+    void Publish(int srcWidth, int srcHeight, int maxWidth, int maxHeight);
+
+    /// Consumer side
+    bool Present(int dstWidth, int dstHeight);
+
+protected:
+    struct Slot
+    {
+        GLuint tex;
+        int    w, h;
+        GLsync written;  ///< Set by the producer after the blit into tex
+        GLsync released; ///< Set by the consumer after its last read of tex
+
+        Slot() : tex(0), w(0), h(0), written(0), released(0) {}
+    };
+
+    static void _ReplaceFence(GLsync& fence);
+
+    TripleBuffer<Slot> m_slots;
+    GLuint m_producerFbo; ///< Only valid in the producer's context
+    GLuint m_consumerFbo; ///< Only valid in the consumer's context
+
+private: // Disallow copy ctor and assignment operator
+    MirrorTexture(const MirrorTexture&);
+    MirrorTexture& operator=(const MirrorTexture&);
+};
+
+#endif //_MIRROR_TEXTURE_H_
@@ -33,6 +33,20 @@ GLint getUniLoc(const GLuint program, const GLchar *name)
     return loc;
 }
 
+/// Point the program's named uniform block at a buffer binding point.
+///@return false if the program has no such block
+bool bindUniformBlock(const GLuint program, const GLchar *name, GLuint binding)
+{
+    const GLuint index = glGetUniformBlockIndex(program, name);
+    if (index == GL_INVALID_INDEX)
+    {
+        printf ("No such uniform block named \"%s\"\n", name);
+        return false;
+    }
+    glUniformBlockBinding(program, index, binding);
+    return true;
+}
+
 // Got this from http://www.lighthouse3d.com/opengl/glsl/index.php?oglinfo
 // it prints out shader info (debugging!)
 void printShaderInfoLog(GLuint obj)
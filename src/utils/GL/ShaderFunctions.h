@@ -4,6 +4,7 @@
 #define _SHADER_FUNCTIONS_H_
 
 GLint getUniLoc(const GLuint program, const GLchar *name);
+bool  bindUniformBlock(const GLuint program, const GLchar *name, GLuint binding);
 void  printShaderInfoLog(GLuint obj);
 void  printProgramInfoLog(GLuint obj);
 
@@ -0,0 +1,127 @@
+// StreamingBuffer.cpp
+
+#ifdef _WIN32
+#  define WINDOWS_LEAN_AND_MEAN
+#  define NOMINMAX
+#  include <windows.h>
+#endif
+
+#include <GL/glew.h>
+#include <stdlib.h>
+#include <string.h>
+#include "StreamingBuffer.h"
+#include "Logger.h"
+
+static const unsigned char s_guardByte = 0xfd;
+
+StreamingBuffer::StreamingBuffer()
+: m_ring()
+, m_used(0)
+, m_flushed(0)
+, m_failed(0)
+, m_guards()
+{
+}
+
+StreamingBuffer::~StreamingBuffer()
+{
+}
+
+bool StreamingBuffer::IsSupported() const
+{
+    return m_ring.IsSupported();
+}
+
+///@brief Create the buffer, with the calling thread's context current.
+///@param regionBytes Most bytes one frame can allocate
+///@return false if the context has no fences
+bool StreamingBuffer::Init(int regionBytes)
+{
+    if (regionBytes <= 0)
+        return false;
+
+    m_used = 0;
+    m_flushed = 0;
+    // Guards are read back from the mapping.
+    return m_ring.Init(GL_ARRAY_BUFFER,
+        ((regionBytes + Alignment - 1) / Alignment) * Alignment,
+        STREAMING_BUFFER_DEBUG != 0);
+}
+
+/// Move to the next region, waiting until the GPU is done with its last use.
+void StreamingBuffer::BeginFrame()
+{
+    m_used = 0;
+    m_flushed = 0;
+    m_failed = 0;
+    m_guards.clear();
+    m_ring.BeginFrame();
+}
+
+///@brief Room for bytes of this frame's data.
+///@param offset Receives the allocation's byte offset in GetBuffer
+///@return Where to write the data, or NULL if the region is full
+void* StreamingBuffer::Allocate(int bytes, GLintptr& offset)
+{
+    offset = 0;
+    char* pRegion = m_ring.GetRegionData();
+    if ((pRegion == NULL) || (bytes <= 0))
+        return NULL;
+
+    const int regionBytes = m_ring.GetRegionBytes();
+    const int guard = STREAMING_BUFFER_DEBUG ? GuardSize : 0;
+    if (m_used + bytes + guard > regionBytes)
+    {
+        ++m_failed;
+#if STREAMING_BUFFER_DEBUG
+        LOG_ERROR("StreamingBuffer: %d byte allocation does not fit, %d of %d used.",
+            bytes, m_used, regionBytes);
+#endif
+        return NULL;
+    }
+
+    const int start = m_used;
+#if STREAMING_BUFFER_DEBUG
+    memset(pRegion + start + bytes, s_guardByte, GuardSize);
+    m_guards.push_back(start + bytes);
+#endif
+    m_used = start + bytes + guard;
+    m_used = ((m_used + Alignment - 1) / Alignment) * Alignment;
+
+    offset = m_ring.GetRegionOffset() + start;
+    return pRegion + start;
+}
+
+/// Call after writing this frame's allocations and before drawing from them.
+void StreamingBuffer::Flush()
+{
+    if (!m_ring.IsInitialized())
+        return;
+
+#if STREAMING_BUFFER_DEBUG
+    _CheckGuards();
+#endif
+
+    m_ring.Upload(m_flushed, m_used);
+    m_flushed = m_used;
+}
+
+/// Report every allocation written past its end since the last check.
+void StreamingBuffer::_CheckGuards()
+{
+    const char* pRegion = m_ring.GetRegionData();
+    for (size_t g=0; g<m_guards.size(); ++g)
+    {
+        const unsigned char* pGuard = (const unsigned char*)(pRegion + m_guards[g]);
+        for (int i=0; i<GuardSize; ++i)
+        {
+            if (pGuard[i] != s_guardByte)
+            {
+                LOG_ERROR("StreamingBuffer: write past the allocation ending at offset %d of the buffer.",
+                    (int)m_ring.GetRegionOffset() + m_guards[g]);
+                break;
+            }
+        }
+    }
+    m_guards.clear();
+}
@@ -0,0 +1,75 @@
+// StreamingBuffer.h
+
+#ifndef _STREAMING_BUFFER_H_
+#define _STREAMING_BUFFER_H_
+
+#if defined(_WIN32)
+#include <windows.h>
+#endif
+
+#include <GL/glew.h>
+#include <vector>
+#include "FencedBufferRing.h"
+
+/// Guard bytes after every allocation, checked at each Flush, to catch
+/// writes past the end of an allocation. On by default in debug builds.
+#ifndef STREAMING_BUFFER_DEBUG
+#  ifdef _DEBUG
+#    define STREAMING_BUFFER_DEBUG 1
+#  else
+#    define STREAMING_BUFFER_DEBUG 0
+#  endif
+#endif
+
+///@brief Dynamic vertex data for one frame, written straight into a vertex
+/// buffer the GPU reads from, without client-side arrays.
+///
+/// Each frame bump-allocates from its region of a FencedBufferRing. Without
+/// persistent mapping Flush uploads everything allocated since the last
+/// Flush with one glBufferSubData.
+///
+/// Frame:
+///     BeginFrame, Allocate and write, Flush,
+///     draw from GetBuffer at the returned offsets, EndFrame.
+///
+/// Allocations that do not fit in what is left of the region fail and are
+/// counted; the region size is fixed at Init.
+///@note Use one instance per context, from the thread rendering it.
+class StreamingBuffer
+{
+public:
+    enum { Alignment = 16 }; ///< Of every allocation's offset
+    enum { GuardSize = 16 };
+
+    StreamingBuffer();
+    virtual ~StreamingBuffer();
+
+    bool IsSupported() const;
+    bool Init(int regionBytes);
+    bool IsPersistent() const { return m_ring.IsPersistent(); }
+    GLuint GetBuffer() const { return m_ring.GetBuffer(); }
+
+    void  BeginFrame();
+    void* Allocate(int bytes, GLintptr& offset);
+    void  Flush();
+    void  EndFrame() { m_ring.EndFrame(); }
+
+    /// This frame so far
+    int GetUsedBytes() const { return m_used; }
+    int GetFailedAllocations() const { return m_failed; }
+
+protected:
+    void  _CheckGuards();
+
+    FencedBufferRing m_ring;
+    int     m_used;       ///< Bytes allocated in the current region
+    int     m_flushed;    ///< Bytes of the current region already uploaded
+    int     m_failed;
+    std::vector<int>  m_guards;  ///< Region offsets of guard bytes not yet checked
+
+private: // Disallow copy ctor and assignment operator
+    StreamingBuffer(const StreamingBuffer&);
+    StreamingBuffer& operator=(const StreamingBuffer&);
+};
+
+#endif //_STREAMING_BUFFER_H_
@@ -0,0 +1,70 @@
+// UniformRing.cpp
+
+#ifdef _WIN32
+#  define WINDOWS_LEAN_AND_MEAN
+#  define NOMINMAX
+#  include <windows.h>
+#endif
+
+#include <GL/glew.h>
+#include <stdlib.h>
+#include "UniformRing.h"
+
+UniformRing::UniformRing()
+: m_ring()
+, m_blockSize(0)
+, m_blockStride(0)
+, m_blocksPerFrame(0)
+{
+}
+
+UniformRing::~UniformRing()
+{
+}
+
+/// Uniform buffers are core in GL 3.1.
+bool UniformRing::IsSupported() const
+{
+    return m_ring.IsSupported() && (GLEW_VERSION_3_1 || GLEW_ARB_uniform_buffer_object);
+}
+
+///@brief Create the buffer, with the calling thread's context current.
+///@param blockSize Size in bytes of one block, as laid out by std140
+///@return false if the context has no uniform buffers or fences
+bool UniformRing::Init(int blockSize, int blocksPerFrame)
+{
+    if (!IsSupported() || (blockSize <= 0) || (blocksPerFrame <= 0))
+        return false;
+
+    GLint align = 0;
+    glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &align);
+    if (align < 1)
+        align = 256;
+    m_blockSize = blockSize;
+    m_blockStride = ((blockSize + align - 1) / align) * align;
+    m_blocksPerFrame = blocksPerFrame;
+    return m_ring.Init(GL_UNIFORM_BUFFER, m_blocksPerFrame * m_blockStride);
+}
+
+///@return Where to write block i of this frame, or NULL before Init
+void* UniformRing::GetBlock(int i) const
+{
+    char* pRegion = m_ring.GetRegionData();
+    if (pRegion == NULL)
+        return NULL;
+    return pRegion + i * m_blockStride;
+}
+
+/// Call after writing the frame's blocks and before the first BindBlock.
+void UniformRing::Flush()
+{
+    m_ring.Upload(0, m_blocksPerFrame * m_blockStride);
+}
+
+void UniformRing::BindBlock(int i, GLuint binding) const
+{
+    if (!m_ring.IsInitialized())
+        return;
+    glBindBufferRange(GL_UNIFORM_BUFFER, binding, m_ring.GetBuffer(),
+        m_ring.GetRegionOffset() + i * m_blockStride, m_blockSize);
+}
@@ -0,0 +1,53 @@
+// UniformRing.h
+
+#ifndef _UNIFORM_RING_H_
+#define _UNIFORM_RING_H_
+
+#if defined(_WIN32)
+#include <windows.h>
+#endif
+
+#include <GL/glew.h>
+#include "FencedBufferRing.h"
+
+///@brief Per-frame uniform blocks in one uniform buffer, written by the CPU
+/// while the GPU still reads earlier frames' copies.
+///
+/// Each frame's region of the FencedBufferRing holds a fixed number of
+/// blocks, spaced to the uniform buffer offset alignment. With persistent
+/// mapping blocks are written in place; otherwise Flush uploads them all
+/// with one glBufferSubData.
+///
+/// Frame:
+///     BeginFrame, write GetBlock(i) for each block, Flush,
+///     BindBlock before the draws reading each block, EndFrame.
+///
+///@note Use one instance per context, from the thread rendering it.
+class UniformRing
+{
+public:
+    UniformRing();
+    virtual ~UniformRing();
+
+    bool IsSupported() const;
+    bool Init(int blockSize, int blocksPerFrame);
+    bool IsPersistent() const { return m_ring.IsPersistent(); }
+
+    void  BeginFrame() { m_ring.BeginFrame(); }
+    void* GetBlock(int i) const;
+    void  Flush();
+    void  BindBlock(int i, GLuint binding) const;
+    void  EndFrame() { m_ring.EndFrame(); }
+
+protected:
+    FencedBufferRing m_ring;
+    int m_blockSize;
+    int m_blockStride;    ///< blockSize rounded up to the offset alignment
+    int m_blocksPerFrame;
+
+private: // Disallow copy ctor and assignment operator
+    UniformRing(const UniformRing&);
+    UniformRing& operator=(const UniformRing&);
+};
+
+#endif //_UNIFORM_RING_H_
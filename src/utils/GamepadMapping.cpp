@@ -0,0 +1,285 @@
+// GamepadMapping.cpp
+
+#include "GamepadMapping.h"
+#include "Logger.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <math.h>
+
+static const char* s_controlNames[GamepadMapping::Control_Count] = {
+    "lookx",
+    "looky",
+    "movex",
+    "movey",
+    "movez",
+};
+
+/// Used after any file's sections, so every pad gets at least this layout:
+/// left stick looks, right stick moves, the four face buttons strafe and
+/// step, and the shoulder buttons rise and fall.
+static const char* s_defaultMappings =
+    "[*]\n"
+    "deadzone = 0.2\n"
+    "lookx = axis0 * 2\n"
+    "looky = axis1 * -2\n"
+    "movex = axis3 * 2, button0 * -1, button2 * 1\n"
+    "movey = button4 * 1, button5 * 1, button6 * -1, button7 * -1\n"
+    "movez = axis2 * 2, button1 * 1, button3 * -1\n";
+
+/// GLFW passes on whatever case the device reports, which differs between
+/// platforms and drivers.
+static bool ContainsNoCase(const char* haystack, const char* needle)
+{
+    const size_t n = strlen(needle);
+    for (; *haystack != '\0'; ++haystack)
+    {
+        size_t i = 0;
+        while ((i < n) && (haystack[i] != '\0') &&
+            (tolower((unsigned char)haystack[i]) == tolower((unsigned char)needle[i])))
+        {
+            ++i;
+        }
+        if (i == n)
+            return true;
+    }
+    return n == 0;
+}
+
+GamepadMapping::Remap::Remap()
+: deadzone(0.0f)
+{
+    for (int c=0; c<Control_Count; ++c)
+    {
+        for (int i=0; i<MaxSources; ++i)
+        {
+            source[c][i] = ZeroSource;
+            scale[c][i] = 0.0f;
+        }
+    }
+}
+
+GamepadMapping::GamepadMapping()
+: m_sections()
+{
+}
+
+GamepadMapping::~GamepadMapping()
+{
+}
+
+///@return false if the file could not be read
+bool GamepadMapping::LoadFile(const char* filename)
+{
+    FILE* pFile = fopen(filename, "rb");
+    if (pFile == NULL)
+        return false;
+
+    std::string text;
+    char buf[4096];
+    size_t got;
+    while ((got = fread(buf, 1, sizeof(buf), pFile)) > 0)
+    {
+        text.append(buf, got);
+    }
+    fclose(pFile);
+
+    _Parse(text.c_str(), filename);
+    return true;
+}
+
+void GamepadMapping::LoadDefaults()
+{
+    _Parse(s_defaultMappings, "built-in gamepad mappings");
+}
+
+///@param joystickName May be NULL, which only matches "*" sections
+///@return The first matching section, or -1
+int GamepadMapping::FindSection(const char* joystickName, int numAxes, int numButtons) const
+{
+    for (int i=0; i<(int)m_sections.size(); ++i)
+    {
+        const Section& s = m_sections[i];
+        if ((s.numAxes >= 0) && (s.numAxes != numAxes))
+            continue;
+        if ((s.numButtons >= 0) && (s.numButtons != numButtons))
+            continue;
+        if (s.name == "*")
+            return i;
+        if ((joystickName != NULL) && ContainsNoCase(joystickName, s.name.c_str()))
+            return i;
+    }
+    return -1;
+}
+
+void GamepadMapping::Compile(int section, Remap& remap) const
+{
+    remap = Remap();
+    if ((section < 0) || (section >= (int)m_sections.size()))
+        return;
+
+    const Section& s = m_sections[section];
+    remap.deadzone = s.deadzone;
+    for (int c=0; c<Control_Count; ++c)
+    {
+        const std::vector<Binding>& bindings = s.bindings[c];
+        for (int i=0; (i < (int)bindings.size()) && (i < Remap::MaxSources); ++i)
+        {
+            remap.source[c][i] = (unsigned char)bindings[i].source;
+            remap.scale[c][i] = bindings[i].scale;
+        }
+    }
+}
+
+/// Gather each control from its sources. Every control reads all of its slots.
+void GamepadMapping::Apply(const Remap& remap, const JoystickState& pad, float* pControls)
+{
+    float raw[SourceCount];
+    for (int a=0; a<JoystickState::MaxAxes; ++a)
+    {
+        const float v = pad.axes[a];
+        raw[a] = v * (float)(fabs(v) >= remap.deadzone);
+    }
+    for (int b=0; b<JoystickState::MaxButtons; ++b)
+    {
+        raw[FirstButton + b] = (float)pad.buttons[b];
+    }
+    raw[ZeroSource] = 0.0f;
+
+    for (int c=0; c<Control_Count; ++c)
+    {
+        float v = 0.0f;
+        for (int i=0; i<Remap::MaxSources; ++i)
+        {
+            v += raw[remap.source[c][i]] * remap.scale[c][i];
+        }
+        pControls[c] = v;
+    }
+}
+
+void GamepadMapping::_Parse(const char* text, const char* sourceName)
+{
+    int lineNumber = 0;
+    Section* pSection = NULL;
+    const char* p = text;
+    while (*p != '\0')
+    {
+        const char* end = strchr(p, '\n');
+        if (end == NULL)
+            end = p + strlen(p);
+        std::string line(p, end);
+        p = (*end == '\0') ? end : end + 1;
+        ++lineNumber;
+
+        const size_t comment = line.find('#');
+        if (comment != std::string::npos)
+            line.erase(comment);
+        while (!line.empty() && isspace((unsigned char)line[line.size()-1]))
+            line.erase(line.size()-1);
+        size_t first = 0;
+        while ((first < line.size()) && isspace((unsigned char)line[first]))
+            ++first;
+        line.erase(0, first);
+        if (line.empty())
+            continue;
+
+        if (line[0] == '[')
+        {
+            const size_t close = line.find(']');
+            if ((close == std::string::npos) || (close < 2))
+            {
+                LOG_WARNING("%s:%d: bad section header", sourceName, lineNumber);
+                pSection = NULL;
+                continue;
+            }
+            Section s;
+            s.name = line.substr(1, close-1);
+            s.numAxes = -1;
+            s.numButtons = -1;
+            s.deadzone = 0.2f;
+            m_sections.push_back(s);
+            pSection = &m_sections.back();
+            continue;
+        }
+
+        if (pSection == NULL)
+        {
+            LOG_WARNING("%s:%d: setting outside of a section", sourceName, lineNumber);
+            continue;
+        }
+        if (!_ParseLine(line.c_str(), pSection))
+        {
+            LOG_WARNING("%s:%d: could not parse '%s'", sourceName, lineNumber, line.c_str());
+        }
+    }
+}
+
+///@brief One "key = value" line. A control's value is a comma-separated list
+/// of sources, each axisN or buttonN with an optional "* scale".
+bool GamepadMapping::_ParseLine(const char* line, Section* pSection)
+{
+    char key[32];
+    int consumed = 0;
+    if (sscanf(line, " %31[a-z] = %n", key, &consumed) != 1 || (consumed == 0))
+        return false;
+    const char* value = line + consumed;
+
+    if (!strcmp(key, "axes"))
+        return sscanf(value, "%d", &pSection->numAxes) == 1;
+    if (!strcmp(key, "buttons"))
+        return sscanf(value, "%d", &pSection->numButtons) == 1;
+    if (!strcmp(key, "deadzone"))
+        return sscanf(value, "%f", &pSection->deadzone) == 1;
+
+    int control = -1;
+    for (int c=0; c<Control_Count; ++c)
+    {
+        if (!strcmp(key, s_controlNames[c]))
+            control = c;
+    }
+    if (control < 0)
+        return false;
+
+    std::vector<Binding> bindings;
+    const char* p = value;
+    while (*p != '\0')
+    {
+        char kind[16];
+        int index = 0;
+        int n = 0;
+        if (sscanf(p, " %15[a-z]%d%n", kind, &index, &n) != 2)
+            return false;
+        p += n;
+
+        Binding b;
+        b.scale = 1.0f;
+        if (!strcmp(kind, "axis") && (index >= 0) && (index < JoystickState::MaxAxes))
+            b.source = index;
+        else if (!strcmp(kind, "button") && (index >= 0) && (index < JoystickState::MaxButtons))
+            b.source = FirstButton + index;
+        else
+            return false;
+
+        float scale = 0.0f;
+        if (sscanf(p, " * %f%n", &scale, &n) == 1)
+        {
+            b.scale = scale;
+            p += n;
+        }
+        bindings.push_back(b);
+
+        while (isspace((unsigned char)*p))
+            ++p;
+        if (*p == ',')
+            ++p;
+        else if (*p != '\0')
+            return false;
+    }
+    if (bindings.empty() || ((int)bindings.size() > Remap::MaxSources))
+        return false;
+
+    pSection->bindings[control] = bindings;
+    return true;
+}
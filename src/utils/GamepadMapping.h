@@ -0,0 +1,90 @@
+// GamepadMapping.h
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include "JoystickPoller.h"
+
+///@brief Data-driven layouts that turn a joystick's raw axes and buttons into
+/// the viewer's logical controls.
+///
+/// Layouts are sections of a text file; see config/gamepads.cfg for the
+/// format. A pad uses the first section whose name is found in its GLFW name,
+/// ignoring case, and whose axis and button counts match, if the section
+/// specifies them.
+/// When a pad is chosen, its section is compiled into a Remap. A Remap is a
+/// flat table that gives each control a fixed number of (source, scale)
+/// pairs. Unused slots read a constant zero. Apply is a plain gather and
+/// multiply-add with no per-control branching. Adding a controller is an
+/// edit to the file.
+class GamepadMapping
+{
+public:
+    enum Control
+    {
+        Look_X,
+        Look_Y,
+        Move_X,
+        Move_Y,
+        Move_Z,
+        Control_Count
+    };
+
+    /// Raw inputs as Apply lays them out: axes, then buttons, then a zero.
+    enum
+    {
+        FirstButton = JoystickState::MaxAxes,
+        ZeroSource  = JoystickState::MaxAxes + JoystickState::MaxButtons,
+        SourceCount
+    };
+
+    struct Remap
+    {
+        enum { MaxSources = 4 }; ///< Per control
+
+        unsigned char source[Control_Count][MaxSources];
+        float         scale[Control_Count][MaxSources];
+        float         deadzone; ///< Axes closer to center than this read 0
+
+        Remap();
+    };
+
+    GamepadMapping();
+    virtual ~GamepadMapping();
+
+    bool LoadFile(const char* filename);
+    void LoadDefaults();
+    int  GetSectionCount() const { return (int)m_sections.size(); }
+
+    int  FindSection(const char* joystickName, int numAxes, int numButtons) const;
+    void Compile(int section, Remap& remap) const;
+    const char* GetSectionName(int section) const { return m_sections[section].name.c_str(); }
+
+    static void Apply(const Remap& remap, const JoystickState& pad, float* pControls);
+
+protected:
+    struct Binding
+    {
+        int   source;
+        float scale;
+    };
+
+    struct Section
+    {
+        std::string name;       ///< "*" matches any joystick
+        int         numAxes;    ///< -1 for any
+        int         numButtons; ///< -1 for any
+        float       deadzone;
+        std::vector<Binding> bindings[Control_Count];
+    };
+
+    void _Parse(const char* text, const char* sourceName);
+    bool _ParseLine(const char* line, Section* pSection);
+
+    std::vector<Section> m_sections;
+
+private: // Disallow copy ctor and assignment operator
+    GamepadMapping(const GamepadMapping&);
+    GamepadMapping& operator=(const GamepadMapping&);
+};
@@ -0,0 +1,149 @@
+// InputRecorder.cpp
+
+#include "InputRecorder.h"
+#include "Logger.h"
+
+#include <string.h>
+
+struct InputRecordingHeader
+{
+    char         magic[8];   ///< "OGSINREC"
+    unsigned int version;
+    unsigned int frameSize;  ///< sizeof(InputRecorder::Frame), to catch layout changes
+};
+
+static const unsigned int s_inputRecordingVersion = 2;
+
+InputRecorder::InputRecorder()
+: m_pRecordFile(NULL)
+, m_replayFrames()
+, m_replayPos(0)
+, m_replayDt(0.0f)
+, m_replaying(false)
+, m_replayFinished(false)
+{
+}
+
+InputRecorder::~InputRecorder()
+{
+    StopRecording();
+}
+
+bool InputRecorder::StartRecording(const char* filename)
+{
+    StopRecording();
+    m_pRecordFile = fopen(filename, "wb");
+    if (m_pRecordFile == NULL)
+    {
+        LOG_ERROR("Could not open input recording %s for writing.", filename);
+        return false;
+    }
+
+    InputRecordingHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, "OGSINREC", 8);
+    header.version = s_inputRecordingVersion;
+    header.frameSize = sizeof(Frame);
+    fwrite(&header, sizeof(header), 1, m_pRecordFile);
+    return true;
+}
+
+void InputRecorder::StopRecording()
+{
+    if (m_pRecordFile == NULL)
+        return;
+    fclose(m_pRecordFile);
+    m_pRecordFile = NULL;
+}
+
+void InputRecorder::RecordFrame(const Frame& frame)
+{
+    if (m_pRecordFile == NULL)
+        return;
+    fwrite(&frame, sizeof(Frame), 1, m_pRecordFile);
+}
+
+/// Load a whole recording up front so replay does no file I/O mid-run.
+///@param fixedDt Timestep to feed the app for every frame; 0 uses the
+/// recording's mean dt, which keeps the replayed path close to the original.
+bool InputRecorder::StartReplay(const char* filename, float fixedDt)
+{
+    StopReplay();
+
+    FILE* pFile = fopen(filename, "rb");
+    if (pFile == NULL)
+    {
+        LOG_ERROR("Could not open input recording %s.", filename);
+        return false;
+    }
+
+    InputRecordingHeader header;
+    const bool headerOk =
+        (fread(&header, sizeof(header), 1, pFile) == 1) &&
+        (memcmp(header.magic, "OGSINREC", 8) == 0) &&
+        (header.version == s_inputRecordingVersion) &&
+        (header.frameSize == sizeof(Frame));
+    if (!headerOk)
+    {
+        LOG_ERROR("%s is not a compatible input recording.", filename);
+        fclose(pFile);
+        return false;
+    }
+
+    Frame frame;
+    while (fread(&frame, sizeof(Frame), 1, pFile) == 1)
+    {
+        m_replayFrames.push_back(frame);
+    }
+    fclose(pFile);
+
+    if (m_replayFrames.empty())
+    {
+        LOG_ERROR("Input recording %s has no frames.", filename);
+        return false;
+    }
+
+    m_replayDt = fixedDt;
+    if (m_replayDt <= 0.0f)
+    {
+        double sum = 0.0;
+        for (std::vector<Frame>::const_iterator it = m_replayFrames.begin();
+            it != m_replayFrames.end();
+            ++it)
+        {
+            sum += it->dt;
+        }
+        m_replayDt = (float)(sum / (double)m_replayFrames.size());
+    }
+
+    m_replayPos = 0;
+    m_replaying = true;
+    m_replayFinished = false;
+    LOG_INFO("Replaying %u frames from %s at dt=%f", GetReplayLength(), filename, m_replayDt);
+    return true;
+}
+
+void InputRecorder::StopReplay()
+{
+    m_replayFrames.clear();
+    m_replayPos = 0;
+    m_replaying = false;
+}
+
+/// Fetch the next recorded frame. Once the recording is exhausted this keeps
+/// returning the last frame and reports false, so the view holds still.
+bool InputRecorder::NextFrame(Frame& frame)
+{
+    if (!m_replaying || m_replayFrames.empty())
+        return false;
+
+    if (m_replayPos >= m_replayFrames.size())
+    {
+        m_replayFinished = true;
+        frame = m_replayFrames.back();
+        return false;
+    }
+    frame = m_replayFrames[m_replayPos];
+    ++m_replayPos;
+    return true;
+}
@@ -0,0 +1,70 @@
+// InputRecorder.h
+
+#pragma once
+
+#include <stdio.h>
+#include <vector>
+
+///@brief Records everything that drives the viewer's motion each frame -
+/// timestep, device movement vectors, HMD orientation, crouching and the
+/// follow cam's zoom - and plays it back in place of the live devices so
+/// performance runs are repeatable.
+///
+/// A recording is a short header followed by one fixed-size Frame per
+/// timestep; frames are appended as they happen, so a file from a run that
+/// did not exit cleanly is still usable up to its last whole frame.
+///@note Other tweakbar changes, such as Reset Eye Position or the scene
+/// parameters, are not recorded.
+class InputRecorder
+{
+public:
+    enum InputVector
+    {
+        Vec_GamepadMove,
+        Vec_GamepadRotate,
+        Vec_MouseMove,
+        Vec_MouseRotate,
+        Vec_KeyboardMove,
+        Vec_KeyboardRotate,
+        Vec_Count
+    };
+
+    struct Frame
+    {
+        float        dt;
+        float        orientation[4];  ///< HMD sensor quaternion, x y z w
+        unsigned int sensorActive;
+        float        vectors[Vec_Count][3];
+        float        eyeHeight;       ///< Set by crouching or the tweakbar this frame; negative for none
+        float        followCam[3];    ///< Third person camera displacement, zoomed by the mouse wheel
+    };
+
+    InputRecorder();
+    virtual ~InputRecorder();
+
+    bool StartRecording(const char* filename);
+    void StopRecording();
+    bool IsRecording() const { return m_pRecordFile != NULL; }
+    void RecordFrame(const Frame& frame);
+
+    bool StartReplay(const char* filename, float fixedDt=0.0f);
+    void StopReplay();
+    bool IsReplaying() const { return m_replaying; }
+    bool NextFrame(Frame& frame);
+    bool IsReplayFinished() const { return m_replayFinished; }
+    float GetReplayDt() const { return m_replayDt; }
+    unsigned int GetReplayPosition() const { return m_replayPos; }
+    unsigned int GetReplayLength() const { return (unsigned int)m_replayFrames.size(); }
+
+protected:
+    FILE*              m_pRecordFile;
+    std::vector<Frame> m_replayFrames;
+    unsigned int       m_replayPos;
+    float              m_replayDt;  ///< Fixed timestep fed to the app during replay
+    bool               m_replaying;
+    bool               m_replayFinished;
+
+private: // Disallow copy ctor and assignment operator
+    InputRecorder(const InputRecorder&);
+    InputRecorder& operator=(const InputRecorder&);
+};
@@ -0,0 +1,272 @@
+// JobSystem.cpp
+
+#include "JobSystem.h"
+#include "Profiler.h"
+
+#ifdef _WIN32
+#  define JOBS_TLS __declspec(thread)
+#else
+#  define JOBS_TLS __thread
+#endif
+
+/// Which system's worker the calling thread is, if any, and its queue.
+static JOBS_TLS const JobSystem* s_pWorkerSystem = NULL;
+static JOBS_TLS int s_workerQueue = 0;
+
+JobCounter::JobCounter()
+: m_pending(0)
+{
+}
+
+JobCounter::~JobCounter()
+{
+}
+
+
+bool JobSystem::WorkQueue::PushBack(const Job& job)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    if (tail - head == QueueCapacity)
+        return false;
+    jobs[tail % QueueCapacity] = job;
+    ++tail;
+    return true;
+}
+
+bool JobSystem::WorkQueue::PopBack(Job& job)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    if (tail == head)
+        return false;
+    --tail;
+    job = jobs[tail % QueueCapacity];
+    return true;
+}
+
+bool JobSystem::WorkQueue::PopFront(Job& job)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    if (tail == head)
+        return false;
+    job = jobs[head % QueueCapacity];
+    ++head;
+    return true;
+}
+
+
+JobSystem::JobSystem()
+: m_queued(0)
+, m_quit(false)
+{
+    m_queues.push_back(new WorkQueue());
+}
+
+JobSystem::~JobSystem()
+{
+    Stop();
+    delete m_queues[0];
+}
+
+///@brief Replace the workers with workerThreads new ones; 0 runs every job on
+/// the threads that wait for them.
+void JobSystem::Start(int workerThreads)
+{
+    Stop();
+    m_quit.store(false);
+    for (int i=0; i<workerThreads; ++i)
+    {
+        m_queues.push_back(new WorkQueue());
+    }
+    for (int i=0; i<workerThreads; ++i)
+    {
+        m_threads.push_back(std::thread(&JobSystem::_WorkerLoop, this, i+1));
+    }
+}
+
+/// Call with no jobs outstanding; jobs left in the workers' queues are dropped.
+void JobSystem::Stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_sleepMutex);
+        m_quit.store(true);
+    }
+    m_wake.notify_all();
+    for (size_t i=0; i<m_threads.size(); ++i)
+    {
+        m_threads[i].join();
+    }
+    m_threads.clear();
+
+    for (size_t i=1; i<m_queues.size(); ++i)
+    {
+        delete m_queues[i];
+    }
+    m_queues.resize(1);
+}
+
+///@brief Queue one job over [begin, end).
+///@param done Counts this job until it has run
+///@param pAfter If given, the job is held until this counter reaches zero
+void JobSystem::Submit(JobFunc func, void* pData, int begin, int end, JobCounter& done, JobCounter* pAfter)
+{
+    done.m_pending.fetch_add(1);
+    Job job = { func, pData, begin, end, &done };
+
+    if (pAfter != NULL)
+    {
+        std::lock_guard<std::mutex> lock(pAfter->m_mutex);
+        if (pAfter->m_pending.load() != 0)
+        {
+            pAfter->m_continuations.push_back(job);
+            return;
+        }
+    }
+    _Enqueue(job);
+    _WakeWorkers();
+}
+
+///@brief Run func over [begin, end) in chunks of at least grain indices.
+/// Runs inline if there are no workers or the range is one chunk, in which
+/// case done is never incremented.
+void JobSystem::ParallelFor(int begin, int end, int grain, JobFunc func, void* pData, JobCounter& done, JobCounter* pAfter)
+{
+    const int count = end - begin;
+    if (count <= 0)
+        return;
+    if (grain < 1)
+        grain = 1;
+    if ((pAfter == NULL) && (m_threads.empty() || (count <= grain)))
+    {
+        func(pData, begin, end);
+        return;
+    }
+
+    // A few chunks per thread so stealing can even out the load
+    const int maxChunks = 4 * (GetWorkerCount() + 1);
+    int chunk = (count + maxChunks - 1) / maxChunks;
+    if (chunk < grain)
+        chunk = grain;
+
+    for (int b=begin; b<end; b+=chunk)
+    {
+        const int e = (end - b > chunk) ? (b + chunk) : end;
+        done.m_pending.fetch_add(1);
+        Job job = { func, pData, b, e, &done };
+
+        if (pAfter != NULL)
+        {
+            std::lock_guard<std::mutex> lock(pAfter->m_mutex);
+            if (pAfter->m_pending.load() != 0)
+            {
+                pAfter->m_continuations.push_back(job);
+                continue;
+            }
+        }
+        _Enqueue(job);
+    }
+    _WakeWorkers();
+}
+
+///@brief Run queued jobs on the calling thread until counter reaches zero.
+void JobSystem::Wait(JobCounter& counter)
+{
+    PROFILE_ZONE("JobSystem::Wait");
+    const int queueIndex = _GetQueueIndex();
+    while (!counter.IsDone())
+    {
+        if (!_TryRunOne(queueIndex))
+            std::this_thread::yield();
+    }
+    // The last job may still be releasing the counter's continuations.
+    std::lock_guard<std::mutex> lock(counter.m_mutex);
+}
+
+int JobSystem::_GetQueueIndex() const
+{
+    return (s_pWorkerSystem == this) ? s_workerQueue : 0;
+}
+
+/// A full queue runs the job right away rather than lose it.
+void JobSystem::_Enqueue(const Job& job)
+{
+    m_queued.fetch_add(1);
+    if (!m_queues[_GetQueueIndex()]->PushBack(job))
+    {
+        m_queued.fetch_sub(1);
+        _Run(job);
+    }
+}
+
+/// Pop our own newest job, or else steal the oldest from another queue.
+bool JobSystem::_TryRunOne(int queueIndex)
+{
+    Job job;
+    bool found = m_queues[queueIndex]->PopBack(job);
+
+    const int queueCount = (int)m_queues.size();
+    for (int i=1; !found && (i<queueCount); ++i)
+    {
+        found = m_queues[(queueIndex + i) % queueCount]->PopFront(job);
+    }
+    if (!found)
+        return false;
+
+    m_queued.fetch_sub(1);
+    _Run(job);
+    return true;
+}
+
+void JobSystem::_Run(const Job& job)
+{
+    job.func(job.pData, job.begin, job.end);
+    _Finish(*job.pDone);
+}
+
+/// Count down, and queue whatever was waiting for the count to reach zero.
+void JobSystem::_Finish(JobCounter& counter)
+{
+    std::vector<Job> released;
+    {
+        std::lock_guard<std::mutex> lock(counter.m_mutex);
+        if (counter.m_pending.fetch_sub(1) == 1)
+            released.swap(counter.m_continuations);
+    }
+    if (released.empty())
+        return;
+
+    for (size_t i=0; i<released.size(); ++i)
+    {
+        _Enqueue(released[i]);
+    }
+    _WakeWorkers();
+}
+
+/// Taking the lock orders this with a worker's check before it sleeps, so the
+/// wakeup cannot fall between the two.
+void JobSystem::_WakeWorkers()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_sleepMutex);
+    }
+    m_wake.notify_all();
+}
+
+void JobSystem::_WorkerLoop(int queueIndex)
+{
+    s_pWorkerSystem = this;
+    s_workerQueue = queueIndex;
+    PROFILE_THREAD_NAME("Job worker");
+
+    while (!m_quit.load())
+    {
+        if (_TryRunOne(queueIndex))
+            continue;
+
+        std::unique_lock<std::mutex> lock(m_sleepMutex);
+        while ((m_queued.load() <= 0) && !m_quit.load())
+        {
+            m_wake.wait(lock);
+        }
+    }
+    s_pWorkerSystem = NULL;
+}
@@ -0,0 +1,111 @@
+// JobSystem.h
+
+#pragma once
+
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <vector>
+
+/// A job runs func(pData, begin, end) over a range of indices it was given.
+typedef void (*JobFunc)(void* pData, int begin, int end);
+
+class JobCounter;
+
+struct Job
+{
+    JobFunc     func;
+    void*       pData;
+    int         begin;
+    int         end;
+    JobCounter* pDone; ///< Decremented when the job has run
+};
+
+///@brief Counts the jobs of a batch that have not run yet. Jobs can be made
+/// to depend on a counter: they are held until it reaches zero, then queued.
+///@note A counter must outlive its jobs; Wait on it before it goes out of scope.
+class JobCounter
+{
+public:
+    JobCounter();
+    virtual ~JobCounter();
+
+    bool IsDone() const { return m_pending.load() == 0; }
+
+protected:
+    friend class JobSystem;
+
+    std::atomic<int>  m_pending;
+    std::mutex        m_mutex;         ///< Guards m_continuations
+    std::vector<Job>  m_continuations; ///< Jobs waiting for m_pending to reach zero
+
+private: // Disallow copy ctor and assignment operator
+    JobCounter(const JobCounter&);
+    JobCounter& operator=(const JobCounter&);
+};
+
+///@brief A fixed set of worker threads that share jobs by work stealing.
+///
+/// Every worker has its own deque, and so do all other threads together.
+/// A thread pushes the jobs it creates onto the back of its own deque and
+/// pops from the back, so it runs its newest, cache-warm work first. A thread
+/// whose deque is empty steals from the front of another's, taking the
+/// oldest job, which is usually the biggest remaining piece. Idle workers
+/// sleep until jobs are queued. A thread that calls Wait runs jobs until the
+/// counter it waits on reaches zero, so with no workers everything still runs
+/// on the calling thread.
+///
+/// ParallelFor splits a range into chunks of at least grain indices. A range
+/// that fits in one chunk runs inline with no queueing at all, so small
+/// inputs cost the same as a plain loop.
+class JobSystem
+{
+public:
+    enum { QueueCapacity = 4096 };
+
+    JobSystem();
+    virtual ~JobSystem();
+
+    void Start(int workerThreads);
+    void Stop();
+    int  GetWorkerCount() const { return (int)m_threads.size(); }
+
+    void Submit(JobFunc func, void* pData, int begin, int end, JobCounter& done, JobCounter* pAfter=NULL);
+    void ParallelFor(int begin, int end, int grain, JobFunc func, void* pData, JobCounter& done, JobCounter* pAfter=NULL);
+    void Wait(JobCounter& counter);
+
+protected:
+    /// Mutex-guarded ring; the owner works the back, thieves take the front.
+    struct WorkQueue
+    {
+        std::mutex   mutex;
+        unsigned int head; ///< Oldest job
+        unsigned int tail; ///< One past the newest
+        Job          jobs[QueueCapacity];
+
+        WorkQueue() : head(0), tail(0) {}
+        bool PushBack(const Job& job);
+        bool PopBack(Job& job);
+        bool PopFront(Job& job);
+    };
+
+    int  _GetQueueIndex() const;
+    void _Enqueue(const Job& job);
+    bool _TryRunOne(int queueIndex);
+    void _Run(const Job& job);
+    void _Finish(JobCounter& counter);
+    void _WakeWorkers();
+    void _WorkerLoop(int queueIndex);
+
+    std::vector<WorkQueue*>  m_queues; ///< 0 is shared by non-worker threads
+    std::vector<std::thread> m_threads;
+    std::atomic<int>         m_queued; ///< Jobs in all queues, for sleeping
+    std::atomic<bool>        m_quit;
+    std::mutex               m_sleepMutex;
+    std::condition_variable  m_wake;
+
+private: // Disallow copy ctor and assignment operator
+    JobSystem(const JobSystem&);
+    JobSystem& operator=(const JobSystem&);
+};
@@ -0,0 +1,197 @@
+// JoystickPoller.cpp
+
+#include "JoystickPoller.h"
+#include "Timer.h"
+#include "Profiler.h"
+
+#include <GLFW/glfw3.h>
+#include <math.h>
+#include <string.h>
+#include <chrono>
+
+/// Smaller axis movements are noise and not worth an event.
+static const float s_axisNoiseFloor = 1.0f / 512.0f;
+
+/// Polls between presence scans; about 10Hz at the default rate.
+static const unsigned int s_pollsPerScan = 100;
+
+void JoystickState::Clear()
+{
+    present = false;
+    numAxes = 0;
+    numButtons = 0;
+    memset(axes, 0, sizeof(axes));
+    memset(buttons, 0, sizeof(buttons));
+}
+
+void JoystickState::Apply(const JoystickEvent& e)
+{
+    switch (e.type)
+    {
+    default:
+        break;
+
+    case JoystickEvent::Connected:
+        Clear();
+        present = true;
+        numAxes = e.numAxes;
+        numButtons = e.numButtons;
+        break;
+
+    case JoystickEvent::Disconnected:
+        Clear();
+        break;
+
+    case JoystickEvent::Axis:
+        if (e.index < MaxAxes)
+            axes[e.index] = e.value;
+        break;
+
+    case JoystickEvent::Button:
+        if (e.index < MaxButtons)
+            buttons[e.index] = (e.value > 0.5f) ? 1 : 0;
+        break;
+    }
+}
+
+JoystickPoller::JoystickPoller()
+: m_queue()
+, m_running(false)
+, m_dropped(0)
+, m_rateHz(1000.0f)
+, m_thread()
+{
+}
+
+JoystickPoller::~JoystickPoller()
+{
+    Stop();
+}
+
+/// Call after glfwInit.
+void JoystickPoller::Start(float rateHz)
+{
+    if (m_running.load())
+        return;
+    m_rateHz = (rateHz > 0.0f) ? rateHz : 1000.0f;
+    m_running.store(true);
+    m_thread = std::thread(&JoystickPoller::_PollLoop, this);
+}
+
+/// Call before glfwTerminate.
+void JoystickPoller::Stop()
+{
+    if (!m_running.exchange(false))
+        return;
+    m_thread.join();
+}
+
+void JoystickPoller::_PollLoop()
+{
+    PROFILE_THREAD_NAME("joystick poll");
+    const std::chrono::nanoseconds period((long long)(1.0e9 / (double)m_rateHz));
+    std::chrono::steady_clock::time_point next = std::chrono::steady_clock::now();
+    unsigned int polls = 0;
+    while (m_running.load())
+    {
+        const unsigned long long ns = HighResClock::NowNanoseconds();
+        if ((polls++ % s_pollsPerScan) == 0)
+            _ScanPresence(ns);
+        for (int i=0; i<MaxJoysticks; ++i)
+        {
+            if (m_devices[i].present)
+                _PollDevice(i, ns);
+        }
+
+        // Fixed rate, without a burst of catch-up polls after a stall.
+        next += period;
+        const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+        if (next < now)
+            next = now;
+        std::this_thread::sleep_until(next);
+    }
+}
+
+void JoystickPoller::_ScanPresence(unsigned long long ns)
+{
+    for (int i=0; i<MaxJoysticks; ++i)
+    {
+        JoystickState& d = m_devices[i];
+        const bool present = (glfwJoystickPresent(GLFW_JOYSTICK_1 + i) == GL_TRUE);
+        if (present == d.present)
+            continue;
+
+        if (!present)
+        {
+            d.Clear();
+            _Push(ns, JoystickEvent::Disconnected, i, 0, 0.0f);
+            continue;
+        }
+
+        // Everything starts at rest; the first poll reports what is not.
+        int numAxes = 0;
+        int numButtons = 0;
+        glfwGetJoystickAxes(GLFW_JOYSTICK_1 + i, &numAxes);
+        glfwGetJoystickButtons(GLFW_JOYSTICK_1 + i, &numButtons);
+        JoystickEvent e;
+        e.ns = ns;
+        e.type = JoystickEvent::Connected;
+        e.joystick = (unsigned char)i;
+        e.index = 0;
+        e.numAxes = (unsigned char)((numAxes < JoystickState::MaxAxes) ? numAxes : JoystickState::MaxAxes);
+        e.numButtons = (unsigned char)((numButtons < JoystickState::MaxButtons) ? numButtons : JoystickState::MaxButtons);
+        e.value = 0.0f;
+        d.Apply(e);
+        if (!m_queue.Push(e))
+            m_dropped.fetch_add(1);
+    }
+}
+
+/// Each call returns the data and its count together, so one call apiece.
+void JoystickPoller::_PollDevice(int joy, unsigned long long ns)
+{
+    JoystickState& d = m_devices[joy];
+
+    int numAxes = 0;
+    const float* axes = glfwGetJoystickAxes(GLFW_JOYSTICK_1 + joy, &numAxes);
+    if (axes == NULL)
+        numAxes = 0;
+    if (numAxes > d.numAxes)
+        numAxes = d.numAxes;
+    for (int a=0; a<numAxes; ++a)
+    {
+        if (fabs(axes[a] - d.axes[a]) < s_axisNoiseFloor)
+            continue;
+        d.axes[a] = axes[a];
+        _Push(ns, JoystickEvent::Axis, joy, a, axes[a]);
+    }
+
+    int numButtons = 0;
+    const unsigned char* buttons = glfwGetJoystickButtons(GLFW_JOYSTICK_1 + joy, &numButtons);
+    if (buttons == NULL)
+        numButtons = 0;
+    if (numButtons > d.numButtons)
+        numButtons = d.numButtons;
+    for (int b=0; b<numButtons; ++b)
+    {
+        const unsigned char pressed = (buttons[b] == GLFW_PRESS) ? 1 : 0;
+        if (pressed == d.buttons[b])
+            continue;
+        d.buttons[b] = pressed;
+        _Push(ns, JoystickEvent::Button, joy, b, (float)pressed);
+    }
+}
+
+void JoystickPoller::_Push(unsigned long long ns, JoystickEvent::Type type, int joy, int index, float value)
+{
+    JoystickEvent e;
+    e.ns = ns;
+    e.type = (unsigned char)type;
+    e.joystick = (unsigned char)joy;
+    e.index = (unsigned char)index;
+    e.numAxes = 0;
+    e.numButtons = 0;
+    e.value = value;
+    if (!m_queue.Push(e))
+        m_dropped.fetch_add(1);
+}
@@ -0,0 +1,95 @@
+// JoystickPoller.h
+
+#pragma once
+
+#include <atomic>
+#include <thread>
+#include "SpscQueue.h"
+
+///@brief One change in a joystick's state, timestamped when it was polled.
+struct JoystickEvent
+{
+    enum Type
+    {
+        Connected,    ///< index and value unused; numAxes and numButtons are set
+        Disconnected,
+        Axis,         ///< value is the axis position in [-1,1]
+        Button,       ///< value is 1 for pressed, 0 for released
+    };
+
+    unsigned long long ns;
+    unsigned char type;
+    unsigned char joystick;
+    unsigned char index;
+    unsigned char numAxes;
+    unsigned char numButtons;
+    float         value;
+};
+
+///@brief The last known state of one joystick, as the poll thread sees it or as
+/// a consumer rebuilds it from events.
+struct JoystickState
+{
+    enum { MaxAxes = 8 };
+    enum { MaxButtons = 32 };
+
+    bool          present;
+    int           numAxes;
+    int           numButtons;
+    float         axes[MaxAxes];
+    unsigned char buttons[MaxButtons]; ///< 1 while pressed
+
+    JoystickState() { Clear(); }
+    void Clear();
+    void Apply(const JoystickEvent& e);
+};
+
+///@brief Polls every joystick on its own thread at a fixed rate and queues
+/// only the changes: connects and disconnects, each axis that moved by more
+/// than its noise floor, and each button that changed. The thread that
+/// consumes them pops events in time order and can replay motion between its
+/// own updates, instead of seeing one sample per frame.
+///
+/// Presence is rescanned a few times a second, so pads plugged in later are
+/// picked up and unplugged ones are reported as gone. The first scan reports
+/// every pad already connected.
+///@note GLFW 3.0's joystick functions only read device state and do not touch
+/// windows, so they are polled from this thread. Later GLFW versions require
+/// the main thread. GLFW 3.0 on Linux also only opens devices at glfwInit, so
+/// a hot-plugged pad there is not seen until the next run.
+///@note If the consumer falls behind and the queue fills, new events are
+/// dropped and counted, and the consumer's copy of the state can go stale.
+class JoystickPoller
+{
+public:
+    enum { MaxJoysticks = 16 };
+    enum { QueueSize = 4096 };
+
+    JoystickPoller();
+    virtual ~JoystickPoller();
+
+    void Start(float rateHz=1000.0f);
+    void Stop();
+    bool IsRunning() const { return m_running.load(); }
+
+    /// Consumer side
+    bool PopEvent(JoystickEvent& e) { return m_queue.Pop(e); }
+    unsigned int GetDroppedCount() const { return m_dropped.load(); }
+
+protected:
+    void _PollLoop();
+    void _ScanPresence(unsigned long long ns);
+    void _PollDevice(int joy, unsigned long long ns);
+    void _Push(unsigned long long ns, JoystickEvent::Type type, int joy, int index, float value);
+
+    JoystickState m_devices[MaxJoysticks]; ///< Poll thread only
+    SpscQueue<JoystickEvent, QueueSize> m_queue;
+    std::atomic<bool>         m_running;
+    std::atomic<unsigned int> m_dropped;
+    float         m_rateHz;
+    std::thread   m_thread;
+
+private: // Disallow copy ctor and assignment operator
+    JoystickPoller(const JoystickPoller&);
+    JoystickPoller& operator=(const JoystickPoller&);
+};
@@ -1,40 +1,170 @@
 // Logger.cpp
 
 #include "Logger.h"
+#include "Timer.h"
 #include <stdarg.h>
+#include <stdio.h>
 #include <time.h>
+#include <string>
+#include <chrono>
+
+static const char* s_levelNames[] = {
+    "DEBUG",
+    "INFO",
+    "WARNING",
+    "ERROR",
+};
 
 /// Default constructor: called the first time Instance() is called.
-/// Open the output file.
+/// Open the output file and start the writer thread.
 Logger::Logger()
+: m_enqueuePos(0)
+, m_dequeuePos(0)
+, m_dropped(0)
+, m_droppedReported(0)
+, m_startNs(HighResClock::NowNanoseconds())
+, m_startTime((long long)time(0))
+, m_flushRequests(0)
+, m_flushesDone(0)
+, m_quit(false)
 {
+    for (unsigned int i=0; i<RingSize; ++i)
+    {
+        m_ring[i].sequence.store(i, std::memory_order_relaxed);
+    }
     m_stream.open("log.txt");
+    m_writer = std::thread(&Logger::_WriterLoop, this);
 }
 
-/// Flush and close the output file.
+/// Write out anything still queued, then close the output file.
 Logger::~Logger()
 {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_quit = true;
+    }
+    m_cond.notify_all();
+    m_writer.join();
     m_stream.close();
 }
 
 /// Write a message to the log's output stream.
+/// Claims a slot in the ring, formats the message into it and publishes it.
+/// Never waits on the writer thread or on I/O.
+///@param level One of the LOG_LEVEL_ values
 ///@param format The string to write to the log.
-void Logger::Write(char* format, ...)
+void Logger::Write(int level, const char* format, ...)
 {
-    const unsigned int bufSz = 1024;
-    char buffer[bufSz];
+    unsigned int pos = m_enqueuePos.load(std::memory_order_relaxed);
+    Record* pRec = NULL;
+    for (;;)
+    {
+        pRec = &m_ring[pos & (RingSize-1)];
+        const unsigned int seq = pRec->sequence.load(std::memory_order_acquire);
+        const int dif = (int)(seq - pos);
+        if (dif == 0)
+        {
+            if (m_enqueuePos.compare_exchange_weak(pos, pos+1, std::memory_order_relaxed))
+                break;
+        }
+        else if (dif < 0)
+        {
+            // Ring is full: the writer has fallen behind.
+            m_dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        else
+        {
+            pos = m_enqueuePos.load(std::memory_order_relaxed);
+        }
+    }
+
+    pRec->level = level;
+    pRec->timestampNs = HighResClock::NowNanoseconds();
 
     va_list args;
     va_start(args, format);
-    vsnprintf(buffer, bufSz, format, args);
+    vsnprintf(pRec->message, MessageSize, format, args);
     va_end(args);
 
-    // Prefix entry by timestamp
-    char timestamp[128];
-    struct tm* tm;
-    time_t t = time(0);
-    tm = gmtime(&t);
-    strftime(timestamp, sizeof(timestamp), "%Y %b %d %H:%M:%S - ", tm);
+    pRec->sequence.store(pos + 1, std::memory_order_release);
+}
+
+/// Block until everything logged before this call has been written out.
+void Logger::Flush()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    const unsigned int req = m_flushRequests.fetch_add(1) + 1;
+    m_cond.notify_all();
+    while (((int)(m_flushesDone - req) < 0) && !m_quit)
+        m_cond.wait(lock);
+}
+
+/// Format and write every record published so far.
+///@return true if anything was written
+bool Logger::_WriteBatch()
+{
+    std::string batch;
+    for (;;)
+    {
+        Record& rec = m_ring[m_dequeuePos & (RingSize-1)];
+        const unsigned int seq = rec.sequence.load(std::memory_order_acquire);
+        if (seq != m_dequeuePos + 1)
+            break;
+
+        // Prefix entry by timestamp
+        char timestamp[128];
+        const unsigned long long sinceStartNs = rec.timestampNs - m_startNs;
+        time_t t = (time_t)(m_startTime + (long long)(sinceStartNs / 1000000000ULL));
+        struct tm* tm = gmtime(&t);
+        const size_t len = strftime(timestamp, sizeof(timestamp), "%Y %b %d %H:%M:%S", tm);
+        snprintf(timestamp + len, sizeof(timestamp) - len, ".%03u - %s: ",
+            (unsigned int)((sinceStartNs / 1000000ULL) % 1000ULL),
+            s_levelNames[(rec.level >= LOG_LEVEL_DEBUG) && (rec.level <= LOG_LEVEL_ERROR) ? rec.level : LOG_LEVEL_ERROR]);
+
+        batch += timestamp;
+        batch += rec.message;
+        batch += '\n';
+
+        rec.sequence.store(m_dequeuePos + RingSize, std::memory_order_release);
+        ++m_dequeuePos;
+    }
+
+    const unsigned int dropped = m_dropped.load(std::memory_order_relaxed);
+    if (dropped != m_droppedReported)
+    {
+        char note[64];
+        snprintf(note, sizeof(note), "(%u log messages dropped)\n", dropped - m_droppedReported);
+        batch += note;
+        m_droppedReported = dropped;
+    }
+
+    if (batch.empty())
+        return false;
+    m_stream.write(batch.c_str(), (std::streamsize)batch.length());
+    m_stream.flush();
+    return true;
+}
+
+/// Background thread: wake periodically, or when asked to flush, and drain the ring.
+void Logger::_WriterLoop()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    for (;;)
+    {
+        const unsigned int flushReq = m_flushRequests.load();
+        const bool quit = m_quit;
+        lock.unlock();
+        while (_WriteBatch())
+        {
+        }
+        lock.lock();
+
+        m_flushesDone = flushReq;
+        m_cond.notify_all();
+        if (quit)
+            return;
 
-    m_stream << timestamp << buffer << std::endl;
+        m_cond.wait_for(lock, std::chrono::milliseconds(10));
+    }
 }
@@ -4,30 +4,68 @@
 #define _LOGGER_H_
 
 #include <fstream>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
 
-#ifdef _DEBUG
-#define LOGGING_ENABLED
+#define LOG_LEVEL_DEBUG   0
+#define LOG_LEVEL_INFO    1
+#define LOG_LEVEL_WARNING 2
+#define LOG_LEVEL_ERROR   3
+#define LOG_LEVEL_NONE    4
+
+/// Messages below LOG_MIN_LEVEL compile to nothing, arguments included.
+#ifndef LOG_MIN_LEVEL
+#  ifdef _DEBUG
+#    define LOG_MIN_LEVEL LOG_LEVEL_DEBUG
+#  else
+#    define LOG_MIN_LEVEL LOG_LEVEL_WARNING
+#  endif
 #endif
 
-#ifdef LOGGING_ENABLED
+#ifdef _WIN32
+#  define LOG_AT_LEVEL(level, string, ...) Logger::Instance().Write(level, string , __VA_ARGS__)
+#endif
 
-#  ifdef _WIN32
-#  define LOG_INFO(string, ...) Logger::Instance().Write(string , __VA_ARGS__)
-#  endif
+#ifdef _LINUX
+#  define LOG_AT_LEVEL(level, string, args...) Logger::Instance().Write(level, string, ## args)
+#endif
 
-#  ifdef _LINUX
-#  define LOG_INFO(string, args...) Logger::Instance().Write(string, ## args)
-#  endif
+#if LOG_MIN_LEVEL <= LOG_LEVEL_DEBUG
+#  define LOG_DEBUG(...) LOG_AT_LEVEL(LOG_LEVEL_DEBUG, __VA_ARGS__)
+#else
+#  define LOG_DEBUG(...)
+#endif
+
+#if LOG_MIN_LEVEL <= LOG_LEVEL_INFO
+#  define LOG_INFO(...) LOG_AT_LEVEL(LOG_LEVEL_INFO, __VA_ARGS__)
+#else
+#  define LOG_INFO(...)
+#endif
 
+#if LOG_MIN_LEVEL <= LOG_LEVEL_WARNING
+#  define LOG_WARNING(...) LOG_AT_LEVEL(LOG_LEVEL_WARNING, __VA_ARGS__)
 #else
-#define LOG_INFO(string, ...)
+#  define LOG_WARNING(...)
+#endif
+
+#if LOG_MIN_LEVEL <= LOG_LEVEL_ERROR
+#  define LOG_ERROR(...) LOG_AT_LEVEL(LOG_LEVEL_ERROR, __VA_ARGS__)
+#else
+#  define LOG_ERROR(...)
 #endif
 
 /// Writes log messages to output stream.
+/// Callers only format their message into a fixed-size record in a lock-free
+/// ring; a background thread timestamps, formats and writes records in batches.
+/// When the ring is full messages are dropped and counted rather than blocking.
 class Logger
 {
 public:
-    void Write(char*, ...);
+    void Write(int level, const char*, ...);
+    void Flush();
+    unsigned int GetDroppedCount() const { return m_dropped.load(std::memory_order_relaxed); }
 
     static Logger& Instance()
     {
@@ -41,7 +79,36 @@ private:
     Logger& operator = (const Logger&); ///< disallow assignment operator
     virtual ~Logger();
 
+    enum { RingSize = 1024 }; ///< Must be a power of 2
+    enum { MessageSize = 240 };
+
+    struct Record
+    {
+        std::atomic<unsigned int> sequence; ///< Vyukov bounded queue cell state
+        int                level;
+        unsigned long long timestampNs;
+        char               message[MessageSize];
+    };
+
+    bool _WriteBatch();
+    void _WriterLoop();
+
+    Record                    m_ring[RingSize];
+    std::atomic<unsigned int> m_enqueuePos;
+    unsigned int              m_dequeuePos; ///< Only touched by the writer thread
+    std::atomic<unsigned int> m_dropped;
+    unsigned int              m_droppedReported;
+
     std::ofstream  m_stream;
+    unsigned long long m_startNs;   ///< Clock reading at m_startTime
+    long long          m_startTime; ///< time(0) at construction
+
+    std::mutex                m_mutex;
+    std::condition_variable   m_cond;
+    std::atomic<unsigned int> m_flushRequests;
+    unsigned int              m_flushesDone; ///< Guarded by m_mutex
+    bool                      m_quit;        ///< Guarded by m_mutex
+    std::thread               m_writer;
 };
 
 #endif //_LOGGER_H_
@@ -0,0 +1,216 @@
+// Profiler.cpp
+
+#include "Profiler.h"
+
+#include <string.h>
+
+#ifdef _WIN32
+#  define PROFILER_TLS __declspec(thread)
+#else
+#  define PROFILER_TLS __thread
+#endif
+
+/// The calling thread's buffer; registered with the profiler on first use.
+static PROFILER_TLS void* s_pThreadBuffer = NULL;
+
+Profiler::Profiler()
+: m_recording(false)
+, m_generation(0)
+, m_baseNs(0)
+, m_quit(false)
+, m_pFile(NULL)
+, m_firstEvent(true)
+{
+}
+
+Profiler::~Profiler()
+{
+    Stop();
+    for (std::vector<ThreadBuffer*>::iterator it = m_threads.begin();
+        it != m_threads.end();
+        ++it)
+    {
+        delete (*it)->pChunk;
+        delete *it;
+    }
+}
+
+/// Open the trace file and start the writer thread. Zones begin recording immediately.
+bool Profiler::Start(const char* filename)
+{
+    if (IsRecording())
+        return true;
+
+    m_pFile = fopen(filename, "w");
+    if (m_pFile == NULL)
+        return false;
+    fprintf(m_pFile, "{\"traceEvents\":[\n");
+    m_firstEvent = true;
+
+    m_baseNs = HighResClock::NowNanoseconds();
+    m_quit = false;
+    m_writer = std::thread(&Profiler::_WriterLoop, this);
+
+    // Any chunk left over from a previous session is discarded on its next Record.
+    m_generation.fetch_add(1, std::memory_order_relaxed);
+    m_recording.store(true, std::memory_order_release);
+    return true;
+}
+
+/// Stop recording, flush every thread's partially filled chunk and close the file.
+void Profiler::Stop()
+{
+    if (!IsRecording())
+        return;
+    m_recording.store(false, std::memory_order_release);
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        const unsigned int gen = m_generation.load(std::memory_order_relaxed);
+        for (std::vector<ThreadBuffer*>::iterator it = m_threads.begin();
+            it != m_threads.end();
+            ++it)
+        {
+            ThreadBuffer& tb = **it;
+            const unsigned int n = tb.committed.load(std::memory_order_acquire);
+            if ((tb.generation != gen) || (tb.pChunk == NULL) || (n == 0))
+                continue;
+
+            // The owner may still append past n; copy only what it has committed.
+            Chunk* pCopy = new Chunk;
+            pCopy->tid = tb.tid;
+            pCopy->count = n;
+            memcpy(pCopy->events, tb.pChunk->events, n*sizeof(Event));
+            m_pending.push_back(pCopy);
+        }
+        m_quit = true;
+    }
+    m_cond.notify_one();
+    m_writer.join();
+
+    // Label threads in the viewer.
+    for (std::vector<ThreadBuffer*>::const_iterator it = m_threads.begin();
+        it != m_threads.end();
+        ++it)
+    {
+        const ThreadBuffer& tb = **it;
+        if (tb.name == NULL)
+            continue;
+        fprintf(m_pFile, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"%s\"}}",
+            m_firstEvent ? "" : ",\n", tb.tid, tb.name);
+        m_firstEvent = false;
+    }
+
+    fprintf(m_pFile, "\n]}\n");
+    fclose(m_pFile);
+    m_pFile = NULL;
+}
+
+Profiler::ThreadBuffer* Profiler::_GetThreadBuffer()
+{
+    if (s_pThreadBuffer != NULL)
+        return static_cast<ThreadBuffer*>(s_pThreadBuffer);
+
+    ThreadBuffer* pTb = new ThreadBuffer;
+    pTb->generation = ~0u;
+    pTb->pChunk = NULL;
+    pTb->committed.store(0, std::memory_order_relaxed);
+    pTb->name = NULL;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_threads.push_back(pTb);
+        pTb->tid = (unsigned int)m_threads.size();
+    }
+    s_pThreadBuffer = pTb;
+    return pTb;
+}
+
+void Profiler::SetThreadName(const char* name)
+{
+    ThreadBuffer* pTb = _GetThreadBuffer();
+    std::lock_guard<std::mutex> lock(m_mutex);
+    pTb->name = name;
+}
+
+/// Append one complete event to the calling thread's chunk. Lock-free except
+/// once every ChunkSize events, when the full chunk is handed to the writer.
+void Profiler::Record(const char* name, unsigned long long startNs, unsigned long long endNs)
+{
+    ThreadBuffer* pTb = _GetThreadBuffer();
+
+    const unsigned int gen = m_generation.load(std::memory_order_relaxed);
+    if ((pTb->generation != gen) || (pTb->pChunk == NULL))
+    {
+        if (pTb->pChunk == NULL)
+            pTb->pChunk = new Chunk;
+        pTb->pChunk->tid = pTb->tid;
+        pTb->pChunk->count = 0;
+        pTb->committed.store(0, std::memory_order_release);
+        pTb->generation = gen;
+    }
+
+    Chunk* pChunk = pTb->pChunk;
+    Event& e = pChunk->events[pChunk->count];
+    e.name = name;
+    e.startNs = startNs;
+    e.endNs = endNs;
+    ++pChunk->count;
+    pTb->committed.store(pChunk->count, std::memory_order_release);
+
+    if (pChunk->count == ChunkSize)
+    {
+        Chunk* pFresh = new Chunk;
+        pFresh->tid = pTb->tid;
+        pFresh->count = 0;
+        bool submitted = false;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            pTb->pChunk = pFresh;
+            pTb->committed.store(0, std::memory_order_release);
+            if (IsRecording())
+            {
+                m_pending.push_back(pChunk);
+                submitted = true;
+            }
+        }
+        if (submitted)
+            m_cond.notify_one();
+        else
+            delete pChunk;
+    }
+}
+
+/// Background thread: format and write chunks as they arrive.
+void Profiler::_WriterLoop()
+{
+    for (;;)
+    {
+        Chunk* pChunk = NULL;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            while (m_pending.empty() && !m_quit)
+                m_cond.wait(lock);
+            if (m_pending.empty())
+                return;
+            pChunk = m_pending.front();
+            m_pending.pop_front();
+        }
+        _WriteChunk(*pChunk);
+        delete pChunk;
+    }
+}
+
+void Profiler::_WriteChunk(const Chunk& chunk)
+{
+    for (unsigned int i=0; i<chunk.count; ++i)
+    {
+        const Event& e = chunk.events[i];
+        if (e.startNs < m_baseNs)
+            continue;
+        const double tsUs  = 1.0e-3 * (double)(e.startNs - m_baseNs);
+        const double durUs = 1.0e-3 * (double)(e.endNs - e.startNs);
+        fprintf(m_pFile, "%s{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}",
+            m_firstEvent ? "" : ",\n", e.name, chunk.tid, tsUs, durUs);
+        m_firstEvent = false;
+    }
+}
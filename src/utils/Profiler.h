@@ -0,0 +1,125 @@
+// Profiler.h
+
+#ifndef _PROFILER_H_
+#define _PROFILER_H_
+
+#include <stdio.h>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "Timer.h"
+
+/// Instrumentation compiles to nothing unless USE_PROFILER is defined.
+/// When compiled in but not recording, a zone costs one relaxed atomic load.
+#ifdef USE_PROFILER
+#  define PROFILE_CONCAT_(a, b) a##b
+#  define PROFILE_CONCAT(a, b) PROFILE_CONCAT_(a, b)
+#  define PROFILE_ZONE(name) ProfileZone PROFILE_CONCAT(_profileZone, __LINE__)(name)
+#  define PROFILE_THREAD_NAME(name) Profiler::Instance().SetThreadName(name)
+#else
+#  define PROFILE_ZONE(name)
+#  define PROFILE_THREAD_NAME(name)
+#endif
+
+///@brief Records scoped zones into per-thread buffers with nanosecond timestamps
+/// and writes them to a Chrome trace-event JSON file (chrome://tracing, Perfetto).
+/// Each thread fills fixed-size chunks without locking; full chunks are handed to
+/// a background thread which formats and writes them.
+class Profiler
+{
+public:
+    struct Event
+    {
+        const char*        name; ///< Must be a string literal or otherwise outlive the trace
+        unsigned long long startNs;
+        unsigned long long endNs;
+    };
+
+    static Profiler& Instance()
+    {
+        static Profiler theProfiler;   // Instantiated when this function is called
+        return theProfiler;
+    }
+
+    bool Start(const char* filename);
+    void Stop();
+    bool IsRecording() const { return m_recording.load(std::memory_order_relaxed); }
+
+    void Record(const char* name, unsigned long long startNs, unsigned long long endNs);
+    void SetThreadName(const char* name);
+
+protected:
+    enum { ChunkSize = 4096 };
+
+    struct Chunk
+    {
+        unsigned int tid;
+        unsigned int count;
+        Event events[ChunkSize];
+    };
+
+    /// Owned by one recording thread, registered with the profiler for flushing.
+    struct ThreadBuffer
+    {
+        unsigned int              tid;
+        unsigned int              generation; ///< Recording session this chunk belongs to
+        Chunk*                    pChunk;
+        std::atomic<unsigned int> committed;  ///< Events safe for another thread to read
+        const char*               name;
+    };
+
+    ThreadBuffer* _GetThreadBuffer();
+    void _WriterLoop();
+    void _WriteChunk(const Chunk& chunk);
+
+    std::atomic<bool>         m_recording;
+    std::atomic<unsigned int> m_generation;
+    unsigned long long        m_baseNs;
+
+    std::mutex                 m_mutex; ///< Guards everything below
+    std::condition_variable    m_cond;
+    std::deque<Chunk*>         m_pending;
+    std::vector<ThreadBuffer*> m_threads;
+    std::thread                m_writer;
+    bool                       m_quit;
+    FILE*                      m_pFile;
+    bool                       m_firstEvent;
+
+private:
+    Profiler();                             ///< disallow default constructor
+    Profiler(const Profiler&);              ///< disallow copy constructor
+    Profiler& operator = (const Profiler&); ///< disallow assignment operator
+    virtual ~Profiler();
+};
+
+///@brief RAII zone: records the wall-clock interval of its scope.
+class ProfileZone
+{
+public:
+    explicit ProfileZone(const char* name)
+        : m_name(name)
+        , m_startNs(0)
+    {
+        if (Profiler::Instance().IsRecording())
+            m_startNs = HighResClock::NowNanoseconds();
+    }
+
+    ~ProfileZone()
+    {
+        if (m_startNs != 0)
+            Profiler::Instance().Record(m_name, m_startNs, HighResClock::NowNanoseconds());
+    }
+
+private:
+    ProfileZone(const ProfileZone&);
+    ProfileZone& operator=(const ProfileZone&);
+
+    const char*        m_name;
+    unsigned long long m_startNs;
+};
+
+#endif //_PROFILER_H_
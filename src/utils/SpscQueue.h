@@ -0,0 +1,58 @@
+// SpscQueue.h
+
+#pragma once
+
+#include <atomic>
+
+///@brief Bounded FIFO from one producer thread to one consumer thread, with
+/// no locks. Each index is only ever written by its own side, and the other
+/// side reads it with acquire ordering, so an item is fully written before it
+/// can be popped. A full queue refuses the push rather than block.
+///@note Capacity must be a power of two. The indices count up freely and wrap
+/// at 2^32, which is a multiple of Capacity.
+template <class T, unsigned int Capacity>
+class SpscQueue
+{
+public:
+    SpscQueue()
+    : m_head(0)
+    , m_tail(0)
+    {
+    }
+
+    /// Producer side
+    ///@return false if the queue was full
+    bool Push(const T& item)
+    {
+        const unsigned int tail = m_tail.load(std::memory_order_relaxed);
+        if (tail - m_head.load(std::memory_order_acquire) >= Capacity)
+            return false;
+        m_items[tail & IndexMask] = item;
+        m_tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    /// Consumer side
+    ///@return false if the queue was empty
+    bool Pop(T& item)
+    {
+        const unsigned int head = m_head.load(std::memory_order_relaxed);
+        if (head == m_tail.load(std::memory_order_acquire))
+            return false;
+        item = m_items[head & IndexMask];
+        m_head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+protected:
+    enum { IndexMask = Capacity - 1 };
+    typedef char CapacityCheck[((Capacity & IndexMask) == 0) ? 1 : -1];
+
+    T                         m_items[Capacity];
+    std::atomic<unsigned int> m_head; ///< Next to pop; only the consumer writes it
+    std::atomic<unsigned int> m_tail; ///< Next to push; only the producer writes it
+
+private: // Disallow copy ctor and assignment operator
+    SpscQueue(const SpscQueue&);
+    SpscQueue& operator=(const SpscQueue&);
+};
@@ -1,13 +1,113 @@
 // Timer.cpp
 
+#include "Timer.h"
+#include "TimingStats.h"
+
+#include <stdio.h>
+#include <string.h>
+
 #ifdef _LINUX
+#  include <string>
+#  include <fstream>
+#endif
 
-#include "Timer.h"
+const HighResClock::Calibration& HighResClock::GetCalibration()
+{
+    static const Calibration cal;
+    return cal;
+}
 
-// Linux's g++ 4.6.3 has trouble linking this when it is just inlined in Timer.h.
-///@note This file is #defined to nothing on Windows.
-///@todo There is probably a better way to do this.
+unsigned long long HighResClock::NowNanoseconds()
+{
+    return (unsigned long long)(TicksToSeconds(Now()) * 1.0e9);
+}
+
+#ifdef _WIN32
+
+HighResClock::Calibration::Calibration()
+: useTsc(false)
+, secondsPerTick(0.0)
+{
+    LARGE_INTEGER pf;
+    QueryPerformanceFrequency(&pf);
+    secondsPerTick = 1.0 / (double)pf.QuadPart;
+}
+
+double CpuTimer::now()
+{
+    FILETIME creationTime, exitTime, kernelTime, userTime;
+    GetProcessTimes(GetCurrentProcess(), &creationTime, &exitTime, &kernelTime, &userTime);
+    ULARGE_INTEGER k, u;
+    k.LowPart  = kernelTime.dwLowDateTime;
+    k.HighPart = kernelTime.dwHighDateTime;
+    u.LowPart  = userTime.dwLowDateTime;
+    u.HighPart = userTime.dwHighDateTime;
+    return (double)(k.QuadPart + u.QuadPart) * 1.0e-7; // 100ns units
+}
+
+#endif //_WIN32
+
+
+#ifdef _LINUX
 
+static double MonotonicRawSeconds()
+{
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC_RAW, &ts);
+    return (double)ts.tv_sec + 1.0e-9 * (double)ts.tv_nsec;
+}
+
+/// The TSC is only usable as a wall clock if it ticks at a constant rate
+/// regardless of frequency scaling and keeps ticking in deep C-states.
+static bool TscIsReliable()
+{
+    std::ifstream cpuinfo("/proc/cpuinfo");
+    std::string line;
+    while (std::getline(cpuinfo, line))
+    {
+        if (line.compare(0, 5, "flags") != 0)
+            continue;
+        line += " ";
+        return (line.find(" constant_tsc ") != std::string::npos) &&
+               (line.find(" nonstop_tsc ")  != std::string::npos);
+    }
+    return false;
+}
+
+HighResClock::Calibration::Calibration()
+: useTsc(false)
+, secondsPerTick(1.0e-9) // CLOCK_MONOTONIC_RAW ticks are nanoseconds
+{
+#ifdef TIMER_HAS_TSC
+    if (!TscIsReliable())
+        return;
+
+    // Measure the TSC rate against the raw monotonic clock over a short interval.
+    const double calibrationSeconds = 0.01;
+    const double t0 = MonotonicRawSeconds();
+    const unsigned long long tsc0 = __rdtsc();
+    double t1 = t0;
+    while (t1 - t0 < calibrationSeconds)
+    {
+        t1 = MonotonicRawSeconds();
+    }
+    const unsigned long long tsc1 = __rdtsc();
+    if (tsc1 <= tsc0)
+        return;
+
+    secondsPerTick = (t1 - t0) / (double)(tsc1 - tsc0);
+    useTsc = true;
+#endif
+}
+
+double CpuTimer::now()
+{
+    timespec ts;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return (double)ts.tv_sec + 1.0e-9 * (double)ts.tv_nsec;
+}
+
+// Linux's g++ 4.6.3 has trouble linking this when it is just inlined in Timer.h.
 // http://www.guyrutenberg.com/2007/09/22/profiling-code-using-clock_gettime/
 timespec diff(const timespec& start, const timespec& end)
 {
@@ -22,4 +122,14 @@ timespec diff(const timespec& start, const timespec& end)
 	return temp;
 }
 
-#endif
+#endif // _LINUX
+
+
+ScopedTimer::~ScopedTimer()
+{
+    const double ms = 1000.0 * HighResClock::TicksToSeconds(HighResClock::Now() - start_);
+    if (pAccumulatorMs_ != 0)
+        *pAccumulatorMs_ += ms;
+    if (pStats_ != 0)
+        pStats_->AddSample((float)ms);
+}
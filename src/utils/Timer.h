@@ -10,9 +10,63 @@
 #  define WINDOWS_LEAN_AND_MEAN
 #  define NOMINMAX
 #  include <windows.h>
+#endif //_WIN32
+
+#ifdef _LINUX
+#  include <time.h>
+#  if defined(__x86_64__) || defined(__i386__)
+#    include <x86intrin.h>
+#    define TIMER_HAS_TSC
+#  endif
+#endif // _LINUX
+
+class TimingStats;
+
+///@brief Monotonic wall-clock time source with the highest resolution available.
+/// Windows uses QueryPerformanceCounter. Linux uses CLOCK_MONOTONIC_RAW, which is
+/// immune to NTP slewing, or reads the TSC directly when /proc/cpuinfo reports it
+/// both constant-rate and non-stop, calibrated against CLOCK_MONOTONIC_RAW at startup.
+class HighResClock
+{
+public:
+    typedef unsigned long long Ticks;
+
+    static Ticks  Now();
+    static double TicksToSeconds(Ticks t) { return (double)t * GetCalibration().secondsPerTick; }
+    static unsigned long long NowNanoseconds();
+    static bool   UsingTsc() { return GetCalibration().useTsc; }
+
+protected:
+    struct Calibration
+    {
+        bool   useTsc;
+        double secondsPerTick;
+        Calibration();
+    };
+    /// Function-local static so the clock is usable during static initialization.
+    static const Calibration& GetCalibration();
+};
+
+inline HighResClock::Ticks HighResClock::Now()
+{
+#if defined(_WIN32)
+    LARGE_INTEGER val;
+    QueryPerformanceCounter(&val);
+    return (Ticks)val.QuadPart;
+#else
+#  ifdef TIMER_HAS_TSC
+    if (GetCalibration().useTsc)
+        return __rdtsc();
+#  endif
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC_RAW, &ts);
+    return (Ticks)ts.tv_sec * 1000000000ULL + (Ticks)ts.tv_nsec;
+#endif
+}
+
 
 /// Create a Timer, which will immediately begin counting
-/// up from 0.0 seconds.
+/// up from 0.0 seconds of elapsed wall-clock time.
 /// You can call reset() to make it start over.
 class Timer {
   public:
@@ -21,17 +75,12 @@ class Timer {
     }
     /// reset() makes the timer start over counting from 0.0 seconds.
     void reset() {
-      unsigned __int64 pf;
-      QueryPerformanceFrequency( (LARGE_INTEGER *)&pf );
-      freq_ = 1.0 / (double)pf;
-      QueryPerformanceCounter( (LARGE_INTEGER *)&baseTime_ );
+      baseTime_ = HighResClock::Now();
     }
     /// seconds() returns the number of seconds (to very high resolution)
     /// elapsed since the timer was last created or reset().
     double seconds() const {
-      unsigned __int64 val;
-      QueryPerformanceCounter( (LARGE_INTEGER *)&val );
-      return (val - baseTime_) * freq_;
+      return HighResClock::TicksToSeconds(HighResClock::Now() - baseTime_);
     }
     /// seconds() returns the number of milliseconds (to very high resolution)
     /// elapsed since the timer was last created or reset().
@@ -39,45 +88,54 @@ class Timer {
       return seconds() * 1000.0;
     }
   private:
-    double freq_;
-    unsigned __int64 baseTime_;
+    HighResClock::Ticks baseTime_;
 };
-#endif //_WIN32
 
 
-#ifdef _LINUX
-#include <time.h>
-
-// http://www.guyrutenberg.com/2007/09/22/profiling-code-using-clock_gettime/
-timespec diff(const timespec& start, const timespec& end);
-
-class Timer {
+/// A CpuTimer counts CPU time consumed by all threads of the process, which
+/// does not advance while blocked on vsync, the GPU or I/O.
+/// Use Timer for anything measuring elapsed time.
+class CpuTimer {
   public:
-    Timer() {
+    CpuTimer() {
       reset();
     }
-    /// reset() makes the timer start over counting from 0.0 seconds.
     void reset() {
-      clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &time1_);
+      baseTime_ = now();
     }
-    /// seconds() returns the number of seconds (to very high resolution)
-    /// elapsed since the timer was last created or reset().
     double seconds() const {
-      timespec time2;
-      clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &time2);
-      timespec ts = diff(time1_, time2);
-      double dt = ts.tv_sec + (1.0/1000000000) * ts.tv_nsec;
-      return dt;
+      return now() - baseTime_;
     }
-    /// seconds() returns the number of milliseconds (to very high resolution)
-    /// elapsed since the timer was last created or reset().
     double milliseconds() const {
       return seconds() * 1000.0;
     }
   private:
-    timespec time1_;
+    static double now();
+    double baseTime_;
 };
+
+
+/// Adds the wall-clock time spent in its scope to an accumulator in milliseconds,
+/// or to a TimingStats distribution as one sample.
+class ScopedTimer {
+  public:
+    explicit ScopedTimer(double& accumulatorMs)
+      : pAccumulatorMs_(&accumulatorMs), pStats_(0), start_(HighResClock::Now()) {}
+    explicit ScopedTimer(TimingStats& stats)
+      : pAccumulatorMs_(0), pStats_(&stats), start_(HighResClock::Now()) {}
+    ~ScopedTimer();
+  private:
+    ScopedTimer(const ScopedTimer&);
+    ScopedTimer& operator=(const ScopedTimer&);
+
+    double*             pAccumulatorMs_;
+    TimingStats*        pStats_;
+    HighResClock::Ticks start_;
+};
+
+#ifdef _LINUX
+// http://www.guyrutenberg.com/2007/09/22/profiling-code-using-clock_gettime/
+timespec diff(const timespec& start, const timespec& end);
 #endif // _LINUX
 
 #endif //_TIMER_H_
-
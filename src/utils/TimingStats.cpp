@@ -0,0 +1,130 @@
+// TimingStats.cpp
+
+#include "TimingStats.h"
+
+#include <math.h>
+#include <string.h>
+#include <algorithm>
+#include <vector>
+
+static const float s_smallestBucketMs = 0.125f;
+
+TimingStats::TimingStats()
+: m_writeIdx(0)
+, m_total(0)
+, m_overBudget(0)
+, m_allTimeMax(0.0f)
+, m_budgetMs(1000.0f / 60.0f)
+{
+    Reset();
+}
+
+TimingStats::~TimingStats()
+{
+}
+
+///@note Only call from the thread that adds samples.
+void TimingStats::Reset()
+{
+    for (int i=0; i<RingSize; ++i)
+    {
+        m_ring[i].store(0.0f, std::memory_order_relaxed);
+    }
+    for (int i=0; i<NumBuckets; ++i)
+    {
+        m_buckets[i].store(0, std::memory_order_relaxed);
+    }
+    m_total.store(0, std::memory_order_relaxed);
+    m_overBudget.store(0, std::memory_order_relaxed);
+    m_allTimeMax.store(0.0f, std::memory_order_relaxed);
+    m_writeIdx.store(0, std::memory_order_release);
+}
+
+/// Bucket 0 holds everything under the smallest bound, the last bucket everything
+/// over the largest. In between, each octave is split into BucketsPerOctave.
+int TimingStats::GetBucketIndex(float ms)
+{
+    if (!(ms >= s_smallestBucketMs))
+        return 0;
+    const int idx = 1 + (int)floor(BucketsPerOctave * log(ms / s_smallestBucketMs) / log(2.0));
+    if (idx >= NumBuckets-1)
+        return NumBuckets-1;
+    return idx;
+}
+
+float TimingStats::GetBucketLowerBoundMs(int bucket)
+{
+    if (bucket <= 0)
+        return 0.0f;
+    return s_smallestBucketMs * (float)pow(2.0, (double)(bucket-1) / (double)BucketsPerOctave);
+}
+
+void TimingStats::AddSample(float ms)
+{
+    const unsigned int idx = m_writeIdx.load(std::memory_order_relaxed);
+    m_ring[idx % RingSize].store(ms, std::memory_order_relaxed);
+    m_writeIdx.store(idx + 1, std::memory_order_release);
+
+    m_buckets[GetBucketIndex(ms)].fetch_add(1, std::memory_order_relaxed);
+    m_total.fetch_add(1, std::memory_order_relaxed);
+    if (ms > m_budgetMs)
+        m_overBudget.fetch_add(1, std::memory_order_relaxed);
+    if (ms > m_allTimeMax.load(std::memory_order_relaxed))
+        m_allTimeMax.store(ms, std::memory_order_relaxed);
+}
+
+/// Compute exact percentiles over the samples currently in the ring.
+TimingStats::Summary TimingStats::Summarize() const
+{
+    Summary s;
+    memset(&s, 0, sizeof(Summary));
+
+    const unsigned int written = m_writeIdx.load(std::memory_order_acquire);
+    const unsigned int n = std::min(written, (unsigned int)RingSize);
+    s.total      = m_total.load(std::memory_order_relaxed);
+    s.overBudget = m_overBudget.load(std::memory_order_relaxed);
+    s.allTimeMax = m_allTimeMax.load(std::memory_order_relaxed);
+    s.count      = n;
+    if (n == 0)
+        return s;
+
+    std::vector<float> sorted(n);
+    double sum = 0.0;
+    for (unsigned int i=0; i<n; ++i)
+    {
+        sorted[i] = m_ring[(written - 1 - i) % RingSize].load(std::memory_order_relaxed);
+        sum += sorted[i];
+    }
+    std::sort(sorted.begin(), sorted.end());
+
+    s.mean = (float)(sum / (double)n);
+    s.p50  = sorted[(n-1) * 50 / 100];
+    s.p95  = sorted[(n-1) * 95 / 100];
+    s.p99  = sorted[(n-1) * 99 / 100];
+    s.max  = sorted[n-1];
+    return s;
+}
+
+/// Dump the window summary and the non-empty histogram buckets.
+void TimingStats::Print(FILE* pFile, const char* name) const
+{
+    if (pFile == NULL)
+        return;
+
+    const Summary s = Summarize();
+    fprintf(pFile, "%s: %u samples, %u over %.2f ms budget\n",
+        name, s.total, s.overBudget, m_budgetMs);
+    fprintf(pFile, "  last %u: mean %.3f  p50 %.3f  p95 %.3f  p99 %.3f  max %.3f ms (all-time max %.3f)\n",
+        s.count, s.mean, s.p50, s.p95, s.p99, s.max, s.allTimeMax);
+
+    for (int i=0; i<NumBuckets; ++i)
+    {
+        const unsigned int c = GetBucketCount(i);
+        if (c == 0)
+            continue;
+        if (i == NumBuckets-1)
+            fprintf(pFile, "  >= %8.3f ms: %u\n", GetBucketLowerBoundMs(i), c);
+        else
+            fprintf(pFile, "  %8.3f - %8.3f ms: %u\n", GetBucketLowerBoundMs(i), GetBucketLowerBoundMs(i+1), c);
+    }
+}
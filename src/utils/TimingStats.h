@@ -0,0 +1,64 @@
+// TimingStats.h
+
+#pragma once
+
+#include <stdio.h>
+#include <atomic>
+
+///@brief Collects a distribution of durations in milliseconds.
+/// Recent samples are kept in a ring for exact percentiles over a sliding window,
+/// and every sample since the last Reset is counted in a log-bucketed histogram.
+///@note A single thread may call AddSample while any number of others read.
+/// Writers never block readers: the ring and counters are plain atomics, so a
+/// reader racing the writer at worst sees one sample from the newer frame.
+class TimingStats
+{
+public:
+    enum { RingSize = 1024 };
+
+    /// 4 buckets per octave from 1/8 ms up to 2^13 ms, plus under/overflow.
+    enum { BucketsPerOctave = 4 };
+    enum { NumOctaves = 16 };
+    enum { NumBuckets = BucketsPerOctave*NumOctaves + 2 };
+
+    struct Summary
+    {
+        unsigned int count;    ///< Samples in the window
+        float mean;
+        float p50;
+        float p95;
+        float p99;
+        float max;             ///< Maximum in the window
+        float allTimeMax;
+        unsigned int overBudget;
+        unsigned int total;    ///< Samples since Reset
+    };
+
+    TimingStats();
+    virtual ~TimingStats();
+
+    void AddSample(float ms);
+    void Reset();
+    void SetBudgetMs(float ms) { m_budgetMs = ms; }
+    float GetBudgetMs() const { return m_budgetMs; }
+
+    Summary Summarize() const;
+    unsigned int GetBucketCount(int bucket) const { return m_buckets[bucket].load(std::memory_order_relaxed); }
+    static float GetBucketLowerBoundMs(int bucket);
+    static int   GetBucketIndex(float ms);
+
+    void Print(FILE* pFile, const char* name) const;
+
+protected:
+    std::atomic<float>        m_ring[RingSize];
+    std::atomic<unsigned int> m_writeIdx; ///< Total samples written into the ring
+    std::atomic<unsigned int> m_buckets[NumBuckets];
+    std::atomic<unsigned int> m_total;
+    std::atomic<unsigned int> m_overBudget;
+    std::atomic<float>        m_allTimeMax;
+    float                     m_budgetMs;
+
+private: // Disallow copy ctor and assignment operator
+    TimingStats(const TimingStats&);
+    TimingStats& operator=(const TimingStats&);
+};
@@ -0,0 +1,58 @@
+// TripleBuffer.h
+
+#pragma once
+
+#include <atomic>
+
+///@brief Hands the latest value of T from one producer thread to one consumer
+/// thread without either ever waiting on the other.
+/// The producer fills GetWriteBuffer() and calls Publish(); the consumer calls
+/// Acquire() and reads GetReadBuffer(). Of three slots, one belongs to each side
+/// and the third holds the most recently published value. Publishing swaps the
+/// producer's slot with the middle one; acquiring swaps the consumer's slot with
+/// the middle one if it holds something new. Intermediate values the consumer
+/// was too slow to see are simply overwritten.
+template <class T>
+class TripleBuffer
+{
+public:
+    TripleBuffer()
+    : m_middle(1)
+    , m_back(0)
+    , m_front(2)
+    {
+    }
+
+    /// Producer side
+    T& GetWriteBuffer() { return m_buffers[m_back]; }
+    void Publish()
+    {
+        const unsigned int prev = m_middle.exchange(m_back | FreshBit, std::memory_order_acq_rel);
+        m_back = prev & IndexMask;
+    }
+
+    /// Consumer side
+    ///@return true if a newer value was published since the last Acquire
+    bool Acquire()
+    {
+        if ((m_middle.load(std::memory_order_relaxed) & FreshBit) == 0)
+            return false;
+        const unsigned int prev = m_middle.exchange(m_front, std::memory_order_acq_rel);
+        m_front = prev & IndexMask;
+        return true;
+    }
+    const T& GetReadBuffer() const { return m_buffers[m_front]; }
+    T& GetReadBuffer() { return m_buffers[m_front]; } ///< The consumer owns its slot until the next Acquire
+
+protected:
+    enum { IndexMask = 3, FreshBit = 4 };
+
+    T                         m_buffers[3];
+    std::atomic<unsigned int> m_middle; ///< Slot index, plus FreshBit when unread
+    unsigned int              m_back;   ///< Only touched by the producer
+    unsigned int              m_front;  ///< Only touched by the consumer
+
+private: // Disallow copy ctor and assignment operator
+    TripleBuffer(const TripleBuffer&);
+    TripleBuffer& operator=(const TripleBuffer&);
+};
@@ -0,0 +1,174 @@
+# eventlog_to_csv.py
+#
+# Convert a binary event log written by EventLog (events.bin, or the file given
+# with --eventlog) to one CSV file per record type, and print frame time and
+# pose-to-swap latency statistics.
+#
+# Usage: python eventlog_to_csv.py events.bin [outdir]
+
+from __future__ import print_function
+import sys
+import os
+import struct
+
+HEADER_FORMAT = '<8sIIQQ32x'
+HEADER_SIZE = 64
+RECORD_PREFIX = '<IIQ'
+RECORD_SIZE = 128
+MAGIC = b'OGSEVLOG'
+
+EVENT_FRAME = 1
+EVENT_HEADPOSE = 2
+EVENT_INPUT = 3
+EVENT_PASSTIMINGS = 4
+EVENT_SWAP = 5
+
+INPUT_NAMES = ['gamepadMove', 'gamepadRotate', 'mouseMove', 'mouseRotate', 'keyboardMove']
+
+# Matches OculusAppSkeleton's GpuWindow and GpuPass enums.
+GPU_WINDOWS = ['ctrl', 'hmd']
+GPU_PASSES = ['sceneL', 'sceneR', 'sceneMono', 'present', 'tweakbar']
+
+def readRecords(filename):
+	"""
+	Return (header dict, list of (type, frame, timestampNs, payload bytes)).
+	"""
+	with open(filename, 'rb') as f:
+		data = f.read()
+	if len(data) < HEADER_SIZE:
+		raise ValueError("File too short for a header")
+	magic, version, recordSize, startNs, recordCount = struct.unpack_from(HEADER_FORMAT, data, 0)
+	if magic != MAGIC:
+		raise ValueError("Not an event log (bad magic)")
+	if recordSize != RECORD_SIZE:
+		raise ValueError("Unexpected record size %d" % recordSize)
+
+	# recordCount is 0 if the app did not exit cleanly; scan the whole file and skip empty records.
+	available = (len(data) - HEADER_SIZE) // RECORD_SIZE
+	if recordCount == 0 or recordCount > available:
+		recordCount = available
+
+	records = []
+	for i in range(recordCount):
+		off = HEADER_SIZE + i * RECORD_SIZE
+		rtype, frame, ts = struct.unpack_from(RECORD_PREFIX, data, off)
+		if rtype == 0:
+			continue
+		records.append((rtype, frame, ts, data[off+16 : off+RECORD_SIZE]))
+
+	header = { 'version':version, 'startNs':startNs, 'recordCount':recordCount }
+	return header, records
+
+def percentile(sortedVals, p):
+	if not sortedVals:
+		return 0.0
+	idx = int(p * (len(sortedVals) - 1) + 0.5)
+	return sortedVals[idx]
+
+def printStats(name, vals):
+	if not vals:
+		print("%s: no samples" % name)
+		return
+	s = sorted(vals)
+	mean = sum(s) / len(s)
+	print("%s (ms): n=%d mean=%.3f p50=%.3f p95=%.3f p99=%.3f max=%.3f" %
+		(name, len(s), mean, percentile(s, 0.50), percentile(s, 0.95), percentile(s, 0.99), s[-1]))
+
+def writeCsvs(records, startNs, outPrefix):
+	files = {
+		EVENT_FRAME: (outPrefix + "_frames.csv", "frame,timeMs,dt"),
+		EVENT_HEADPOSE: (outPrefix + "_headpose.csv", "frame,timeMs,qx,qy,qz,qw,px,py,pz,sampleTimeMs"),
+		EVENT_INPUT: (outPrefix + "_input.csv", "frame,timeMs," +
+			",".join([n + c for n in INPUT_NAMES for c in ['X','Y','Z']])),
+		EVENT_PASSTIMINGS: (outPrefix + "_timings.csv", "frame,timeMs,cpuFrameMs," +
+			",".join([w + "_" + p for w in GPU_WINDOWS for p in GPU_PASSES])),
+		EVENT_SWAP: (outPrefix + "_swaps.csv", "frame,timeMs,window"),
+	}
+	streams = {}
+	for t, (fname, columns) in files.items():
+		streams[t] = open(fname, 'w')
+		print(columns, file=streams[t])
+
+	def ms(ns):
+		return (ns - startNs) * 1.0e-6
+
+	for rtype, frame, ts, payload in records:
+		out = streams.get(rtype)
+		if out is None:
+			continue
+		row = [str(frame), "%.6f" % ms(ts)]
+		if rtype == EVENT_FRAME:
+			row.append("%.6f" % struct.unpack_from('<f', payload, 0))
+		elif rtype == EVENT_HEADPOSE:
+			vals = struct.unpack_from('<7fIQ', payload, 0)
+			row += ["%.6f" % v for v in vals[0:7]]
+			row.append("%.6f" % ms(vals[8]))
+		elif rtype == EVENT_INPUT:
+			row += ["%.6f" % v for v in struct.unpack_from('<15f', payload, 0)]
+		elif rtype == EVENT_PASSTIMINGS:
+			cpuMs, count = struct.unpack_from('<fI', payload, 0)
+			row.append("%.4f" % cpuMs)
+			row += ["%.4f" % v for v in struct.unpack_from('<%df' % count, payload, 8)]
+		elif rtype == EVENT_SWAP:
+			row.append(str(struct.unpack_from('<I', payload, 0)[0]))
+		print(",".join(row), file=out)
+
+	for out in streams.values():
+		out.close()
+	return [f for f, c in files.values()]
+
+def computeStats(records):
+	"""
+	Frame, head pose and input records are written by the HMD window's render
+	side, once for each new simulation snapshot it draws, so frame times are
+	deltas between successive frame records: the HMD window's frame times, not
+	the simulation's. Frame numbers are simulation timesteps; the ones never
+	drawn are skipped. Swaps and pass timings carry the number of the snapshot
+	that was drawn. Latency is the time from the head pose sample to the first
+	swap of the HMD window (the highest window index seen) with the same frame
+	number.
+	"""
+	frameTimes = []
+	lastFrameNs = None
+	poseSample = {}
+	latencies = []
+	hmdWindow = 0
+	for rtype, frame, ts, payload in records:
+		if rtype == EVENT_SWAP:
+			hmdWindow = max(hmdWindow, struct.unpack_from('<I', payload, 0)[0])
+
+	for rtype, frame, ts, payload in records:
+		if rtype == EVENT_FRAME:
+			if lastFrameNs is not None:
+				frameTimes.append((ts - lastFrameNs) * 1.0e-6)
+			lastFrameNs = ts
+		elif rtype == EVENT_HEADPOSE:
+			poseSample[frame] = struct.unpack_from('<Q', payload, 32)[0]
+		elif rtype == EVENT_SWAP:
+			window = struct.unpack_from('<I', payload, 0)[0]
+			if window == hmdWindow and frame in poseSample:
+				latencies.append((ts - poseSample.pop(frame)) * 1.0e-6)
+	return frameTimes, latencies
+
+def main(argv):
+	if len(argv) < 2:
+		print("Usage: python %s events.bin [outdir]" % argv[0])
+		return 1
+	filename = argv[1]
+	outDir = argv[2] if len(argv) > 2 else os.path.dirname(os.path.abspath(filename))
+	if not os.path.isdir(outDir):
+		os.makedirs(outDir)
+	outPrefix = os.path.join(outDir, os.path.splitext(os.path.basename(filename))[0])
+
+	header, records = readRecords(filename)
+	print("%s: version %d, %d records" % (filename, header['version'], len(records)))
+	for f in writeCsvs(records, header['startNs'], outPrefix):
+		print("  wrote", f)
+
+	frameTimes, latencies = computeStats(records)
+	printStats("Frame time", frameTimes)
+	printStats("Pose to swap latency", latencies)
+	return 0
+
+if __name__ == '__main__':
+	sys.exit(main(sys.argv))